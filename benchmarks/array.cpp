@@ -0,0 +1,98 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "common.hpp"
+
+#include <AutoDiff/Eigen>
+#include <AutoDiff/Python/Cwise.hpp>
+#include <AutoDiff/Python/Operation.hpp>
+#include <AutoDiff/Python/Variable.hpp>
+
+#include <cmath>   // sqrt
+#include <cstddef> // size_t
+
+namespace {
+
+using Derivative = Eigen::MatrixXd;
+using ScalarVar  = AutoDiff::Python::Variable<double, Derivative>;
+using ScalarOp   = AutoDiff::Python::Operation<double, Derivative>;
+using VectorVar  = AutoDiff::Python::Variable<Eigen::VectorXd, Derivative>;
+using MatrixVar  = AutoDiff::Python::Variable<Eigen::MatrixXd, Derivative>;
+using MatrixOp   = AutoDiff::Python::Operation<Eigen::MatrixXd, Derivative>;
+
+using AutoDiff::Python::CwiseBinaryFunction;
+using AutoDiff::Python::CwiseFunction;
+
+// Python: y = var(exp(-2 * x) * x), loss = var(squared_norm(y))
+class Vector {
+public:
+    static constexpr auto unit = "time/element";
+
+    explicit Vector(std::size_t n)
+        : mX{Eigen::VectorXd::LinSpaced(static_cast<Eigen::Index>(n), 0, 1)}
+        , mY{cwise(
+              cwise(cwise(mX, CwiseFunction::Mul, -2.0), CwiseFunction::Exp),
+              mX, CwiseBinaryFunction::Mul)}
+        , mLoss{ScalarOp{squaredNorm(mY.wrapper())}}
+    {
+    }
+
+    [[nodiscard]] auto source() const -> VectorVar const& { return mX; }
+
+    [[nodiscard]] auto target() const -> ScalarVar const& { return mLoss; }
+
+    [[nodiscard]] auto units() const -> std::size_t
+    {
+        return static_cast<std::size_t>(mX.value().size());
+    }
+
+private:
+    VectorVar mX;
+    VectorVar mY;
+    ScalarVar mLoss;
+};
+
+// Python: B = var(A @ A), C = var(exp(B / m)), loss = var(squared_norm(C))
+// with an m⨉m matrix A of n = m² elements
+class Matrix {
+public:
+    static constexpr auto unit = "time/element";
+
+    explicit Matrix(std::size_t n)
+        : mA{Eigen::MatrixXd::Random(size(n), size(n))}
+        , mB{MatrixOp{mA.wrapper() * mA.wrapper()}}
+        , mC{cwise(
+              cwise(mB, CwiseFunction::Div, static_cast<double>(size(n))),
+              CwiseFunction::Exp)}
+        , mLoss{ScalarOp{squaredNorm(mC.wrapper())}}
+    {
+    }
+
+    [[nodiscard]] auto source() const -> MatrixVar const& { return mA; }
+
+    [[nodiscard]] auto target() const -> ScalarVar const& { return mLoss; }
+
+    [[nodiscard]] auto units() const -> std::size_t
+    {
+        return static_cast<std::size_t>(mA.value().size());
+    }
+
+private:
+    static auto size(std::size_t n) -> Eigen::Index
+    {
+        return static_cast<Eigen::Index>(std::sqrt(static_cast<double>(n)));
+    }
+
+    MatrixVar mA;
+    MatrixVar mB;
+    MatrixVar mC;
+    ScalarVar mLoss;
+};
+
+} // namespace
+
+// forward mode seeds an n⨉n identity tangent
+AUTODIFF_BENCHMARK_GRAPH(Vector, 1'000, 1'000'000)
+AUTODIFF_BENCHMARK_GRAPH(Matrix, 1'000, 1'000'000)
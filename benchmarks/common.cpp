@@ -0,0 +1,36 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "common.hpp"
+
+#include <atomic>
+#include <cstddef> // size_t
+
+namespace {
+
+std::atomic<std::size_t> mallocCount{0};
+
+} // namespace
+
+#ifdef __GLIBC__
+
+// Count the allocations of operator new and Eigen (which calls malloc
+// directly) by interposing malloc. Frees are not counted.
+extern "C" {
+auto __libc_malloc(std::size_t size) noexcept -> void*;
+
+auto malloc(std::size_t size) noexcept -> void*
+{
+    mallocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+}
+
+#endif
+
+auto detail::allocations() -> std::size_t
+{
+    return mallocCount.load(std::memory_order_relaxed);
+}
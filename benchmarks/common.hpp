@@ -0,0 +1,106 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef BENCHMARKS_COMMON_HPP
+#define BENCHMARKS_COMMON_HPP
+
+#include <AutoDiff/Python/Function.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cstddef> // size_t
+#include <utility> // move
+
+namespace detail {
+
+// number of calls to malloc so far (zero if not supported by the platform)
+auto allocations() -> std::size_t;
+
+inline auto createFunction(AutoDiff::AbstractVariable const& target)
+    -> AutoDiff::Python::Function
+{
+    auto targets = AutoDiff::Python::Function::Targets{};
+    targets.obj.insert(target._node());
+    return AutoDiff::Python::Function(
+        AutoDiff::Python::Function::Sources{}, std::move(targets));
+}
+
+// Adds the time per unit (node or element) and the allocations per iteration
+inline void report(benchmark::State& state, char const* unit,
+    std::size_t units, std::size_t allocations)
+{
+    state.counters[unit] = benchmark::Counter(static_cast<double>(units),
+        benchmark::Counter::kIsIterationInvariantRate
+            | benchmark::Counter::kInvert);
+    state.counters["allocs"] = benchmark::Counter(
+        static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+}
+
+} // namespace detail
+
+enum class Sweep { Compile, Evaluate, PushTangent, PullGradient };
+
+// Graph: a graph of variables with (at least) the following members
+// - Graph(n): construct the graph with problem size n
+// - source(): variable to seed in forward mode
+// - target(): variable to seed in reverse mode
+// - units(): number of nodes or elements, for the time per unit
+// - unit: name of the time-per-unit counter
+
+template <typename Graph>
+void construct(benchmark::State& state)
+{
+    auto const n      = static_cast<std::size_t>(state.range(0));
+    auto const before = detail::allocations();
+    auto units        = std::size_t{0};
+    for (auto _ : state) {
+        auto graph = Graph(n);
+        units      = graph.units();
+        benchmark::DoNotOptimize(graph);
+    }
+    detail::report(state, Graph::unit, units, detail::allocations() - before);
+}
+
+template <typename Graph, Sweep sweep>
+void run(benchmark::State& state)
+{
+    auto graph    = Graph(static_cast<std::size_t>(state.range(0)));
+    auto function = detail::createFunction(graph.target());
+    function.compile();
+    function.setRetainCache(state.range(1) != 0);
+
+    // warm-up (allocates the retained buffers)
+    function.evaluate();
+
+    auto const before = detail::allocations();
+    for (auto _ : state) {
+        switch (sweep) {
+        case Sweep::Compile: // full compilation, skipping the version check
+            function.AutoDiff::Function::compile();
+            break;
+        case Sweep::Evaluate: function.evaluate(); break;
+        case Sweep::PushTangent: function.pushTangentAt(graph.source()); break;
+        case Sweep::PullGradient:
+            function.pullGradientAt(graph.target());
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    detail::report(
+        state, Graph::unit, graph.units(), detail::allocations() - before);
+}
+
+// All benchmarks of a graph; sweeps run with and without retained cache
+#define AUTODIFF_BENCHMARK_GRAPH(Graph, forwardMax, max)                       \
+    BENCHMARK(construct<Graph>)->RangeMultiplier(10)->Range(10, max);          \
+    BENCHMARK(run<Graph, Sweep::Compile>)                                      \
+        ->ArgsProduct({benchmark::CreateRange(10, max, 10), {0}});             \
+    BENCHMARK(run<Graph, Sweep::Evaluate>)                                     \
+        ->ArgsProduct({benchmark::CreateRange(10, max, 10), {0, 1}});          \
+    BENCHMARK(run<Graph, Sweep::PushTangent>)                                  \
+        ->ArgsProduct({benchmark::CreateRange(10, forwardMax, 10), {0, 1}});   \
+    BENCHMARK(run<Graph, Sweep::PullGradient>)                                 \
+        ->ArgsProduct({benchmark::CreateRange(10, max, 10), {0, 1}});
+
+#endif // BENCHMARKS_COMMON_HPP
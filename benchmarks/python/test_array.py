@@ -0,0 +1,112 @@
+# Benchmarks of the array module (requires pytest-benchmark)
+#
+#   python -m pytest benchmarks/python --benchmark-only
+import tracemalloc
+
+import numpy as np
+import pytest
+from autodiff.array import Function, var, exp, squared_norm
+
+SIZES = [10, 1_000, 100_000, 1_000_000]
+FORWARD_SIZES = [10, 100, 1_000]  # forward mode seeds an n⨉n tangent
+COMPILE_ROUNDS = 20
+SWEEPS = ["compile", "evaluate", "pull_gradient_at"]
+
+
+def vector(n):
+    x = var(np.linspace(0, 1, n))
+    y = var(exp(-2 * x) * x)
+    loss = var(squared_norm(y))
+    return (x, y, loss), x, loss
+
+
+def matrix(n):
+    m = int(np.sqrt(n))
+    a = var(np.random.rand(m, m))
+    b = var(a @ a)
+    c = var(exp(b / m))
+    loss = var(squared_norm(c))
+    return (a, b, c, loss), a, loss
+
+
+def sweep(function, name, source, target):
+    if name == "evaluate":
+        return function.evaluate
+    if name == "push_tangent_at":
+        return lambda: function.push_tangent_at(source)
+    return lambda: function.pull_gradient_at(target)
+
+
+def report(benchmark, source):
+    units = source().size
+    benchmark.extra_info["ns/element"] = (
+        benchmark.stats.stats.mean * 1e9 / units)
+
+
+def allocations(benchmark, run, function=None):
+    """Stores the memory allocated by one run in extra_info.
+
+    The peak traced by tracemalloc covers Python objects and NumPy arrays.
+    Given a function, the peak of its cache buffers is taken from a profile.
+    """
+    tracemalloc.start()
+    run()
+    benchmark.extra_info["traced_peak_bytes"] = (
+        tracemalloc.get_traced_memory()[1])
+    tracemalloc.stop()
+    if function is not None:
+        function.profile()
+        run()
+        function.profile(False)
+        peaks = function.memory_report()["peak_bytes"]
+        benchmark.extra_info["peak_cache_bytes"] = max(peaks.values(), default=0)
+
+
+def compile_rounds(benchmark, target):
+    """Compiles a new function in each round, since compiling a compiled
+    function returns immediately if its graph has not changed."""
+    benchmark.pedantic(Function.compile,
+                       setup=lambda: ((Function(target),), {}),
+                       rounds=COMPILE_ROUNDS)
+
+
+@pytest.mark.parametrize("graph", [vector, matrix])
+@pytest.mark.parametrize("n", SIZES)
+def test_construction(benchmark, graph, n):
+    _, source, _ = benchmark(graph, n)
+    report(benchmark, source)
+
+
+@pytest.mark.parametrize("graph", [vector, matrix])
+@pytest.mark.parametrize("n", SIZES)
+@pytest.mark.parametrize("name", SWEEPS)
+@pytest.mark.parametrize("retain_cache", [False, True])
+def test_sweep(benchmark, graph, n, name, retain_cache):
+    variables, source, target = graph(n)
+    function = Function(target)
+    function.retain_cache = retain_cache
+    if name == "compile":
+        compile_rounds(benchmark, target)
+        allocations(benchmark, Function(target).compile)
+    else:
+        function.compile()
+        function.evaluate()
+        run = sweep(function, name, source, target)
+        benchmark(run)
+        allocations(benchmark, run, function)
+    report(benchmark, source)
+
+
+@pytest.mark.parametrize("graph", [vector, matrix])
+@pytest.mark.parametrize("n", FORWARD_SIZES)
+@pytest.mark.parametrize("retain_cache", [False, True])
+def test_forward_sweep(benchmark, graph, n, retain_cache):
+    variables, source, target = graph(n)
+    function = Function(target)
+    function.retain_cache = retain_cache
+    function.compile()
+    function.evaluate()
+    run = sweep(function, "push_tangent_at", source, target)
+    benchmark(run)
+    allocations(benchmark, run, function)
+    report(benchmark, source)
@@ -0,0 +1,113 @@
+# Benchmarks of the scalar module (requires pytest-benchmark)
+#
+#   python -m pytest benchmarks/python --benchmark-only
+import tracemalloc
+
+import pytest
+from autodiff.scalar import Function, Tape, TapeFunction, var, sin
+
+SIZES = [10, 100, 1_000, 10_000]
+COMPILE_ROUNDS = 20
+SWEEPS = ["compile", "evaluate", "push_tangent_at", "pull_gradient_at"]
+
+
+def step(x):
+    return var(sin(x) * 0.5 + x)
+
+
+def chain(n):
+    """Deep chain of n + 1 variables."""
+    xs = [var(1.0)]
+    for _ in range(n):
+        xs.append(step(xs[-1]))
+    return xs, xs[0], xs[-1], len(xs)
+
+
+def wide(n):
+    """n independent branches, summed pairwise."""
+    xs = [var(i / n) for i in range(n)]
+    ys = [step(x) for x in xs]
+    nodes = 2 * n
+    while len(ys) > 1:
+        sums = [var(a + b) for a, b in zip(ys[::2], ys[1::2])]
+        nodes += len(sums)
+        ys = sums + ys[len(ys) - len(ys) % 2:]
+    return xs + ys, xs[0], ys[0], nodes
+
+
+def sweep(function, name, source, target):
+    if name == "evaluate":
+        return function.evaluate
+    if name == "push_tangent_at":
+        return lambda: function.push_tangent_at(source)
+    return lambda: function.pull_gradient_at(target)
+
+
+def report(benchmark, units):
+    benchmark.extra_info["ns/node"] = benchmark.stats.stats.mean * 1e9 / units
+
+
+def allocations(benchmark, run, function=None):
+    """Stores the memory allocated by one run in extra_info.
+
+    The peak traced by tracemalloc covers Python objects and NumPy arrays.
+    Given a function, the peak of its cache buffers is taken from a profile.
+    """
+    tracemalloc.start()
+    run()
+    benchmark.extra_info["traced_peak_bytes"] = (
+        tracemalloc.get_traced_memory()[1])
+    tracemalloc.stop()
+    if function is not None:
+        function.profile()
+        run()
+        function.profile(False)
+        peaks = function.memory_report()["peak_bytes"]
+        benchmark.extra_info["peak_cache_bytes"] = max(peaks.values(), default=0)
+
+
+def compile_rounds(benchmark, target):
+    """Compiles a new function in each round, since compiling a compiled
+    function returns immediately if its graph has not changed."""
+    benchmark.pedantic(Function.compile,
+                       setup=lambda: ((Function(target),), {}),
+                       rounds=COMPILE_ROUNDS)
+
+
+@pytest.mark.parametrize("graph", [chain, wide])
+@pytest.mark.parametrize("n", SIZES)
+def test_construction(benchmark, graph, n):
+    _, _, _, nodes = benchmark(graph, n)
+    report(benchmark, nodes)
+
+
+@pytest.mark.parametrize("graph", [chain, wide])
+@pytest.mark.parametrize("n", SIZES)
+@pytest.mark.parametrize("name", SWEEPS)
+def test_sweep(benchmark, graph, n, name):
+    variables, source, target, nodes = graph(n)
+    function = Function(target)
+    if name == "compile":
+        compile_rounds(benchmark, target)
+        allocations(benchmark, Function(target).compile)
+    else:
+        function.compile()
+        function.evaluate()
+        run = sweep(function, name, source, target)
+        benchmark(run)
+        allocations(benchmark, run, function)
+    report(benchmark, nodes)
+
+
+@pytest.mark.parametrize("graph", [chain, wide])
+@pytest.mark.parametrize("n", SIZES)
+@pytest.mark.parametrize("name", SWEEPS[1:])
+def test_tape_sweep(benchmark, graph, n, name):
+    with Tape() as tape:
+        variables, source, target, nodes = graph(n)
+    function = TapeFunction(tape, Function(target, sources=(source,)))
+    function.evaluate()
+    run = sweep(function, name, source, target)
+    benchmark(run)
+    allocations(benchmark, run)
+    report(benchmark, nodes)
@@ -0,0 +1,102 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "common.hpp"
+
+#include <AutoDiff/Basic>
+#include <AutoDiff/Python/Operation.hpp>
+#include <AutoDiff/Python/Variable.hpp>
+
+#include <cstddef> // size_t
+#include <vector>
+
+namespace {
+
+using Var = AutoDiff::Python::Variable<double, double>;
+using Op  = AutoDiff::Python::Operation<double, double>;
+
+// Python: y = var(sin(x) * 0.5 + x), one type-erased node per operation
+auto step(Var const& x) -> Var
+{
+    auto const u = Op{sin(x.wrapper())};
+    auto const v = Op{u.wrapper() * 0.5};
+    auto const w = Op{v.wrapper() + x.wrapper()};
+    return Var{w};
+}
+
+// Deep chain y[i] = step(y[i-1]) of n + 1 variables
+class Chain {
+public:
+    static constexpr auto unit = "time/node";
+
+    explicit Chain(std::size_t n)
+    {
+        mVariables.reserve(n + 1);
+        mVariables.emplace_back(1.0);
+        for (auto i = std::size_t{0}; i < n; ++i) {
+            mVariables.push_back(step(mVariables.back()));
+        }
+    }
+
+    [[nodiscard]] auto source() const -> Var const& { return mVariables.front(); }
+
+    [[nodiscard]] auto target() const -> Var const& { return mVariables.back(); }
+
+    [[nodiscard]] auto units() const -> std::size_t { return mVariables.size(); }
+
+private:
+    std::vector<Var> mVariables;
+};
+
+// Wide graph of n independent branches step(x[i]), summed pairwise
+class Wide {
+public:
+    static constexpr auto unit = "time/node";
+
+    explicit Wide(std::size_t n)
+    {
+        mVariables.reserve(3 * n);
+        for (auto i = std::size_t{0}; i < n; ++i) {
+            mVariables.emplace_back(static_cast<double>(i) / n); // sources
+        }
+        for (auto i = std::size_t{0}; i < n; ++i) {
+            mVariables.push_back(step(mVariables[i])); // branches
+        }
+        // binary tree of sums over the branches
+        for (auto begin = n; mVariables.size() - begin > 1;) {
+            auto const end = mVariables.size();
+            for (auto i = begin; i + 1 < end; i += 2) {
+                auto const sum = Op{
+                    mVariables[i].wrapper() + mVariables[i + 1].wrapper()};
+                mVariables.emplace_back(sum);
+            }
+            if ((end - begin) % 2 == 1) {
+                mVariables.push_back(mVariables[end - 1]); // carry over
+                ++mRepeated;
+            }
+            begin = end;
+        }
+    }
+
+    [[nodiscard]] auto source() const -> Var const& { return mVariables.front(); }
+
+    [[nodiscard]] auto target() const -> Var const& { return mVariables.back(); }
+
+    [[nodiscard]] auto units() const -> std::size_t
+    {
+        return mVariables.size() - mRepeated;
+    }
+
+private:
+    std::vector<Var> mVariables;
+    std::size_t mRepeated = 0; // variables stored twice
+};
+
+} // namespace
+
+// deep chains are kept short to stay within the stack limits of recursive
+// code paths (such as the destruction of the graph)
+AUTODIFF_BENCHMARK_GRAPH(Chain, 10'000, 10'000)
+AUTODIFF_BENCHMARK_GRAPH(Wide, 100'000, 100'000)
@@ -23,5 +23,64 @@ scalar
     Automatic differentiation for scalars only
 array
     Automatic differentiation for scalars, 1D and 2D NumPy arrays
+array32
+    Same as `array`, in single precision (float32)
+fixed
+    Same as `array`, for vectors and matrices of sizes 2, 3 and 4
+lanes
+    Same as `scalar`, evaluated at many points at once
+
+Functions
+---------
+set_num_threads
+    Set the number of threads of large matrix products.
+get_num_threads
+    Get the number of threads of large matrix products.
+clear_buffer_pools
+    Free the recycled buffers of intermediate results.
 """
 __version__ = "0.1.0"
+
+
+def set_num_threads(threads):
+    """Set the number of threads of large matrix products.
+
+    Applies to the matrix products of the `array` and `array32` modules
+    (`matmul`, `outer`, and the dense Jacobian products of their sweeps).
+    Has no effect unless the package was built with OpenMP.
+
+    Parameters
+    ----------
+    threads : int
+              The number of threads, or 0 for the OpenMP default
+              (e.g., given by the `OMP_NUM_THREADS` environment variable).
+    """
+    from autodiff import _array, _array32
+
+    for module in (_array, _array32):
+        module._set_num_threads(threads)
+
+
+def get_num_threads():
+    """Get the number of threads of large matrix products.
+
+    Returns 1 if the package was built without OpenMP.
+    """
+    from autodiff import _array
+
+    return _array._num_threads()
+
+
+def clear_buffer_pools():
+    """Free the recycled buffers of intermediate results.
+
+    Released intermediate arrays are kept by a pool of the thread that
+    released them, up to 32 buffers and 64 MiB per array type, and reused by
+    later expressions. This frees the buffers kept by all threads, including
+    worker threads, e.g. after a sweep of a much larger graph than the
+    following ones.
+    """
+    from autodiff import _array, _array32, _fixed, _lanes
+
+    for module in (_array, _array32, _fixed, _lanes):
+        module._clear_buffer_pools()
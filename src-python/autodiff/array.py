@@ -10,6 +10,17 @@ Core classes
 Function
     Lets you evaluate and differentiate a program defined by
     variables and expressions.
+FunctionGroup
+    Evaluates and differentiates independent functions in parallel.
+Graph
+    Context manager allocating new expressions from an arena.
+Tape
+    Context manager recording graphs to save and load functions.
+
+Core functions
+--------------
+checkpoint_vjp
+    Vector-Jacobian product of a long loop with bounded memory.
 
 Variable classes
 ----------------
@@ -22,6 +33,9 @@ VectorVariable
 MatrixVariable
     A variable storing `np.ndarray[np.float64[r, s]]` value
     and `np.ndarray[np.float64[m, n]]` derivative.
+SparseMatrixVariable
+    A sparse matrix literal (SciPy CSR or CSC matrix) applied to
+    vector expressions with `@`.
 
 Operations
 ----------
@@ -49,6 +63,11 @@ exp
     Exponential function, element-wise.
 log
     Natural logarithm, element-wise.
+log1p
+    Natural logarithm of one plus the elements, element-wise,
+    accurate for small elements.
+sigmoid
+    Logistic sigmoid, element-wise, without overflow.
 sqrt
     Square root, element-wise.
 square
@@ -71,6 +90,15 @@ norm
     Frobenius (L²) norm of array expression.
 squared_norm
     Squared Frobenius (L²) norm of array expression.
+logsumexp
+    Logarithm of the sum of exponentials of array elements,
+    without overflow.
+softmax, log_softmax
+    Softmax of vector elements and its logarithm, in a single
+    operation each.
+sum, mean, norm, max (with axis)
+    Reduction of the columns (axis=0) or rows (axis=1)
+    of a matrix expression to a vector expression.
 
 Matrix-valued expressions
 -------------------------
@@ -111,6 +139,10 @@ from autodiff._array import *
 
 __all__ = [
     "Function",
+    "FunctionGroup",
+    "Graph",
+    "Tape",
+    "checkpoint_vjp",
     "Variable",
     "var",
     "d",
@@ -123,19 +155,26 @@ __all__ = [
     "MatrixExpression",
     "MatrixOperation",
     "MatrixVariable",
+    "SparseMatrixVariable",
     "sin",
     "cos",
     "exp",
     "log",
+    "log1p",
+    "sigmoid",
     "sqrt",
     "square",
     "minimum",
-    "maximum"
+    "maximum",
     "dot",
     "outer",
     "matmul",
     "sum",
+    "logsumexp",
+    "softmax",
+    "log_softmax",
     "mean",
     "norm",
     "squared_norm",
+    "max",
 ]
@@ -0,0 +1,183 @@
+"""
+AutoDiff for single-precision NumPy arrays
+==========================================
+
+This module provides automatic differentiation for scalar and
+(1D and 2D) NumPy array computations in single precision (float32).
+It has the same interface as the `array` module.
+Values and derivatives are stored as float32, so float32 arrays
+are bound without conversion.
+
+Core classes
+------------
+Function
+    Lets you evaluate and differentiate a program defined by
+    variables and expressions.
+FunctionGroup
+    Evaluates and differentiates independent functions in parallel.
+Graph
+    Context manager allocating new expressions from an arena.
+Tape
+    Context manager recording graphs to save and load functions.
+
+Core functions
+--------------
+checkpoint_vjp
+    Vector-Jacobian product of a long loop with bounded memory.
+
+Variable classes
+----------------
+ScalarVariable
+    A variable storing `float` value (single precision) and
+    `np.ndarray[np.float32[m, n]]` derivative.
+VectorVariable
+    A variable storing `np.ndarray[np.float32[r, 1]]` value
+    and `np.ndarray[np.float32[m, n]]` derivative.
+MatrixVariable
+    A variable storing `np.ndarray[np.float32[r, s]]` value
+    and `np.ndarray[np.float32[m, n]]` derivative.
+SparseMatrixVariable
+    A sparse matrix literal (SciPy CSR or CSC matrix) applied to
+    vector expressions with `@`.
+
+Operations
+----------
+In binary operations, one of the operands can also be a scalar
+or array literal.
+
+>>> x = var(np.array([1., 2., 3.]))  # vector variable
+
+>>> u = x + np.array([4., 5., 6.])   # add array literal
+
+Scalar literals and expressions are broadcasted to the shape
+of the array.
+
+>>> x = var(np.array([[1., 2.], [3., 4.]]))  # matrix variable
+
+>>> u = x + 5   # add 5 to each element
+
++, -, *, /, **
+    Element-wise arithmetic operations.
+sin
+    Sine function, element-wise.
+cos
+    Cosine function, element-wise.
+exp
+    Exponential function, element-wise.
+log
+    Natural logarithm, element-wise.
+log1p
+    Natural logarithm of one plus the elements, element-wise,
+    accurate for small elements.
+sigmoid
+    Logistic sigmoid, element-wise, without overflow.
+sqrt
+    Square root, element-wise.
+square
+    Square, element-wise.
+minimum
+    Element-wise minimum of an expression and zero.
+maximum
+    Element-wise maximum of an expression and zero.
+dot
+    Dot product of two vectors.
+outer
+    Outer (tensor) product of two vectors.
+matmul, @
+    Matrix multiplication.
+sum
+    Sum of array expression.
+mean
+    Arithmetic mean of array expression.
+norm
+    Frobenius (L²) norm of array expression.
+squared_norm
+    Squared Frobenius (L²) norm of array expression.
+logsumexp
+    Logarithm of the sum of exponentials of array elements,
+    without overflow.
+softmax, log_softmax
+    Softmax of vector elements and its logarithm, in a single
+    operation each.
+sum, mean, norm, max (with axis)
+    Reduction of the columns (axis=0) or rows (axis=1)
+    of a matrix expression to a vector expression.
+
+Matrix-valued expressions
+-------------------------
+During differentiation, AutoDiff flattens matrix expressions
+in column-major order.
+This ensures that the derivative (Jacobian matrix) is always
+a 2D NumPy array.
+
+>>> m1 = np.array([[1., 2.], [3., 4.]])
+
+>>> m2 = np.array([[5., 6., 7.], [8., 9., 10.]])
+
+>>> x = var(m1)    # 2⨉2 matrix variable
+
+>>> y = var(m2)    # 2⨉3 matrix variable
+
+>>> u = var(x @ y) # 2⨉3 matrix variable
+
+>>> f = Function(u)
+
+>>> f.pull_gradient_at(u)
+
+>>> d(u)           # 6⨉6 identity matrix
+
+>>> d(x)           # 6⨉4 matrix
+
+>>> d(y)           # 6⨉6 matrix
+
+1D arrays vs vectors 
+--------------------
+
+1D arrays and N⨉1 arrays (columns) in NumPy are treated as vectors
+in AutoDiff. But 1⨉N arrays are treated as matrices.
+"""
+
+from autodiff._array32 import __version__
+from autodiff._array32 import *
+
+__all__ = [
+    "Function",
+    "FunctionGroup",
+    "Graph",
+    "Tape",
+    "checkpoint_vjp",
+    "Variable",
+    "var",
+    "d",
+    "ScalarExpression",
+    "ScalarOperation",
+    "ScalarVariable",
+    "VectorExpression",
+    "VectorOperation",
+    "VectorVariable",
+    "MatrixExpression",
+    "MatrixOperation",
+    "MatrixVariable",
+    "SparseMatrixVariable",
+    "sin",
+    "cos",
+    "exp",
+    "log",
+    "log1p",
+    "sigmoid",
+    "sqrt",
+    "square",
+    "minimum",
+    "maximum",
+    "dot",
+    "outer",
+    "matmul",
+    "sum",
+    "logsumexp",
+    "softmax",
+    "log_softmax",
+    "mean",
+    "norm",
+    "squared_norm",
+    "max",
+]
@@ -0,0 +1,182 @@
+"""
+AutoDiff for small fixed-size NumPy arrays
+==========================================
+
+This module provides automatic differentiation for scalar and
+(1D and 2D) NumPy array computations with vectors of 2, 3 or 4
+elements and square matrices of 2, 3 or 4 rows.
+It has the same interface as the `array` module.
+The values are stored inline (without heap allocation), and the
+variable class is picked from the shape of the array.
+
+Core classes
+------------
+Function
+    Lets you evaluate and differentiate a program defined by
+    variables and expressions.
+FunctionGroup
+    Evaluates and differentiates independent functions in parallel.
+Graph
+    Context manager allocating new expressions from an arena.
+Tape
+    Context manager recording graphs to save and load functions.
+
+Core functions
+--------------
+checkpoint_vjp
+    Vector-Jacobian product of a long loop with bounded memory.
+
+Variable classes
+----------------
+ScalarVariable
+    A variable storing `float` value and
+    `np.ndarray[np.float64[m, n]]` derivative.
+Vector2Variable, Vector3Variable, Vector4Variable
+    A variable storing `np.ndarray[np.float64[r, 1]]` value
+    (r = 2, 3, 4) and `np.ndarray[np.float64[m, n]]` derivative.
+Matrix2Variable, Matrix3Variable, Matrix4Variable
+    A variable storing `np.ndarray[np.float64[r, r]]` value
+    (r = 2, 3, 4) and `np.ndarray[np.float64[m, n]]` derivative.
+
+Operations
+----------
+In binary operations, one of the operands can also be a scalar
+or array literal.
+
+>>> x = var(np.array([1., 2., 3.]))  # vector variable
+
+>>> u = x + np.array([4., 5., 6.])   # add array literal
+
+Scalar literals and expressions are broadcasted to the shape
+of the array.
+
+>>> x = var(np.array([[1., 2.], [3., 4.]]))  # matrix variable
+
+>>> u = x + 5   # add 5 to each element
+
++, -, *, /, **
+    Element-wise arithmetic operations.
+sin
+    Sine function, element-wise.
+cos
+    Cosine function, element-wise.
+exp
+    Exponential function, element-wise.
+log
+    Natural logarithm, element-wise.
+log1p
+    Natural logarithm of one plus the elements, element-wise,
+    accurate for small elements.
+sigmoid
+    Logistic sigmoid, element-wise, without overflow.
+sqrt
+    Square root, element-wise.
+square
+    Square, element-wise.
+minimum
+    Element-wise minimum of an expression and zero.
+maximum
+    Element-wise maximum of an expression and zero.
+dot
+    Dot product of two vectors.
+outer
+    Outer (tensor) product of two vectors.
+matmul, @
+    Matrix multiplication.
+sum
+    Sum of array expression.
+mean
+    Arithmetic mean of array expression.
+norm
+    Frobenius (L²) norm of array expression.
+squared_norm
+    Squared Frobenius (L²) norm of array expression.
+logsumexp
+    Logarithm of the sum of exponentials of array elements,
+    without overflow.
+softmax, log_softmax
+    Softmax of vector elements and its logarithm, in a single
+    operation each.
+sum, mean, norm, max (with axis)
+    Reduction of the columns (axis=0) or rows (axis=1)
+    of a matrix expression to a vector expression.
+
+Matrix-valued expressions
+-------------------------
+During differentiation, AutoDiff flattens matrix expressions
+in column-major order.
+Derivatives are dynamic 2D NumPy arrays, since the number of
+directions is only known when differentiating.
+
+>>> x = var(np.array([[1., 2.], [3., 4.]]))  # 2⨉2 matrix variable
+
+>>> u = var(x @ x)  # 2⨉2 matrix variable
+
+>>> f = Function(u)
+
+>>> f.pull_gradient_at(u)
+
+>>> d(x)            # 4⨉4 matrix
+
+Supported shapes
+----------------
+1D arrays and N⨉1 arrays (columns) of 2, 3 or 4 elements are
+treated as vectors, and N⨉N arrays (N = 2, 3, 4) as matrices.
+Arrays of other shapes are not supported.
+"""
+
+from autodiff._fixed import __version__
+from autodiff._fixed import *
+
+__all__ = [
+    "Function",
+    "FunctionGroup",
+    "Graph",
+    "Tape",
+    "checkpoint_vjp",
+    "Variable",
+    "var",
+    "d",
+    "ScalarExpression",
+    "ScalarOperation",
+    "ScalarVariable",
+    "Vector2Expression",
+    "Vector2Operation",
+    "Vector2Variable",
+    "Vector3Expression",
+    "Vector3Operation",
+    "Vector3Variable",
+    "Vector4Expression",
+    "Vector4Operation",
+    "Vector4Variable",
+    "Matrix2Expression",
+    "Matrix2Operation",
+    "Matrix2Variable",
+    "Matrix3Expression",
+    "Matrix3Operation",
+    "Matrix3Variable",
+    "Matrix4Expression",
+    "Matrix4Operation",
+    "Matrix4Variable",
+    "sin",
+    "cos",
+    "exp",
+    "log",
+    "log1p",
+    "sigmoid",
+    "sqrt",
+    "square",
+    "minimum",
+    "maximum",
+    "dot",
+    "outer",
+    "matmul",
+    "sum",
+    "logsumexp",
+    "softmax",
+    "log_softmax",
+    "mean",
+    "norm",
+    "squared_norm",
+    "max",
+]
@@ -0,0 +1,91 @@
+"""
+AutoDiff for scalars at many points
+===================================
+
+This module provides automatic differentiation for scalar computations
+evaluated at many points at once.
+Values and derivatives are 1D NumPy arrays, holding one point per element
+(or *lane*). All operations are element-wise, so one evaluation or
+differentiation sweep processes all points.
+
+Core classes
+------------
+Function
+    Lets you evaluate and differentiate a program defined by
+    variables and expressions.
+FunctionGroup
+    Evaluates and differentiates independent functions in parallel.
+Graph
+    Context manager allocating new expressions from an arena.
+Tape
+    Context manager recording graphs to save and load functions.
+
+Core functions
+--------------
+checkpoint_vjp
+    Vector-Jacobian product of a long loop with bounded memory.
+
+Variable classes
+----------------
+LanesVariable
+    A variable storing 1D array value and 1D array derivative.
+
+Operations
+----------
+In binary operations, one of the operands can also be a scalar literal.
+
+>>> x = var(np.linspace(0, 1, 1000))  # 1000 points
+
+>>> u = x * x + 3                     # the same program at every point
+
++, -, *, /, **
+    Arithmetic operations.
+sin
+    Sine function.
+cos
+    Cosine function.
+exp
+    Exponential function.
+log
+    Natural logarithm.
+log1p
+    Natural logarithm of one plus the argument, accurate for small
+    arguments.
+sigmoid
+    Logistic sigmoid, without overflow.
+sqrt
+    Square root.
+square
+    Square function.
+minimum
+    Minimum of an expression and zero.
+maximum
+    Maximum of an expression and zero.
+"""
+
+from autodiff._lanes import __version__
+from autodiff._lanes import *
+
+__all__ = [
+    "Function",
+    "FunctionGroup",
+    "Graph",
+    "Tape",
+    "checkpoint_vjp",
+    "Variable",
+    "var",
+    "d",
+    "LanesExpression",
+    "LanesOperation",
+    "LanesVariable",
+    "sin",
+    "cos",
+    "exp",
+    "log",
+    "log1p",
+    "sigmoid",
+    "sqrt",
+    "square",
+    "minimum",
+    "maximum",
+]
@@ -9,6 +9,19 @@ Core classes
 Function
     Lets you evaluate and differentiate a program defined by
     variables and expressions.
+FunctionGroup
+    Evaluates and differentiates independent functions in parallel.
+Graph
+    Context manager allocating new expressions from an arena.
+Tape
+    Context manager recording graphs to save and load functions.
+TapeFunction
+    A function lowered to a flat tape of scalar instructions.
+
+Core functions
+--------------
+checkpoint_vjp
+    Vector-Jacobian product of a long loop with bounded memory.
 
 Variable classes
 ----------------
@@ -33,6 +46,11 @@ exp
     Exponential function.
 log
     Natural logarithm.
+log1p
+    Natural logarithm of one plus the argument, accurate for small
+    arguments.
+sigmoid
+    Logistic sigmoid, without overflow.
 sqrt
     Square root.
 square
@@ -48,6 +66,11 @@ from autodiff._scalar import *
 
 __all__ = [
     "Function",
+    "FunctionGroup",
+    "Graph",
+    "Tape",
+    "TapeFunction",
+    "checkpoint_vjp",
     "Variable",
     "var",
     "d",
@@ -58,6 +81,8 @@ __all__ = [
     "cos",
     "exp",
     "log",
+    "log1p",
+    "sigmoid",
     "sqrt",
     "square",
     "minimum",
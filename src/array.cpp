@@ -6,163 +6,168 @@
 #include "common.hpp"
 
 #include <AutoDiff/Eigen>
+#include <AutoDiff/Python/BufferPool.hpp>
+#include <AutoDiff/Python/Cwise.hpp>
 #include <AutoDiff/Python/ExpressionBinding.hpp>
+#include <AutoDiff/Python/Reduction.hpp>
+#include <AutoDiff/Python/ScalarFunction.hpp>
+#include <AutoDiff/Python/Softmax.hpp>
+#include <AutoDiff/Python/Sparse.hpp>
 #include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
 
-PYBIND11_MODULE(MODULE_NAME, module)
-{
-    module.attr("__version__") = VERSION_INFO;
-    // the module docstring is added directly to `src-python/autodiff/array.py`
+// scalar type of the arrays, e.g. float for autodiff._array32
+#ifndef SCALAR_TYPE
+#define SCALAR_TYPE double
+#endif
 
-    /*
-     * Notes:
-     *
-     * 1) Expression bindings aim to resemble NumPy notation, while the C++
-     * functions follow Eigen's naming conventions.
-     * For example, sum (NumPy) vs. total (Eigen).
-     *
-     * 2) For operations taking both vectors and matrices, the vector binding
-     * must be defined before the matrix binding to ensure correct overload.
-     * This way, N⨉1 NumPy arrays use the vector bindings and 1⨉N arrays
-     * use the matrix bindings.
-     */
-
-    defCore(module); // must be called before ExpressionBinding
-
-    using ScalarBinding
-        = AutoDiff::Python::ExpressionBinding<double, Eigen::MatrixXd>;
-    auto scalarBinding = ScalarBinding(module, "Scalar");
+using Scalar = SCALAR_TYPE;
+// derivatives have a dynamic number of tangent or gradient directions
+using Jacobian      = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+using ScalarBinding = AutoDiff::Python::ExpressionBinding<Scalar, Jacobian>;
 
-    using VectorBinding
-        = AutoDiff::Python::ExpressionBinding<Eigen::VectorXd, Eigen::MatrixXd>;
-    auto vectorBinding = VectorBinding(module, "Vector");
+namespace {
 
-    using MatrixBinding
-        = AutoDiff::Python::ExpressionBinding<Eigen::MatrixXd, Eigen::MatrixXd>;
-    auto matrixBinding = MatrixBinding(module, "Matrix");
+// Bindings of the vectors and (square, if fixed) matrices of a given size,
+// dynamic or fixed at compile time, with names ending in the suffix
+template <int Size>
+void defArrays(pybind11::module& module, std::string const& suffix)
+{
+    using Vector = Eigen::Matrix<Scalar, Size, 1>;
+    using Matrix = Eigen::Matrix<Scalar, Size, Size>;
 
-    // scalar operations
+    using VectorBinding = AutoDiff::Python::ExpressionBinding<Vector, Jacobian>;
+    auto vectorBinding  = VectorBinding(module, "Vector" + suffix);
 
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "add", operator+, "")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "sub", operator-, "")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "mul", operator*, "")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "truediv", operator/, "")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "pow", pow, "")
+    using MatrixBinding = AutoDiff::Python::ExpressionBinding<Matrix, Jacobian>;
+    auto matrixBinding  = MatrixBinding(module, "Matrix" + suffix);
 
-    AUTODIFF_PYTHON_DEF_METHOD(scalarBinding, "neg", operator-, "")
-
-    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "cos", cos, "")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "exp", exp, "")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        ScalarBinding, module, "log", log, "Natural logarithm.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        ScalarBinding, module, "maximum", max, "Maximum of a scalar and zero.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        ScalarBinding, module, "minimum", min, "Minimum of a scalar and zero.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "sin", sin, "")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "sqrt", sqrt, "")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "square", square, "")
+    // maps NumPy arrays of any memory layout without copying
+    using Stride = Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>;
+    vectorBinding.template defAssign<Eigen::Ref<Vector const, 0, Stride>>();
+    matrixBinding.template defAssign<Eigen::Ref<Matrix const, 0, Stride>>();
 
     // vector (cwise) operations
 
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(vectorBinding, "add", operator+, "")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(vectorBinding, "sub", operator-, "")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(
-        vectorBinding, "mul", cwiseProduct, "Product, element-wise.")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(
-        vectorBinding, "truediv", cwiseQuotient, "Quotient, element-wise.")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(
-        vectorBinding, "pow", pow, "Element-wise power of vector elements.")
-
-    AUTODIFF_PYTHON_DEF_METHOD(vectorBinding, "neg", operator-, "")
-
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        VectorBinding, module, "cos", cos, "Cosine, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        VectorBinding, module, "exp", exp, "Exponential, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        VectorBinding, module, "log", log, "Natural logarithm, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(VectorBinding, module, "maximum", max,
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(vectorBinding, "add", Add, "")
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(vectorBinding, "sub", Sub, "")
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(
+        vectorBinding, "mul", Mul, "Product, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(
+        vectorBinding, "truediv", Div, "Quotient, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(vectorBinding, "pow", Pow,
+        "Element-wise power of vector elements.")
+
+    AUTODIFF_PYTHON_DEF_CWISE_METHOD(vectorBinding, "neg", Neg, "")
+
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        VectorBinding, module, "cos", Cos, "Cosine, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        VectorBinding, module, "exp", Exp, "Exponential, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        VectorBinding, module, "log", Log, "Natural logarithm, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(VectorBinding, module, "log1p", Log1p,
+        "Natural logarithm of one plus the elements, accurate for small "
+        "elements.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(VectorBinding, module, "maximum", Max,
         "Element-wise maximum of vector elements and zero.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(VectorBinding, module, "minimum", min,
+    AUTODIFF_PYTHON_DEF_CWISE_OP(VectorBinding, module, "minimum", Min,
         "Element-wise minimum of vector elements and zero.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        VectorBinding, module, "sin", sin, "Sine, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        VectorBinding, module, "sqrt", sqrt, "Square root, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        VectorBinding, module, "square", square, "Square, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(VectorBinding, module, "sigmoid", Sigmoid,
+        "Logistic sigmoid 1 / (1 + exp(-x)), element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        VectorBinding, module, "sin", Sin, "Sine, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        VectorBinding, module, "sqrt", Sqrt, "Square root, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        VectorBinding, module, "square", Square, "Square, element-wise.")
 
     // matrix (cwise) operations
 
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(matrixBinding, "add", operator+, "")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(matrixBinding, "sub", operator-, "")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(
-        matrixBinding, "mul", cwiseProduct, "Product, element-wise.")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(
-        matrixBinding, "truediv", cwiseQuotient, "Quotient, element-wise.")
-    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(
-        matrixBinding, "pow", pow, "Element-wise power of matrix elements.")
-
-    AUTODIFF_PYTHON_DEF_METHOD(matrixBinding, "neg", operator-, "")
-
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        MatrixBinding, module, "cos", cos, "Cosine, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        MatrixBinding, module, "exp", exp, "Exponential, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        MatrixBinding, module, "log", log, "Natural logarithm, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(MatrixBinding, module, "maximum", max,
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(matrixBinding, "add", Add, "")
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(matrixBinding, "sub", Sub, "")
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(
+        matrixBinding, "mul", Mul, "Product, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(
+        matrixBinding, "truediv", Div, "Quotient, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(matrixBinding, "pow", Pow,
+        "Element-wise power of matrix elements.")
+
+    AUTODIFF_PYTHON_DEF_CWISE_METHOD(matrixBinding, "neg", Neg, "")
+
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        MatrixBinding, module, "cos", Cos, "Cosine, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        MatrixBinding, module, "exp", Exp, "Exponential, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        MatrixBinding, module, "log", Log, "Natural logarithm, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(MatrixBinding, module, "log1p", Log1p,
+        "Natural logarithm of one plus the elements, accurate for small "
+        "elements.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(MatrixBinding, module, "maximum", Max,
         "Element-wise maximum of matrix elements and zero.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(MatrixBinding, module, "minimum", min,
+    AUTODIFF_PYTHON_DEF_CWISE_OP(MatrixBinding, module, "minimum", Min,
         "Element-wise minimum of matrix elements and zero.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        MatrixBinding, module, "sin", sin, "Sine, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        MatrixBinding, module, "sqrt", sqrt, "Square root, element-wise.")
-    AUTODIFF_PYTHON_DEF_UNARY_OP(
-        MatrixBinding, module, "square", square, "Square, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(MatrixBinding, module, "sigmoid", Sigmoid,
+        "Logistic sigmoid 1 / (1 + exp(-x)), element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        MatrixBinding, module, "sin", Sin, "Sine, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        MatrixBinding, module, "sqrt", Sqrt, "Square root, element-wise.")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(
+        MatrixBinding, module, "square", Square, "Square, element-wise.")
 
     // vector (left) broadcast operations
-
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(vectorBinding, "add", operator+, "")
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(vectorBinding, "sub", operator-, "")
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(vectorBinding, "mul", operator*, "")
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(
-        vectorBinding, "truediv", operator/, "")
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(vectorBinding, "pow", pow, "")
+    // (element-wise with scalar literals and fused with adjacent element-wise
+    // functions)
+
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        vectorBinding, "add", operator+, Add, "")
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        vectorBinding, "sub", operator-, Sub, "")
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        vectorBinding, "mul", operator*, Mul, "")
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        vectorBinding, "truediv", operator/, Div, "")
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        vectorBinding, "pow", pow, Pow, "")
 
     // vector (right) broadcast operations
 
-    AUTODIFF_PYTHON_DEF_R_BROADCAST_INFIX_OP(
-        vectorBinding, "add", operator+, "")
-    AUTODIFF_PYTHON_DEF_R_BROADCAST_INFIX_OP(
-        vectorBinding, "sub", operator-, "")
-    AUTODIFF_PYTHON_DEF_R_BROADCAST_INFIX_OP(
-        vectorBinding, "mul", operator*, "")
-    AUTODIFF_PYTHON_DEF_R_BROADCAST_INFIX_OP(
-        vectorBinding, "truediv", operator/, "")
+    AUTODIFF_PYTHON_DEF_CWISE_R_BROADCAST_INFIX_OP(
+        vectorBinding, "add", operator+, Add, "")
+    AUTODIFF_PYTHON_DEF_CWISE_R_BROADCAST_INFIX_OP(
+        vectorBinding, "sub", operator-, RSub, "")
+    AUTODIFF_PYTHON_DEF_CWISE_R_BROADCAST_INFIX_OP(
+        vectorBinding, "mul", operator*, Mul, "")
+    AUTODIFF_PYTHON_DEF_CWISE_R_BROADCAST_INFIX_OP(
+        vectorBinding, "truediv", operator/, RDiv, "")
 
     // matrix (left) broadcast operations
-
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(matrixBinding, "add", operator+, "")
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(matrixBinding, "sub", operator-, "")
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(matrixBinding, "mul", operator*, "")
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(
-        matrixBinding, "truediv", operator/, "")
-    AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(matrixBinding, "pow", pow, "")
+    // (element-wise with scalar literals and fused with adjacent element-wise
+    // functions)
+
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        matrixBinding, "add", operator+, Add, "")
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        matrixBinding, "sub", operator-, Sub, "")
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        matrixBinding, "mul", operator*, Mul, "")
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        matrixBinding, "truediv", operator/, Div, "")
+    AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(
+        matrixBinding, "pow", pow, Pow, "")
 
     // matrix (right) broadcast operations
 
-    AUTODIFF_PYTHON_DEF_R_BROADCAST_INFIX_OP(
-        matrixBinding, "add", operator+, "")
-    AUTODIFF_PYTHON_DEF_R_BROADCAST_INFIX_OP(
-        matrixBinding, "sub", operator-, "")
-    AUTODIFF_PYTHON_DEF_R_BROADCAST_INFIX_OP(
-        matrixBinding, "mul", operator*, "")
-    AUTODIFF_PYTHON_DEF_R_BROADCAST_INFIX_OP(
-        matrixBinding, "truediv", operator/, "")
+    AUTODIFF_PYTHON_DEF_CWISE_R_BROADCAST_INFIX_OP(
+        matrixBinding, "add", operator+, Add, "")
+    AUTODIFF_PYTHON_DEF_CWISE_R_BROADCAST_INFIX_OP(
+        matrixBinding, "sub", operator-, RSub, "")
+    AUTODIFF_PYTHON_DEF_CWISE_R_BROADCAST_INFIX_OP(
+        matrixBinding, "mul", operator*, Mul, "")
+    AUTODIFF_PYTHON_DEF_CWISE_R_BROADCAST_INFIX_OP(
+        matrixBinding, "truediv", operator/, RDiv, "")
 
     // vector-vector products
 
@@ -187,6 +192,11 @@ PYBIND11_MODULE(MODULE_NAME, module)
     AUTODIFF_PYTHON_DEF_INFIX_OP(matrixBinding, matrixBinding, MatrixBinding,
         "matmul", operator*, "Matrix-matrix product.")
 
+    // sparse matrix-vector products (SciPy matrices of any size)
+    if constexpr (Size == Eigen::Dynamic) {
+        AutoDiff::Python::defSparseMatrix<VectorBinding>(module);
+    }
+
     // vector reductions
 
     AUTODIFF_PYTHON_DEF_REDUCTION(VectorBinding, ScalarBinding, module, "mean",
@@ -200,6 +210,18 @@ PYBIND11_MODULE(MODULE_NAME, module)
 Equal to the dot product of the vector with itself.)doc");
     AUTODIFF_PYTHON_DEF_REDUCTION(VectorBinding, ScalarBinding, module, "sum",
         total, "Sum of vector elements.")
+    AUTODIFF_PYTHON_DEF_REDUCTION(VectorBinding, ScalarBinding, module,
+        "logsumexp", logSumExp,
+        R"doc(Logarithm of the sum of exponentials of vector elements.
+
+Shifted by the maximum element, so that it does not overflow.)doc")
+
+    // softmax (single operations with closed-form derivatives)
+
+    AUTODIFF_PYTHON_DEF_UNARY_OP(VectorBinding, module, "softmax", softmax,
+        "Softmax, exp(x) / sum(exp(x)), of vector elements.")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(VectorBinding, module, "log_softmax",
+        logSoftmax, "Logarithm of the softmax, x - logsumexp(x).")
 
     // matrix reductions
 
@@ -214,4 +236,97 @@ Equal to the dot product of the vector with itself.)doc");
 Equal to the dot product of the matrix with itself.)doc");
     AUTODIFF_PYTHON_DEF_REDUCTION(MatrixBinding, ScalarBinding, module, "sum",
         total, "Sum of matrix elements.")
+    AUTODIFF_PYTHON_DEF_REDUCTION(MatrixBinding, ScalarBinding, module,
+        "logsumexp", logSumExp,
+        "Logarithm of the sum of exponentials of matrix elements.")
+
+    // matrix reductions along an axis (columns for 0, rows for 1)
+
+    AUTODIFF_PYTHON_DEF_AXIS_REDUCTION(MatrixBinding, VectorBinding, module,
+        "max", Max, "Maximum of matrix elements along an axis.")
+    AUTODIFF_PYTHON_DEF_AXIS_REDUCTION(MatrixBinding, VectorBinding, module,
+        "mean", Mean, "Compute the arithmetic mean along an axis.")
+    AUTODIFF_PYTHON_DEF_AXIS_REDUCTION(MatrixBinding, VectorBinding, module,
+        "norm", Norm, "L²-norm of the columns (axis 0) or rows (axis 1).")
+    AUTODIFF_PYTHON_DEF_AXIS_REDUCTION(MatrixBinding, VectorBinding, module,
+        "sum", Sum, "Sum of matrix elements along an axis.")
+}
+
+} // namespace
+
+PYBIND11_MODULE(MODULE_NAME, module)
+{
+    module.attr("__version__") = VERSION_INFO;
+    // the module docstring is added directly to `src-python/autodiff/array.py`
+
+    /*
+     * Notes:
+     *
+     * 1) Expression bindings aim to resemble NumPy notation, while the C++
+     * functions follow Eigen's naming conventions.
+     * For example, sum (NumPy) vs. total (Eigen).
+     *
+     * 2) For operations taking both vectors and matrices, the vector binding
+     * must be defined before the matrix binding to ensure correct overload.
+     * This way, N⨉1 NumPy arrays use the vector bindings and 1⨉N arrays
+     * use the matrix bindings.
+     */
+
+    importCore(module); // must be called before ExpressionBinding
+
+#ifdef FIXED_SIZES
+    // the scalar types are those of autodiff._array, which registers them
+    auto scalarBinding = ScalarBinding(module, "Scalar", true);
+#else
+    auto scalarBinding = ScalarBinding(module, "Scalar");
+#endif
+
+    // scalar operations
+
+    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "add", operator+, "")
+    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "sub", operator-, "")
+    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "mul", operator*, "")
+    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "truediv", operator/, "")
+    AUTODIFF_PYTHON_DEF_SYM_INFIX_OP(scalarBinding, "pow", pow, "")
+
+    AUTODIFF_PYTHON_DEF_METHOD(scalarBinding, "neg", operator-, "")
+
+    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "cos", cos, "")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "exp", exp, "")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(
+        ScalarBinding, module, "log", log, "Natural logarithm.")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "log1p", log1p,
+        "Natural logarithm of one plus the scalar, accurate for small scalars.")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(
+        ScalarBinding, module, "maximum", max, "Maximum of a scalar and zero.")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(
+        ScalarBinding, module, "minimum", min, "Minimum of a scalar and zero.")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "sigmoid", sigmoid,
+        "Logistic sigmoid, 1 / (1 + exp(-x)).")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "sin", sin, "")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "sqrt", sqrt, "")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(ScalarBinding, module, "square", square, "")
+
+#ifdef FIXED_SIZES
+    // autodiff._fixed: values of fixed size stored inline (without heap
+    // allocation), picked by the shapes of the NumPy arrays
+    defArrays<2>(module, "2");
+    defArrays<3>(module, "3");
+    defArrays<4>(module, "4");
+#else
+    defArrays<Eigen::Dynamic>(module, "");
+#endif
+
+    // threads of the Eigen kernels (matrix products), per module since each
+    // has its own copy of Eigen; see `autodiff.set_num_threads`
+
+    module.def(
+        "_set_num_threads", &Eigen::setNbThreads, pybind11::arg("threads"));
+    module.def("_num_threads", &Eigen::nbThreads);
+
+    // buffer pools of the calling thread, per module since each has its own
+    // pools; see `autodiff.clear_buffer_pools`
+
+    module.def(
+        "_clear_buffer_pools", &AutoDiff::Python::detail::clearBufferPools);
 }
@@ -5,13 +5,39 @@
 
 #include "common.hpp"
 
-#include <AutoDiff/src/Core/AbstractVariable.hpp>
-#include <AutoDiff/src/Core/Function.hpp>
+#include <AutoDiff/Python/AbstractVariable.hpp>
+#include <AutoDiff/Python/Arena.hpp>
+#include <AutoDiff/Python/Function.hpp>
+#include <AutoDiff/Python/FunctionGroup.hpp>
+#include <AutoDiff/Python/Profiler.hpp>
+#include <AutoDiff/Python/Tape.hpp>
+#include <AutoDiff/Python/ThreadPool.hpp>
+#include <pybind11/numpy.h>
+
+#include <algorithm>  // equal, max, max_element, min
+#include <array>
+#include <cmath>      // lround, sqrt
+#include <exception>  // current_exception, exception_ptr, rethrow_exception
+#include <functional> // function, invoke, multiplies
+#include <map>
+#include <memory>     // make_unique
+#include <numeric>    // accumulate
+#include <stdexcept>  // runtime_error
+#include <string>     // to_string
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>    // move, pair
+#include <vector>
 
 namespace py = pybind11;
 
-using AutoDiff::AbstractVariable;
-using AutoDiff::Function;
+using AutoDiff::Python::AbstractVariable;
+using AutoDiff::Python::Function;
+using AutoDiff::Python::FunctionGroup;
+using AutoDiff::Python::Graph;
+using AutoDiff::Python::Profiler;
+using AutoDiff::Python::Sweep;
+using AutoDiff::Python::Tape;
 
 namespace detail {
 
@@ -33,15 +59,616 @@ auto createTargets(py::tuple const& targetsTuple) -> Function::Targets
     return targets;
 }
 
+// keeps the variables passed from Python for seeding directional derivatives
+auto createFunction(py::tuple const& sources, py::tuple const& targets,
+    std::size_t threads = 1) -> std::unique_ptr<Function>
+{
+    auto function = std::make_unique<Function>(
+        createSources(sources), createTargets(targets));
+    function->setVariables(sources, targets);
+    function->setThreads(threads);
+    return function;
+}
+
+// Waits for the asynchronous sweeps of the function, releasing the GIL
+void waitFor(Function const& function)
+{
+    if (function.running()) {
+        py::gil_scoped_release const release;
+        function.wait();
+    }
+}
+
+// Runs a sweep, releasing the GIL if the function is configured to do so.
+template <typename Sweep, typename... Args>
+void run(Function& function, Sweep sweep, Args const&... args)
+{
+    waitFor(function);
+    if (function.releasesGil()) {
+        py::gil_scoped_release const release;
+        std::invoke(sweep, function, args...);
+    } else {
+        std::invoke(sweep, function, args...);
+    }
+}
+
+// Worker thread running the asynchronous sweeps of all functions one at a
+// time, in the order of submission.
+// It is never destroyed, since it must not be joined during the shutdown of
+// the interpreter while a sweep waits for the GIL.
+auto asyncWorker() -> ThreadPool&
+{
+    static auto* const worker = new ThreadPool{1};
+    return *worker;
+}
+
+// Runs a sweep on the worker thread without the GIL and returns a
+// `concurrent.futures.Future` that completes with None or the exception.
+// The Python objects stay alive until then, and the variables of the
+// function's graph are locked against modifications.
+auto runAsync(py::object self, py::object seed,
+    std::function<void(Function&)> sweep) -> py::object
+{
+    struct Pending {
+        py::object self;
+        py::object seed;
+        py::object future;
+    };
+
+    auto& function = self.cast<Function&>();
+    auto future = py::module_::import("concurrent.futures").attr("Future")();
+    future.attr("set_running_or_notify_cancel")();
+    auto pending = std::make_shared<Pending>(
+        Pending{std::move(self), std::move(seed), future});
+
+    auto locked = function.lockVariables();
+    auto done   = asyncWorker().submit([&function, pending, sweep, locked] {
+        auto error = std::exception_ptr{};
+        try {
+            sweep(function);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        py::gil_scoped_acquire const gil;
+        // while holding the GIL, so that Python threads see the variables
+        // locked until the sweep is done
+        Function::unlockVariables(locked);
+        if (error) {
+            // translated to a Python exception like any binding would
+            auto const rethrow
+                = py::cpp_function([error] { std::rethrow_exception(error); });
+            try {
+                rethrow();
+            } catch (py::error_already_set& exception) {
+                pending->future.attr("set_exception")(exception.value());
+            }
+        } else {
+            pending->future.attr("set_result")(py::none());
+        }
+        *pending = Pending{}; // release the objects while holding the GIL
+    });
+    function.setPending(done.share());
+    return future;
+}
+
+auto evaluateBatch(Function& function, py::dict const& inputsDict,
+    py::tuple const& outputsTuple) -> py::tuple
+{
+    waitFor(function);
+    using Batch = std::pair<AbstractVariable const*, py::array>;
+
+    auto const numpy = py::module_::import("numpy");
+
+    auto inputs    = std::vector<Batch>{};
+    auto batchSize = py::ssize_t{-1};
+    for (auto const& [key, value] : inputsDict) {
+        auto const& input = key.cast<AbstractVariable const&>();
+        auto batch = numpy.attr("ascontiguousarray")(value, input._dtype())
+                         .cast<py::array>();
+        auto const ndim = static_cast<py::ssize_t>(input._shape().size()) + 1;
+        if (batch.ndim() != ndim) {
+            throw py::value_error("Input batch must have "
+                + std::to_string(ndim) + " dimensions, but has "
+                + std::to_string(batch.ndim()) + ".");
+        }
+        if (batchSize >= 0 && batch.shape(0) != batchSize) {
+            throw py::value_error("Input batches must have the same length.");
+        }
+        batchSize = batch.shape(0);
+        inputs.emplace_back(&input, std::move(batch));
+    }
+    if (batchSize < 0) {
+        throw py::value_error("No input batches given.");
+    }
+
+    auto outputs = std::vector<Batch>{};
+    for (auto const& output : outputsTuple) {
+        outputs.emplace_back(
+            &output.cast<AbstractVariable const&>(), py::array{});
+    }
+
+    auto assignInputs = [&](py::ssize_t index) {
+        for (auto const& [input, batch] : inputs) {
+            input->_assign(batch, index);
+        }
+    };
+    auto copyOutputs = [&](py::ssize_t index) {
+        for (auto& [output, batch] : outputs) {
+            output->_copyTo(batch, index);
+        }
+    };
+
+    // the first evaluation determines the output shapes
+    if (batchSize > 0) {
+        assignInputs(0);
+        function.evaluate();
+    }
+    for (auto& [output, batch] : outputs) {
+        auto shape = output->_shape();
+        shape.insert(shape.begin(), batchSize);
+        batch = py::array(output->_dtype(), shape);
+    }
+    if (batchSize > 0) {
+        copyOutputs(0);
+    }
+
+    run(function, [&](Function&) {
+        for (auto index = py::ssize_t{1}; index < batchSize; ++index) {
+            assignInputs(index);
+            function.evaluate();
+            copyOutputs(index);
+        }
+    });
+
+    auto results = py::tuple(outputs.size());
+    for (auto i = std::size_t{0}; i < outputs.size(); ++i) {
+        results[i] = std::move(outputs[i].second);
+    }
+    return results;
+}
+
+// Sets a single tangent (column) or gradient (row) as derivative of each
+// variable with a direction, and zero for the other given variables.
+void seedDirections(
+    py::dict const& directions, py::tuple const& others, bool tangent)
+{
+    auto const numpy = py::module_::import("numpy");
+
+    for (auto const& [key, value] : directions) {
+        auto const& variable = key.cast<AbstractVariable const&>();
+        auto const direction
+            = numpy
+                  .attr("asarray")(value, variable._dtype(),
+                      py::arg("order") = "C") // keeps scalars 0D
+                  .cast<py::array>();
+        auto const shape = variable._shape();
+        if (direction.ndim() != static_cast<py::ssize_t>(shape.size())
+            || !std::equal(shape.begin(), shape.end(), direction.shape())) {
+            throw py::value_error(
+                "Direction must have the same shape as the variable value.");
+        }
+        variable._setDirection(direction, tangent);
+    }
+    for (auto const& other : others) {
+        if (directions.contains(other)) {
+            continue;
+        }
+        auto const& variable = other.cast<AbstractVariable const&>();
+        auto zero = py::array(variable._dtype(), variable._shape());
+        zero.attr("fill")(0);
+        variable._setDirection(zero, tangent);
+    }
+}
+
+void jvp(Function& function, py::dict const& directions)
+{
+    waitFor(function);
+    seedDirections(directions, function.sources(), true);
+    run(function, &Function::pushTangent);
+}
+
+void vjp(Function& function, py::dict const& directions)
+{
+    waitFor(function);
+    seedDirections(directions, function.targets(), false);
+    run(function, &Function::pullGradient);
+}
+
+// Hessian-vector product of a scalar target, see Function::hvp
+void hvp(Function& function, AbstractVariable const& seed,
+    py::dict const& directions)
+{
+    waitFor(function);
+    auto const sources = function.sources();
+    for (auto const& [key, value] : directions) {
+        if (!sources.contains(key)) {
+            throw py::value_error("The directions must be given for sources.");
+        }
+    }
+    seedDirections(directions, sources, true);
+    run(function, &Function::hvp, seed);
+}
+
+// Copy of a value that stays valid when the variable is destroyed
+auto copyValue(py::object const& value) -> py::object
+{
+    return py::isinstance<py::array>(value) ? value.attr("copy")() : value;
+}
+
+// Copy of the derivative of a variable of any module, as returned by `d`
+auto derivativeOf(py::handle variable) -> py::object
+{
+    auto const module = py::module_::import(
+        py::type::of(variable).attr("__module__").cast<std::string>().c_str());
+    return copyValue(module.attr("d")(variable));
+}
+
+// Reverse mode for `steps` applications of `step`, storing only every
+// `every`-th state and recomputing the graph of one segment at a time.
+auto checkpointVjp(py::function const& step, py::object const& state,
+    std::size_t steps, py::object direction, py::tuple const& parameters,
+    std::size_t every) -> py::object
+{
+    if (every == 0) {
+        every = std::max(std::size_t{1},
+            static_cast<std::size_t>(std::lround(std::sqrt(steps))));
+    }
+    if (steps == 0) { // the loop is the identity
+        auto directions   = py::dict{};
+        directions[state] = direction;
+        seedDirections(directions, parameters, false);
+        return copyValue(state());
+    }
+    auto const numpy = py::module_::import("numpy");
+    auto const type  = py::type::of(state); // e.g., ScalarVariable
+
+    // forward: one step at a time, keeping the checkpoints
+    auto checkpoints = std::vector<py::object>{};
+    auto value       = copyValue(state());
+    for (auto i = std::size_t{0}; i < steps; ++i) {
+        if (i % every == 0) {
+            checkpoints.push_back(value);
+        }
+        value = copyValue(step(type(value))());
+    }
+
+    // reverse: recompute each segment, last to first
+    auto totals   = std::vector<py::object>(parameters.size(), py::none());
+    auto gradient = py::object{};
+    for (auto segment = checkpoints.size(); segment-- > 0;) {
+        auto const start = segment * every;
+        auto const end   = std::min(start + every, steps);
+
+        auto const source = type(checkpoints[segment]);
+        auto target       = source;
+        for (auto i = start; i < end; ++i) {
+            target = step(target);
+        }
+
+        auto sources = py::list{};
+        sources.append(source);
+        for (auto const& parameter : parameters) {
+            sources.append(parameter);
+        }
+        auto const function
+            = createFunction(py::tuple(sources), py::make_tuple(target));
+        auto directions   = py::dict{};
+        directions[target] = direction;
+        vjp(*function, directions);
+
+        gradient  = derivativeOf(source);
+        direction = numpy.attr("reshape")(gradient,
+            numpy.attr("shape")(checkpoints[segment]), py::arg("order") = "F");
+        for (auto i = std::size_t{0}; i < parameters.size(); ++i) {
+            auto const partial = derivativeOf(parameters[i]);
+            totals[i] = totals[i].is_none() ? partial : totals[i] + partial;
+        }
+    }
+
+    if (gradient) {
+        state.attr("set_derivative")(gradient);
+    }
+    for (auto i = std::size_t{0}; i < parameters.size(); ++i) {
+        if (!totals[i].is_none()) {
+            parameters[i].attr("set_derivative")(totals[i]);
+        }
+    }
+    return value;
+}
+
+template <typename Index>
+auto toTuple(std::vector<Index> const& shape) -> py::tuple
+{
+    auto tuple = py::tuple(shape.size());
+    for (auto i = std::size_t{0}; i < shape.size(); ++i) {
+        tuple[i] = shape[i];
+    }
+    return tuple;
+}
+
+// Number of elements of the value of a variable
+auto sizeOf(py::handle variable) -> py::ssize_t
+{
+    auto const shape = variable.cast<AbstractVariable const&>()._shape();
+    return std::accumulate(shape.begin(), shape.end(), py::ssize_t{1},
+        std::multiplies<>{});
+}
+
+// Jacobian matrix of the targets with respect to the sources, computed in
+// forward mode (all source elements seeded at once as tangent columns) or in
+// reverse mode (all target elements seeded at once as gradient rows).
+// Variables whose derivatives hold a single direction per element (those of
+// the scalar and lanes modules) are swept once per element instead.
+auto jacobian(Function& function, py::object sources, py::object targets,
+    std::string const& mode) -> py::array
+{
+    waitFor(function);
+    if (mode != "auto" && mode != "forward" && mode != "reverse") {
+        throw py::value_error("Mode must be 'auto', 'forward', or 'reverse'.");
+    }
+    auto const sourceTuple
+        = py::tuple(sources.is_none() ? function.sources() : sources);
+    auto const targetTuple
+        = py::tuple(targets.is_none() ? function.targets() : targets);
+    if (sourceTuple.empty()) {
+        throw py::value_error(
+            "The function must be created with sources or they must be given.");
+    }
+
+    // offsets of the variables in the rows and columns of the matrix
+    auto const offsets = [](py::tuple const& variables) {
+        auto result = std::vector<py::ssize_t>{0};
+        for (auto const& variable : variables) {
+            result.push_back(result.back() + sizeOf(variable));
+        }
+        return result;
+    };
+    auto const rows    = offsets(targetTuple);
+    auto const columns = offsets(sourceTuple);
+    auto const forward = mode == "forward"
+        || (mode == "auto" && columns.back() <= rows.back());
+    auto const sweep
+        = forward ? &Function::pushTangent : &Function::pullGradient;
+
+    // seed the sources (forward) or the targets (reverse), read the others
+    auto const& seeded  = forward ? sourceTuple : targetTuple;
+    auto const& read    = forward ? targetTuple : sourceTuple;
+    auto const& seeds   = forward ? columns : rows;
+    auto const& entries = forward ? rows : columns;
+    auto const count    = seeds.back();
+    auto const zeroed // other sources or targets passed to the function
+        = py::tuple(forward ? function.sources() : function.targets());
+
+    auto const numpy = py::module_::import("numpy");
+    auto result      = numpy.attr("zeros")(
+        py::make_tuple(rows.back(), columns.back()));
+    // sets the entries of read variable i in the given directions
+    auto const store = [&](std::size_t i, py::object const& directions,
+                           py::handle block) {
+        auto const slice = py::slice(entries[i], entries[i + 1], 1);
+        auto const index = forward ? py::make_tuple(slice, directions)
+                                   : py::make_tuple(directions, slice);
+        result[index]    = block;
+    };
+
+    // all directions in one sweep
+    auto block = true;
+    for (auto i = std::size_t{0}; i < seeded.size() && block; ++i) {
+        block = seeded[i].cast<AbstractVariable const&>()._setSeed(
+            seeds[i], count, forward);
+    }
+    if (block) {
+        for (auto const& other : zeroed) {
+            if (!seeded.contains(other)) {
+                other.cast<AbstractVariable const&>()._setSeed(
+                    count, count, forward); // all directions out of range
+            }
+        }
+        run(function, sweep);
+        for (auto i = std::size_t{0}; i < read.size(); ++i) {
+            store(i, py::slice(0, count, 1), derivativeOf(read[i]));
+        }
+        return result;
+    }
+
+    // one direction per sweep
+    auto const others = py::tuple(zeroed + seeded);
+    auto seed         = py::ssize_t{0};
+    for (auto const& variable : seeded) {
+        auto const size  = sizeOf(variable);
+        auto const shape = toTuple(
+            variable.cast<AbstractVariable const&>()._shape());
+        for (auto element = py::ssize_t{0}; element < size; ++element) {
+            auto direction = numpy.attr("zeros")(size);
+            direction[py::int_(element)] = 1;
+            auto directions      = py::dict{};
+            directions[variable] = direction.attr("reshape")(
+                shape, py::arg("order") = "F");
+            seedDirections(directions, others, forward);
+            run(function, sweep);
+            for (auto i = std::size_t{0}; i < read.size(); ++i) {
+                store(i, py::int_(seed), numpy.attr("ravel")(
+                    derivativeOf(read[i]), py::arg("order") = "F"));
+            }
+            ++seed;
+        }
+    }
+    return result;
+}
+
+// TapeFunction of the scalar module, which saves and loads the graphs of
+// functions recorded on tapes
+auto tapeFunctionClass() -> py::object
+{
+    return py::module_::import("autodiff._scalar").attr("TapeFunction");
+}
+
+auto sweepName(Sweep sweep) -> char const*
+{
+    switch (sweep) {
+    case Sweep::Evaluate: return "evaluate";
+    case Sweep::PushTangent: return "push_tangent";
+    case Sweep::PullGradient: return "pull_gradient";
+    }
+    return "";
+}
+
+auto toDict(Profiler::Stats const& stats) -> py::dict
+{
+    auto dict     = py::dict{};
+    dict["calls"] = stats.calls;
+    dict["time"]  = stats.seconds;
+    dict["bytes"] = stats.bytes;
+    return dict;
+}
+
+// statistics per operation type and per node, for each sweep with calls
+auto stats(Function const& function) -> py::dict
+{
+    auto operations = py::dict{};
+    auto nodes      = py::list{};
+    if (auto const* profiler = function.profiler()) {
+        auto totals = std::map<std::string, std::array<Profiler::Stats, 3>>{};
+        for (auto const& node : profiler->nodes()) {
+            auto dict         = py::dict{};
+            dict["operation"] = node.operation;
+            dict["shape"]     = toTuple(node.shape);
+            auto& total       = totals[node.operation];
+            for (auto i = std::size_t{0}; i < node.sweeps.size(); ++i) {
+                auto const& stats = node.sweeps[i];
+                if (stats.calls == 0) {
+                    continue;
+                }
+                dict[sweepName(static_cast<Sweep>(i))] = toDict(stats);
+                total[i].calls += stats.calls;
+                total[i].seconds += stats.seconds;
+                total[i].bytes += stats.bytes;
+            }
+            nodes.append(std::move(dict));
+        }
+        for (auto const& [operation, total] : totals) {
+            auto dict = py::dict{};
+            for (auto i = std::size_t{0}; i < total.size(); ++i) {
+                if (total[i].calls > 0) {
+                    dict[sweepName(static_cast<Sweep>(i))] = toDict(total[i]);
+                }
+            }
+            operations[py::str(operation)] = std::move(dict);
+        }
+    }
+    auto result          = py::dict{};
+    result["operations"] = std::move(operations);
+    result["nodes"]      = std::move(nodes);
+    return result;
+}
+
+// events in the Chrome trace event format
+auto trace(Function const& function) -> py::dict
+{
+    auto events = py::list{};
+    if (auto const* profiler = function.profiler()) {
+        auto const& nodes = profiler->nodes();
+        for (auto const& event : profiler->events()) {
+            auto args    = py::dict{};
+            args["node"] = event.node;
+            auto dict    = py::dict{};
+            dict["name"] = nodes[event.node].operation;
+            dict["cat"]  = sweepName(event.sweep);
+            dict["ph"]   = "X";
+            dict["ts"]   = event.start;
+            dict["dur"]  = event.duration;
+            dict["pid"]  = 0;
+            dict["tid"]  = 0;
+            dict["args"] = std::move(args);
+            events.append(std::move(dict));
+        }
+    }
+    auto result               = py::dict{};
+    result["traceEvents"]     = std::move(events);
+    result["displayTimeUnit"] = "ms";
+    return result;
+}
+
+// Memory held by the function: the variables and operations of its graph,
+// or of the profiled sweeps if the graph is not known, and the cache buffers
+// of the profiled sweeps
+auto memoryReport(Function const& function) -> py::dict
+{
+    auto const* profiler = function.profiler();
+    auto summary         = function.summary();
+    auto const known     = summary.has_value(); // the graph
+    if (!known && profiler == nullptr) {
+        throw std::runtime_error("The graph of the function is not known and "
+                                 "it has not been profiled; call `profile` "
+                                 "before the sweeps.");
+    }
+    if (!known) { // from the profile
+        summary        = Function::Summary{};
+        auto variables = profiler->variables();
+        // including the variables passed at construction, even if not read
+        for (auto const& tuple : {function.sources(), function.targets()}) {
+            for (auto const& handle : tuple) {
+                auto const& variable = handle.cast<AbstractVariable const&>();
+                auto& held = variables[variable._node()].valueBytes;
+                held       = std::max(held, variable._valueBytes());
+            }
+        }
+        for (auto const& node : profiler->nodes()) {
+            ++summary->operations[node.operation];
+        }
+        for (auto const& entry : variables) {
+            summary->valueBytes += entry.second.valueBytes;
+            summary->derivativeBytes += entry.second.derivativeBytes;
+        }
+        summary->variables = variables.size();
+    }
+
+    auto counts = py::dict{};
+    for (auto const& [operation, count] : summary->operations) {
+        counts[py::str(operation)] = count;
+    }
+    auto result                = py::dict{};
+    result["operations"]       = std::move(counts);
+    result["variables"]        = summary->variables;
+    result["value_bytes"]      = summary->valueBytes;
+    result["derivative_bytes"] = summary->derivativeBytes;
+    result["cache_bytes"]      = py::none{};
+    result["peak_bytes"]       = py::none{};
+    if (profiler != nullptr) {
+        auto peaks = py::dict{};
+        for (auto sweep :
+            {Sweep::Evaluate, Sweep::PushTangent, Sweep::PullGradient}) {
+            peaks[sweepName(sweep)] = profiler->peakBytes(sweep);
+        }
+        result["cache_bytes"] = profiler->cacheBytes();
+        result["peak_bytes"]  = std::move(peaks);
+    }
+    result["levels"]       = py::none{};
+    result["widest_level"] = py::none{};
+    if (known) {
+        auto const& widths     = summary->levels;
+        result["levels"]       = widths.size();
+        result["widest_level"] = widths.empty()
+            ? 0
+            : *std::max_element(widths.begin(), widths.end());
+    }
+    return result;
+}
+
 } // namespace detail
 
 void defCore(py::module& module)
 {
-    py::class_<AbstractVariable>(module, "Variable", py::module_local(),
+    // shared by the modules using these classes, see importCore
+    using AutoDiff::Python::detail::localState;
+    using AutoDiff::Python::detail::State;
+    module.attr("_state") = py::capsule(&localState, State::capsuleName);
+
+    py::class_<AbstractVariable>(module, "Variable",
         "Base class for all variables.");
 
-    auto function
-        = py::class_<Function>(module, "Function", py::module_local());
+    auto function = py::class_<Function>(module, "Function");
 
     function.doc()
         = R"doc(Represents a program defined by target variables as functions
@@ -65,11 +692,12 @@ computation graph and it holds only non-owning references to the computation
 nodes (which are owned by variables).)doc";
 
     function.def(
-        py::init<>([](py::tuple const& targets, py::tuple const& sources) {
-            return Function(
-                detail::createSources(sources), detail::createTargets(targets));
+        py::init<>([](py::tuple const& targets, py::tuple const& sources,
+                        std::size_t threads) {
+            return detail::createFunction(sources, targets, threads);
         }),
         py::arg("targets"), py::kw_only(), py::arg("sources") = py::tuple(),
+        py::arg("threads") = 1,
         R"doc(Create a function mapping sources to targets.
 
 The source variables are used to limit the search for dependencies.
@@ -82,7 +710,10 @@ targets : tuple of Variable
 sources : tuple of Variable, optional
           The source variables.
           Need not be the actual sources of the function.
-          
+threads : int, optional
+          The number of threads running the levels of the graph,
+          see `threads`. Defaults to one.
+
 Examples
 --------
 >>> x = var(..)  # literal variable
@@ -101,11 +732,12 @@ RuntimeError
     If the function has no targets.)doc");
 
     function.def(py::init<>([](AbstractVariable const& target,
-                                py::tuple const& sources) {
-        return Function(detail::createSources(sources),
-            detail::createTargets(py::make_tuple(target)));
+                                py::tuple const& sources, std::size_t threads) {
+        return detail::createFunction(
+            sources, py::make_tuple(target), threads);
     }),
         py::arg("target"), py::kw_only(), py::arg("sources") = py::tuple(),
+        py::arg("threads") = 1,
         R"doc(Create a function mapping sources to a single target.
 
 The source variables are used to limit the search for dependencies.
@@ -118,7 +750,10 @@ target : Variable
 sources : tuple of Variable, optional
           The source variables.
           Need not be the actual sources of the function.
-          
+threads : int, optional
+          The number of threads running the levels of the graph,
+          see `threads`. Defaults to one.
+
 Examples
 --------
 >>> x = var(..)  # literal variable
@@ -132,11 +767,13 @@ Examples
 >>> f_2 = Function(sources=(u, v), target=a)  # (u, v) ↦ a)doc");
 
     function.def(py::init<>([](py::tuple const& targets,
-                                AbstractVariable const& source) {
-        return Function(detail::createSources(py::make_tuple(source)),
-            detail::createTargets(targets));
+                                AbstractVariable const& source,
+                                std::size_t threads) {
+        return detail::createFunction(
+            py::make_tuple(source), targets, threads);
     }),
         py::arg("targets"), py::kw_only(), py::arg("source"),
+        py::arg("threads") = 1,
         R"doc(Create a function mapping sources to targets.
 
 The source variable is used to limit the search for dependencies.
@@ -149,6 +786,9 @@ targets : tuple of Variable
 source : Variable
          A source variable.
          Need not be an actual source of the function.
+threads : int, optional
+          The number of threads running the levels of the graph,
+          see `threads`. Defaults to one.
 
 Examples
 --------
@@ -168,11 +808,13 @@ RuntimeError
     If the function has no targets.)doc");
 
     function.def(py::init<>([](AbstractVariable const& target,
-                                AbstractVariable const& source) {
-        return Function(detail::createSources(py::make_tuple(source)),
-            detail::createTargets(py::make_tuple(target)));
+                                AbstractVariable const& source,
+                                std::size_t threads) {
+        return detail::createFunction(
+            py::make_tuple(source), py::make_tuple(target), threads);
     }),
         py::arg("target"), py::kw_only(), py::arg("source"),
+        py::arg("threads") = 1,
         R"doc(Create a function mapping sources to a single target.
 
 The source variable is used to limit the search for dependencies.
@@ -185,7 +827,10 @@ target : Variable
 source : Variable
          The source variable.
          Need not be an actual source of the function.
-         
+threads : int, optional
+          The number of threads running the levels of the graph,
+          see `threads`. Defaults to one.
+
 Examples
 --------
 >>> x = var(..)  # literal variable
@@ -198,7 +843,12 @@ Examples
 
 >>> f_2 = Function(source=u, target=a)    # u ↦ a)doc");
 
-    function.def("compile", &Function::compile,
+    function.def(
+        "compile",
+        [](Function& function) {
+            detail::waitFor(function);
+            function.compile();
+        },
         R"doc(Compile the function for evaluation and differentiation.
 
 Compilation generates a topologically ordered sequence of computation
@@ -209,6 +859,10 @@ Note
 ----
 This method must be called after assigning a new expression to one of the
 variables involved.
+It returns immediately if the function is compiled and no expression has
+been changed with `set` since then, so it is cheap to call before every sweep.
+If expressions were changed, but every variable of the graph still reads the
+same variables, it only compares the recorded structure of the graph.
 
 Raises
 ------
@@ -220,7 +874,223 @@ RuntimeError
 
     function.def("__str__", &Function::str, "For debugging purposes.");
 
-    function.def("evaluate", &Function::evaluate,
+    function.def_property("retain_cache", &Function::retainsCache,
+        &Function::setRetainCache,
+        R"doc(Whether to keep the cache buffers of expressions between sweeps.
+
+By default, the intermediate results of expressions are freed after each
+evaluation or differentiation.
+If enabled, they are kept and overwritten in place by the next sweep instead,
+which avoids reallocating memory as long as the array shapes stay the same.
+This speeds up repeated sweeps at the cost of holding on to the memory.
+
+Examples
+--------
+>>> f = Function(u)
+
+>>> f.retain_cache = True
+
+>>> for x_val in inputs:
+...     x.set(x_val)
+...     f.evaluate()     # reuses the buffers of the previous sweep)doc");
+
+    function.def_property("release_gil", &Function::releasesGil,
+        &Function::setReleaseGil,
+        R"doc(Whether to release the GIL during evaluation and differentiation.
+
+By default, the global interpreter lock is held for the whole sweep.
+If enabled, other Python threads keep running while the function is
+evaluated or differentiated, and functions can run in parallel on
+multiple threads.
+
+Note
+----
+Functions that run at the same time must not share any variables,
+because sweeps write to the values and derivatives of their variables.
+
+Examples
+--------
+>>> f = Function(u)
+
+>>> f.release_gil = True
+
+>>> thread = threading.Thread(target=f.evaluate)
+
+>>> thread.start()  # evaluates concurrently with the main thread)doc");
+
+    function.def_property(
+        "threads", &Function::threads,
+        [](Function& function, std::size_t threads) {
+            detail::waitFor(function); // the pool might be in use
+            function.setThreads(threads);
+        },
+        R"doc(The number of threads running the levels of the graph.
+
+By default, the whole program runs on the calling thread.
+With more than one thread, compiling also splits the graph into one step
+per variable with an expression, grouped into levels: the variables of a
+level only read sources and variables of lower levels.
+The sweeps then run the steps of each level in parallel on a pool of worker
+threads, one level after another (in reverse order for backpropagation).
+Setting zero uses one thread per hardware thread.
+
+Note
+----
+Only wide graphs benefit, where a level holds several expensive
+expressions, such as independent branches of a model.
+Sweeps while profiling run the levels on the calling thread.
+Backpropagation runs the whole program on the calling thread if a target is
+also read by another variable or is a source.
+If a variable of the graph was not created from Python, its expression is
+unknown, so the whole program runs on the calling thread as well.
+
+Examples
+--------
+>>> ys = [var(sum(exp(x) * x)) for x in xs]  # independent branches
+
+>>> f = Function(var(ys[0] + ys[1] + ...), threads=8)
+
+>>> f.evaluate()  # evaluates the branches in parallel)doc");
+
+    function.def_property("incremental", &Function::incremental,
+        &Function::setIncremental,
+        R"doc(Whether to skip evaluations that would not change any value.
+
+If enabled, `evaluate` returns immediately if no expression has been
+changed and none of the variables read by the last evaluation, nor the
+targets, has been `set`, assigned, or evaluated since.
+Splitting a large program into several functions then only re-evaluates
+the functions affected by an update.
+
+Note
+----
+Each evaluation records the variables it reads, whatever the sources
+passed when creating the function.
+Evaluating a function counts as a modification of its targets and of the
+intermediate variables it reads.
+If it is not skipped and no expression changed, only the variables reading
+a modified variable, and the variables downstream of them, are evaluated.
+Likewise, `push_tangent` only pushes the tangents through the variables
+affected by the values and derivatives set since its last call, unless
+another sweep wrote derivatives in the meantime.
+
+Examples
+--------
+>>> f = Function(u, sources=(x, y))
+
+>>> f.incremental = True
+
+>>> f.evaluate()
+
+>>> f.evaluate()  # skipped
+
+>>> x.set(..)
+
+>>> f.evaluate()  # re-evaluated)doc");
+
+    function.def_property_readonly("sources", &Function::sources,
+        R"doc(The source variables passed when creating the function.)doc");
+
+    function.def_property_readonly("targets", &Function::targets,
+        R"doc(The target variables passed when creating the function.)doc");
+
+    function.def("profile", &Function::setProfiling,
+        py::arg("enabled") = true,
+        R"doc(Start or stop profiling the operations during sweeps.
+
+Enabling the profiler discards any previous profile.
+While enabled, the evaluation and differentiation of every operation
+records its wall time, call count, output shape and the number of bytes
+written to its value or derivative.
+Disabling keeps the recorded profile for `stats` and `trace`.
+
+Note
+----
+Times are self times, excluding nested operations (and variables, which
+only return their cached values and derivatives).
+When disabled, profiling has no measurable overhead.
+
+Examples
+--------
+>>> f.profile()
+
+>>> f.evaluate()
+
+>>> f.pull_gradient_at(y)
+
+>>> f.profile(False)
+
+>>> f.stats()["operations"])doc");
+
+    function.def("stats", &detail::stats,
+        R"doc(Returns the profile recorded since `profile` was enabled.
+
+Returns
+-------
+dict
+    With keys "operations" (a dict mapping operation types to statistics
+    summed over their nodes) and "nodes" (a list of dicts with the
+    "operation" type and the "shape" of the value of each node).
+    The statistics of each sweep ("evaluate", "push_tangent", or
+    "pull_gradient") are dicts with the number of "calls", the total
+    "time" in seconds, and the number of "bytes" written.)doc");
+
+    function.def("memory_report", &detail::memoryReport,
+        R"doc(Returns the memory held by the function, for capacity planning.
+
+The operations and variables are those of the graph of the function, with
+the current sizes of the values and derivatives.
+The cache buffers are those seen during the sweeps recorded since `profile`
+was enabled (with `retain_cache`, both of the last sweeps).
+
+Returns
+-------
+dict
+    With keys "operations" (a dict mapping operation types to their number
+    of nodes), "variables" (the number of variables read by the operations
+    or passed at construction), "value_bytes" and "derivative_bytes" (held
+    by these variables), "cache_bytes" (held by the cache buffers of the
+    operations after the last sweep), "peak_bytes" (a dict with the peak of
+    the cache buffers during each sweep, "evaluate", "push_tangent", and
+    "pull_gradient"), "levels" (the number of levels of variables that
+    depend on each other, see `threads`), and "widest_level" (the largest
+    number of variables in one level, which can be evaluated in parallel).
+    Without a profile, "cache_bytes" and "peak_bytes" are None.
+    If a variable of the graph was not created from Python, the operations
+    and variables are those seen by the profiled sweeps and "levels" and
+    "widest_level" are None.
+
+Raises
+------
+RuntimeError
+    If the graph is not known and the function has never been profiled.
+
+Examples
+--------
+>>> f.profile()
+
+>>> f.evaluate()
+
+>>> f.pull_gradient_at(y)
+
+>>> f.memory_report()["peak_bytes"]["pull_gradient"])doc");
+
+    function.def("trace", &detail::trace,
+        R"doc(Returns the profile as a trace in the Chrome trace event format.
+
+Write it to a JSON file to view it with a trace viewer,
+e.g. chrome://tracing or https://ui.perfetto.dev.
+
+Examples
+--------
+>>> with open("trace.json", "w") as file:
+...     json.dump(f.trace(), file))doc");
+
+    function.def(
+        "evaluate",
+        [](Function& function) {
+            detail::run(function, &Function::evaluate);
+        },
         R"doc(Evaluate the target and intermediate variables.
 
 Before the first evaluation, the function is automatically compiled if
@@ -235,7 +1105,11 @@ Raises
 RuntimeError
     If the corresponding program has cyclic dependencies.)doc");
 
-    function.def("push_tangent", &Function::pushTangent,
+    function.def(
+        "push_tangent",
+        [](Function& function) {
+            detail::run(function, &Function::pushTangent);
+        },
         R"doc(Forward-mode automatic differentiation.
 
 Computes the tangent vectors at target and intermediate variables
@@ -270,7 +1144,12 @@ Raises
 RuntimeError
     If the corresponding program has cyclic dependencies.)doc");
 
-    function.def("push_tangent_at", &Function::pushTangentAt, py::arg("seed"),
+    function.def(
+        "push_tangent_at",
+        [](Function& function, AbstractVariable const& seed) {
+            detail::run(function, &Function::pushTangentAt, seed);
+        },
+        py::arg("seed"),
         R"doc(Forward-mode automatic differentiation with seed.
 
 Differentiates the target and intermediate variables of the function
@@ -298,6 +1177,9 @@ Examples
 Note
 ----
 Before calling this, the function must be evaluated.
+The seed of an array variable with n elements is a dense n × n identity,
+so this takes O(n²) time and memory per variable and operation, even for
+element-wise functions; use `jvp` for single directions instead.
 
 Raises
 ------
@@ -306,7 +1188,11 @@ RuntimeError
 RuntimeError
     If the seed is not an actual source of the function.)doc");
 
-    function.def("pull_gradient", &Function::pullGradient,
+    function.def(
+        "pull_gradient",
+        [](Function& function) {
+            detail::run(function, &Function::pullGradient);
+        },
         R"doc(Reverse-mode automatic differentiation (backpropagation).
 
 Computes the gradients with respect to source and intermediate variables
@@ -339,7 +1225,12 @@ Raises
 RuntimeError
     If the corresponding program has cyclic dependencies.)doc");
 
-    function.def("pull_gradient_at", &Function::pullGradientAt, py::arg("seed"),
+    function.def(
+        "pull_gradient_at",
+        [](Function& function, AbstractVariable const& seed) {
+            detail::run(function, &Function::pullGradientAt, seed);
+        },
+        py::arg("seed"),
         R"doc(Reverse-mode automatic differentiation (backpropagation) with seed.
 
 Differentiates the specified target variable (seed) with respect
@@ -374,4 +1265,610 @@ RuntimeError
     If the corresponding program has cyclic dependencies.
 RuntimeError
     If the seed is not a target of the function.)doc");
+
+    constexpr auto asyncNote = R"doc(
+
+Returns
+-------
+concurrent.futures.Future
+    Completes with None, or with the exception raised by the sweep.
+    Use `asyncio.wrap_future` to await it in a coroutine.
+
+Note
+----
+The sweep runs on a background thread without holding the GIL, after all
+asynchronous sweeps submitted before (of any function).
+Until the future is done, the variables of the function (its sources,
+targets, and the variables in between) cannot be modified with `set`,
+`assign`, or `set_derivative`, and their values and derivatives must not
+be read.
+Synchronous sweeps of the function wait for its asynchronous ones.)doc";
+    auto const asyncDoc = [&](char const* summary) {
+        return std::string(summary) + asyncNote;
+    };
+
+    function.def(
+        "evaluate_async",
+        [](py::object self) {
+            return detail::runAsync(
+                std::move(self), py::none(), &Function::evaluate);
+        },
+        asyncDoc(R"doc(Evaluate the function in the background.)doc").c_str());
+
+    function.def(
+        "push_tangent_async",
+        [](py::object self) {
+            return detail::runAsync(
+                std::move(self), py::none(), &Function::pushTangent);
+        },
+        asyncDoc(R"doc(Forward-mode differentiation in the background (see
+`push_tangent`).)doc").c_str());
+
+    function.def(
+        "pull_gradient_async",
+        [](py::object self) {
+            return detail::runAsync(
+                std::move(self), py::none(), &Function::pullGradient);
+        },
+        asyncDoc(R"doc(Reverse-mode differentiation in the background (see
+`pull_gradient`).)doc").c_str());
+
+    function.def(
+        "push_tangent_at_async",
+        [](py::object self, py::object seed) {
+            auto const* variable = &seed.cast<AbstractVariable const&>();
+            return detail::runAsync(std::move(self), std::move(seed),
+                [variable](Function& function) {
+                    function.pushTangentAt(*variable);
+                });
+        },
+        py::arg("seed"),
+        asyncDoc(R"doc(Forward-mode differentiation with seed in the
+background (see `push_tangent_at`).)doc").c_str());
+
+    function.def(
+        "pull_gradient_at_async",
+        [](py::object self, py::object seed) {
+            auto const* variable = &seed.cast<AbstractVariable const&>();
+            return detail::runAsync(std::move(self), std::move(seed),
+                [variable](Function& function) {
+                    function.pullGradientAt(*variable);
+                });
+        },
+        py::arg("seed"),
+        asyncDoc(R"doc(Reverse-mode differentiation with seed in the
+background (see `pull_gradient_at`).)doc").c_str());
+
+    function.def("jvp", &detail::jvp, py::arg("directions"),
+        R"doc(Jacobian-vector product (forward mode).
+
+Propagates a single tangent direction instead of the full Jacobian matrix,
+so every variable stores a derivative with one column (J·v) rather than
+one column per element of the seed.
+
+Parameters
+----------
+directions : dict of Variable to np.ndarray
+             Maps source variables to tangent directions of the same shape
+             as their values.
+             Sources passed when creating the function that are missing
+             from the dict get a zero direction.
+
+Examples
+--------
+>>> x = var(np.array([1., 2., 3.]))
+
+>>> y = var(x * x)
+
+>>> f = Function(y)
+
+>>> f.jvp({x: np.array([1., 0., 0.])})
+
+>>> d(y)  # J·v = [[2.], [0.], [0.]]
+
+Note
+----
+Before calling this, the function must be evaluated.
+Flattened in column-major order, matrix directions become tangent columns.
+All actual sources of the function must either be in `directions` or have
+been passed as sources when creating the function.
+
+Raises
+------
+ValueError
+    If a direction does not have the shape of the variable value.
+RuntimeError
+    If the corresponding program has cyclic dependencies.)doc");
+
+    function.def("vjp", &detail::vjp, py::arg("directions"),
+        R"doc(Vector-Jacobian product (reverse mode).
+
+Propagates a single gradient direction instead of the full Jacobian matrix,
+so every variable stores a derivative with one row (wᵀ·J) rather than
+one row per element of the seed.
+
+Parameters
+----------
+directions : dict of Variable to np.ndarray
+             Maps target variables to gradient directions of the same shape
+             as their values.
+             Targets missing from the dict get a zero direction.
+
+Examples
+--------
+>>> x = var(np.array([1., 2., 3.]))
+
+>>> y = var(x * x)
+
+>>> f = Function(y)
+
+>>> f.vjp({y: np.array([1., 1., 1.])})
+
+>>> d(x)  # wᵀ·J = [[2., 4., 6.]]
+
+Note
+----
+Before calling this, the function must be evaluated.
+Flattened in column-major order, matrix directions become gradient rows.
+
+Raises
+------
+ValueError
+    If a direction does not have the shape of the variable value.
+RuntimeError
+    If the corresponding program has cyclic dependencies.)doc");
+
+    function.def("hvp", &detail::hvp, py::arg("seed"), py::arg("directions"),
+        R"doc(Hessian-vector product H·v of a scalar target.
+
+Forward-over-reverse: pushes the tangents v of the sources through the graph,
+then pulls the gradient of the seed back together with its tangent, which is
+the product.
+The results are exact second derivatives (no finite differences) and take
+the time of a few sweeps, without forming the Hessian matrix.
+
+Parameters
+----------
+seed : Variable
+       Scalar target of the function.
+directions : dict of Variable to np.ndarray
+             Maps sources passed when creating the function to tangent
+             directions of the same shape as their values.
+             Sources missing from the dict get a zero direction.
+
+Examples
+--------
+>>> x = var(np.array([1., 2.]))
+
+>>> y = var(squared_norm(x * x))  # sum of x⁴
+
+>>> f = Function(y, sources=(x,))
+
+>>> f.hvp(y, {x: np.array([1., 0.])})
+
+>>> d(x)  # H·v = [[12., 0.]]
+
+Note
+----
+The function is evaluated first, at the current values of the sources.
+The products are stored as gradient rows in the derivatives of the sources;
+the derivatives of the other variables are unchanged.
+All variables of the graph must be created from Python. The operations of
+the scalar and array modules are supported, except for the broadcasting of
+scalar expressions (e.g. vector * scalar expression).
+
+Raises
+------
+ValueError
+    If the seed is not a scalar target, if a direction is not given for a
+    source or does not have the shape of the variable value, or if an
+    operation of the graph does not support second derivatives.
+RuntimeError
+    If the graph of the function is not known.)doc");
+
+    function.def("jacobian", &detail::jacobian, py::kw_only(),
+        py::arg("sources") = py::none(), py::arg("targets") = py::none(),
+        py::arg("mode") = "auto",
+        R"doc(Jacobian matrix of the targets with respect to the sources.
+
+Seeds all sources at once with a block of unit tangents (forward mode) or all
+targets at once with a block of unit gradients (reverse mode), so the whole
+matrix takes a single sweep through the graph.
+
+Parameters
+----------
+sources : tuple of Variable, optional
+          Defaults to the sources passed when creating the function.
+targets : tuple of Variable, optional
+          Defaults to the targets of the function.
+mode : {'auto', 'forward', 'reverse'}, optional
+       With 'auto', uses forward mode if the sources have no more elements
+       than the targets, and reverse mode otherwise.
+
+Returns
+-------
+np.ndarray
+    Matrix with one row per target element and one column per source
+    element, with the variables in the given order and matrices flattened in
+    column-major order.
+
+Examples
+--------
+>>> x = var(np.array([1., 2.]))
+
+>>> y = var(3.)
+
+>>> z = var(x * y)
+
+>>> f = Function(z, sources=(x, y))
+
+>>> f.evaluate()
+
+>>> f.jacobian()  # [[3., 0., 1.], [0., 3., 2.]]
+
+Note
+----
+Before calling this, the function must be evaluated.
+Afterwards, the variables keep the derivatives of the sweep.
+The derivatives of the scalar and lanes modules hold a single direction, so
+their variables are swept once per element instead.
+All actual sources of the function must either be in `sources` or have been
+passed as sources when creating the function (forward mode).
+
+Raises
+------
+ValueError
+    If there are no sources or the mode is invalid.
+RuntimeError
+    If the corresponding program has cyclic dependencies.)doc");
+
+    function.def("evaluate_batch", &detail::evaluateBatch, py::arg("inputs"),
+        py::kw_only(), py::arg("outputs"),
+        R"doc(Evaluate the function for a batch of input values.
+
+For each index along the first axis of the input batches,
+the values of the input variables are set and the function is evaluated.
+The values of the output variables are collected in NumPy arrays
+stacking them along the first axis.
+The loop runs entirely in C++, avoiding the overhead of calling `set` and
+`evaluate` from Python for each set of inputs.
+
+Parameters
+----------
+inputs : dict of Variable to np.ndarray
+         Maps the input variables to their stacked values.
+         All batches must have the same length along the first axis.
+outputs : tuple of Variable
+          The variables whose values are collected, e.g., the targets.
+
+Returns
+-------
+tuple of np.ndarray
+    The stacked values of the output variables.
+
+Examples
+--------
+>>> x = var(np.zeros(3))
+
+>>> y = var(2 * x)
+
+>>> f = Function(y)
+
+>>> X = np.random.rand(1000, 3)   # 1000 input vectors
+
+>>> Y, = f.evaluate_batch({x: X}, outputs=(y,))
+
+>>> Y.shape                       # (1000, 3)
+
+Note
+----
+The values are written to the input variables in place, so the inputs
+keep the last values of the batch.
+
+Raises
+------
+ValueError
+    If no input batches are given, or if they have mismatching lengths
+    or the wrong number of dimensions.
+RuntimeError
+    If the corresponding program has cyclic dependencies.)doc");
+
+    auto group = py::class_<FunctionGroup>(module, "FunctionGroup");
+
+    group.doc() = R"doc(Independent functions that run in parallel.
+
+A group evaluates or differentiates its functions at the same time on a pool
+of worker threads, without holding the GIL.
+Use it for programs with wide independent branches, such as per-sensor
+sub-models, by creating one function per branch and one function joining
+the branches.
+
+Note
+----
+The functions of a group must not share any variables, not even sources or
+literals; the sweeps raise a ValueError otherwise, since the functions would
+write to the same variables at the same time.
+Variables connecting the branches with the rest of the program should be
+sources or targets of separate functions, see the example below.
+The sweeps first wait for asynchronous sweeps of the functions.
+
+Examples
+--------
+>>> xs = [var(..) for _ in range(8)]      # inputs of the branches
+
+>>> ys = [var(model(x)) for x in xs]      # independent branches
+
+>>> loss = var(combine(ys))               # joins the branches
+
+>>> group = FunctionGroup([Function(y) for y in ys], threads=8)
+
+>>> total = Function(loss, sources=tuple(ys))
+
+>>> group.evaluate()                      # forward: branches first...
+
+>>> total.evaluate()                      # ...then the join
+
+>>> total.pull_gradient_at(loss)          # reverse: join first...
+
+>>> group.pull_gradient()                 # ...then the branches)doc";
+
+    group.def(py::init<>([](py::iterable const& functions,
+                             std::size_t threads) {
+        auto pointers = std::vector<Function*>{};
+        for (auto const& function : functions) {
+            pointers.push_back(&function.cast<Function&>());
+        }
+        return std::make_unique<FunctionGroup>(std::move(pointers), threads);
+    }),
+        py::arg("functions"), py::kw_only(), py::arg("threads") = 0,
+        py::keep_alive<1, 2>(),
+        R"doc(Create a group of functions running in parallel.
+
+Parameters
+----------
+functions : iterable of Function
+            Functions that share no variables.
+threads : int, optional
+          The number of worker threads.
+          Defaults to the number of hardware threads.
+
+Raises
+------
+ValueError
+    If the graphs of two functions share a variable.)doc");
+
+    group.def_property_readonly("threads", &FunctionGroup::threads,
+        R"doc(The number of worker threads.)doc");
+
+    group.def("evaluate", &FunctionGroup::evaluate,
+        py::call_guard<py::gil_scoped_release>(),
+        R"doc(Evaluate all functions in parallel.
+
+See `Function.evaluate`.)doc");
+
+    group.def("push_tangent", &FunctionGroup::pushTangent,
+        py::call_guard<py::gil_scoped_release>(),
+        R"doc(Forward-mode differentiation of all functions in parallel.
+
+See `Function.push_tangent`.)doc");
+
+    group.def("pull_gradient", &FunctionGroup::pullGradient,
+        py::call_guard<py::gil_scoped_release>(),
+        R"doc(Reverse-mode differentiation of all functions in parallel.
+
+See `Function.pull_gradient`.)doc");
+
+    auto graph = py::class_<Graph>(module, "Graph");
+
+    graph.doc() = R"doc(Allocates the expressions created in its context from an arena.
+
+By default, every operation allocates a few small objects on the heap.
+Inside a `with Graph():` block, these objects are bump-allocated from
+large memory blocks instead, which speeds up the construction and
+destruction of graphs with many nodes.
+The blocks are freed in one step once all expressions and variables
+created in the context have been destroyed.
+
+Examples
+--------
+>>> with Graph() as graph:
+...     x = var(1.0)
+...     for _ in range(100_000):
+...         x = var(sin(x) * 0.5 + x)
+
+>>> graph.allocated  # bytes allocated from the arena
+
+Note
+----
+The memory of the arena is only released when *all* of its objects are
+gone, so a single long-lived variable keeps the whole arena alive.
+The variable nodes themselves are still allocated by the AutoDiff library.
+A graph must be entered and exited on the same thread.)doc";
+
+    graph.def(py::init<std::size_t>(),
+        py::arg("block_size") = AutoDiff::Python::Arena::defaultBlockSize,
+        R"doc(Create an arena allocating memory in blocks of the given size.
+
+Parameters
+----------
+block_size : int, optional
+             The size of the memory blocks in bytes.)doc");
+
+    graph.def(
+        "__enter__",
+        [](Graph& graph) -> Graph& {
+            graph.enter();
+            return graph;
+        },
+        py::return_value_policy::reference_internal);
+
+    graph.def("__exit__",
+        [](Graph& graph, py::args const& /*exception*/) { graph.exit(); });
+
+    graph.def_property_readonly(
+        "allocated",
+        [](Graph const& graph) { return graph.arena().allocated(); },
+        R"doc(The number of bytes allocated from the arena.)doc");
+
+    graph.def_property_readonly(
+        "reserved",
+        [](Graph const& graph) { return graph.arena().reserved(); },
+        R"doc(The number of bytes reserved in memory blocks.)doc");
+
+    graph.def_property_readonly("objects", &Graph::objects,
+        R"doc(The number of objects allocated from the arena that are alive.
+
+The memory blocks are freed when this is zero and the graph is destroyed.)doc");
+
+    auto tape = py::class_<Tape>(module, "Tape");
+
+    tape.doc() = R"doc(Records how the expressions created in its context are built.
+
+A scalar function whose graph was created inside a `with Tape():` block
+can be lowered to a `TapeFunction`, or saved to a file and loaded again
+without running the Python code that built it, e.g., to start a service
+without importing the model code.
+The file stores the instructions of the `TapeFunction` (opcodes and
+operand slots) as aligned arrays, which are mapped into memory and run
+directly when loading, without creating a graph.
+
+Examples
+--------
+>>> with Tape() as tape:
+...     x = var(1.0)
+...     y = var(sin(x) * x)
+
+>>> tape.save("f.tape", Function(y, sources=(x,)))
+
+>>> f = Tape.load("f.tape")
+
+>>> x, = f.sources
+
+>>> y, = f.targets
+
+Note
+----
+Only the operations of autodiff modules are recorded; variables created
+outside the context, e.g. parameters, must be created inside it as well.
+The values of literal variables are saved as they are when saving.
+A tape must be entered and exited on the same thread.)doc";
+
+    tape.def(py::init<>(), R"doc(Create an empty tape.)doc");
+
+    tape.def(
+        "__enter__",
+        [](Tape& tape) -> Tape& {
+            tape.enter();
+            return tape;
+        },
+        py::return_value_policy::reference_internal);
+
+    tape.def("__exit__",
+        [](Tape& tape, py::args const& /*exception*/) { tape.exit(); });
+
+    tape.def(
+        "save",
+        [](py::object const& tape, py::object const& path,
+            py::object const& function) {
+            detail::tapeFunctionClass()(tape, function).attr("save")(path);
+        },
+        py::arg("path"), py::arg("function"),
+        R"doc(Save the graph of a scalar function to a file.
+
+Equivalent to `TapeFunction(tape, function).save(path)`.
+
+Parameters
+----------
+path : str or os.PathLike
+       The file to write.
+function : Function
+           A function whose graph (including its sources) was created
+           in the context of this tape.
+
+Raises
+------
+RuntimeError
+    If part of the graph was not recorded on this tape.
+ValueError
+    If the graph has variables that are not scalar, or operations that are
+    not scalar instructions (see `TapeFunction`).)doc");
+
+    tape.def_static(
+        "load",
+        [](py::object const& path) {
+            return detail::tapeFunctionClass().attr("load")(path);
+        },
+        py::arg("path"),
+        R"doc(Load a function saved with `save`.
+
+Equivalent to `TapeFunction.load(path)`: the instructions are run
+directly on the mapped file, without creating a graph.
+
+Parameters
+----------
+path : str or os.PathLike
+       The file to read.
+
+Returns
+-------
+A `TapeFunction` with new source and target variables, accessible via
+`TapeFunction.sources` and `TapeFunction.targets`.
+The sources have the values they had when saving, and the targets are
+evaluated.
+
+Raises
+------
+RuntimeError
+    If the file is not a valid tape, e.g. if an opcode is unknown or a slot
+    is out of range.)doc");
+
+    module.def("checkpoint_vjp", &detail::checkpointVjp, py::arg("step"),
+        py::arg("state"), py::arg("steps"), py::arg("direction"),
+        py::kw_only(), py::arg("parameters") = py::tuple(),
+        py::arg("every") = 0,
+        R"doc(Vector-Jacobian product of a long loop with bounded memory.
+
+Applies `step` to the state `steps` times and propagates the gradient
+direction of the final state back to the initial state and the parameters.
+Instead of keeping the variables of all steps, only the states of every
+`every`-th step are kept as checkpoints, and the variables of one segment
+between checkpoints are recomputed at a time during the reverse sweep.
+With the default of every √steps steps, the memory grows with √steps
+instead of steps, at the cost of evaluating each step twice.
+
+Parameters
+----------
+step : callable
+       Maps a state variable to the variable of the next state,
+       e.g., `lambda x: var(x + a * sin(x))`.
+       Must not keep references to the variables it creates.
+state : Variable
+        The initial state (only its value is used).
+steps : int
+        The number of steps.
+direction : np.ndarray or float
+            The gradient direction of the final state, with the
+            shape of its value.
+parameters : tuple of Variable, optional
+             Variables used by `step` (other than the state)
+             whose derivatives are accumulated over all steps.
+every : int, optional
+        The number of steps between checkpoints, zero for √steps.
+
+Returns
+-------
+The value of the final state.
+The derivatives of `state` and `parameters` are set to wᵀ·J, as with
+`Function.vjp`.
+
+Examples
+--------
+>>> a = var(0.5)
+
+>>> x = var(1.0)
+
+>>> checkpoint_vjp(lambda x: var(x + a * sin(x)), x, 10_000, 1.0,
+...     parameters=(a,))
+
+>>> d(x), d(a)  # gradients of the final state)doc");
 }
@@ -6,8 +6,34 @@
 #ifndef SRC_COMMON_HPP
 #define SRC_COMMON_HPP
 
+#include <AutoDiff/Python/State.hpp>
 #include <pybind11/pybind11.h>
 
+#include <cstring>   // strcmp
+#include <stdexcept> // runtime_error
+
+// Define the core classes and functions, and create the global state
+// (for the autodiff._core module)
 void defCore(pybind11::module& module);
 
+// Use the core classes, functions, and global state of autodiff._core,
+// re-exported by the given module
+inline void importCore(pybind11::module& module)
+{
+    using AutoDiff::Python::detail::State;
+
+    auto const core    = pybind11::module_::import("autodiff._core");
+    auto const capsule = core.attr("_state").cast<pybind11::capsule>();
+    if (capsule.name() == nullptr
+        || std::strcmp(capsule.name(), State::capsuleName) != 0) {
+        throw std::runtime_error("Incompatible version of autodiff._core.");
+    }
+    AutoDiff::Python::detail::sharedState = capsule.get_pointer<State>();
+
+    for (auto const* name : {"Variable", "Function", "FunctionGroup", "Graph",
+             "Tape", "checkpoint_vjp"}) {
+        module.attr(name) = core.attr(name);
+    }
+}
+
 #endif // SRC_COMMON_HPP
@@ -0,0 +1,16 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "common.hpp"
+
+#include <pybind11/pybind11.h>
+
+PYBIND11_MODULE(MODULE_NAME, module)
+{
+    module.attr("__version__") = VERSION_INFO;
+    module.doc() = "Core classes and functions shared by all autodiff modules.";
+
+    defCore(module);
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_ABSTRACT_VARIABLE_HPP
+#define AUTODIFF_PYTHON_ABSTRACT_VARIABLE_HPP
+
+#include "State.hpp" // graph and value versions
+
+#include <AutoDiff/src/Core/AbstractVariable.hpp>
+#include <pybind11/numpy.h>
+
+#include <cstddef> // size_t
+#include <memory>  // shared_ptr
+#include <vector>
+
+namespace AutoDiff::Python {
+
+// Type-erased access to the values of variables from NumPy arrays.
+// Batches are C-contiguous arrays stacking values along the first axis.
+class AbstractVariable : public AutoDiff::AbstractVariable {
+public:
+    // NumPy data type of the value
+    [[nodiscard]] virtual auto _dtype() const -> pybind11::dtype = 0;
+
+    // NumPy shape of the value, empty for scalars
+    [[nodiscard]] virtual auto
+    _shape() const -> std::vector<pybind11::ssize_t> = 0;
+
+    // Assign the value at the given index of a batch
+    virtual void _assign(
+        pybind11::array const& batch, pybind11::ssize_t index) const = 0;
+
+    // Copy the value to the given index of a batch
+    virtual void _copyTo(
+        pybind11::array& batch, pybind11::ssize_t index) const = 0;
+
+    // Bytes held by the value and by the derivative
+    [[nodiscard]] virtual auto _valueBytes() const -> std::size_t      = 0;
+    [[nodiscard]] virtual auto _derivativeBytes() const -> std::size_t = 0;
+
+    // Value version of the last modification, zero if never modified
+    [[nodiscard]] virtual auto _modified() const -> std::size_t = 0;
+
+    // Record a modification of the value (done by `set` and `assign`)
+    virtual void _touch() const = 0;
+
+    // Status shared with the expressions reading the variable
+    [[nodiscard]] virtual auto _status() const
+        -> std::shared_ptr<detail::VariableStatus> const& = 0;
+
+    // Set the derivative to a single tangent (column) or gradient (row),
+    // given as a C-contiguous array of the same shape as the value
+    virtual void _setDirection(
+        pybind11::array const& direction, bool tangent) const = 0;
+
+    // Set the derivative to `count` tangents (columns) or gradients (rows),
+    // seeding the flattened value elements with the unit directions
+    // `offset`, `offset + 1`, etc. (zero for directions out of range).
+    // Returns false if the derivative holds a single direction per element.
+    virtual auto _setSeed(pybind11::ssize_t offset, pybind11::ssize_t count,
+        bool tangent) const -> bool
+        = 0;
+
+    // Set the derivative to the identity map, seeding `count` directions,
+    // or to zero of the same dimensions (single directions for scalar and
+    // lanes derivatives)
+    virtual void _seed(
+        bool identity, pybind11::ssize_t count, bool tangent) const = 0;
+};
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_ABSTRACT_VARIABLE_HPP
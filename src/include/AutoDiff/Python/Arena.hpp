@@ -0,0 +1,180 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_ARENA_HPP
+#define AUTODIFF_PYTHON_ARENA_HPP
+
+#include "State.hpp"
+
+#include <algorithm> // count, max
+#include <cstddef>   // byte, size_t
+#include <memory>
+#include <stdexcept> // logic_error
+#include <utility> // exchange, forward, move
+#include <vector>
+
+namespace AutoDiff::Python {
+
+// Bump allocator for many small, long-lived objects.
+// Individual deallocations are no-ops; all memory is freed with the arena.
+// Not thread-safe.
+class Arena {
+public:
+    explicit Arena(std::size_t blockSize = defaultBlockSize)
+        : mBlockSize{std::max(blockSize, std::size_t{1})}
+    {
+    }
+
+    [[nodiscard]] auto allocate(std::size_t size, std::size_t alignment)
+        -> void*
+    {
+        auto* pointer = static_cast<void*>(mNext);
+        auto space    = mRemaining;
+        if (std::align(alignment, size, pointer, space) == nullptr) {
+            addBlock(std::max(mBlockSize, size + alignment));
+            pointer = mNext;
+            space   = mRemaining;
+            std::align(alignment, size, pointer, space); // fits
+        }
+        mNext      = static_cast<std::byte*>(pointer) + size;
+        mRemaining = space - size;
+        mAllocated += size;
+        return pointer;
+    }
+
+    // bytes handed out so far
+    [[nodiscard]] auto allocated() const -> std::size_t { return mAllocated; }
+
+    // bytes reserved in blocks
+    [[nodiscard]] auto reserved() const -> std::size_t { return mReserved; }
+
+    static constexpr std::size_t defaultBlockSize = 64 * 1024;
+
+private:
+    void addBlock(std::size_t size)
+    {
+        mBlocks.push_back(std::make_unique<std::byte[]>(size));
+        mNext      = mBlocks.back().get();
+        mRemaining = size;
+        mReserved += size;
+    }
+
+    std::size_t mBlockSize;
+    std::vector<std::unique_ptr<std::byte[]>> mBlocks;
+    std::byte* mNext       = nullptr;
+    std::size_t mRemaining = 0;
+    std::size_t mAllocated = 0;
+    std::size_t mReserved  = 0;
+};
+
+// Allocator sharing ownership of its arena, so that the arena lives as long
+// as any object (e.g., a shared_ptr control block) allocated from it
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena) noexcept
+        : mArena{std::move(arena)}
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(ArenaAllocator<U> const& other) noexcept // NOLINT
+        : mArena{other.arena()}
+    {
+    }
+
+    [[nodiscard]] auto allocate(std::size_t n) -> T*
+    {
+        return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* /*pointer*/, std::size_t /*n*/) noexcept { }
+
+    [[nodiscard]] auto arena() const -> std::shared_ptr<Arena> const&
+    {
+        return mArena;
+    }
+
+    template <typename U>
+    friend auto operator==(
+        ArenaAllocator const& lhs, ArenaAllocator<U> const& rhs) -> bool
+    {
+        return lhs.mArena == rhs.arena();
+    }
+
+    template <typename U>
+    friend auto operator!=(
+        ArenaAllocator const& lhs, ArenaAllocator<U> const& rhs) -> bool
+    {
+        return !(lhs == rhs);
+    }
+
+private:
+    std::shared_ptr<Arena> mArena;
+};
+
+namespace detail {
+
+// make_shared, but allocated from the current arena if there is one
+template <typename T, typename... Args>
+auto makeShared(Args&&... args) -> std::shared_ptr<T>
+{
+    // arena for the evaluators of new expressions on this thread, if any
+    if (auto const& arena = threadState().arena) {
+        return std::allocate_shared<T>(
+            ArenaAllocator<T>{arena}, std::forward<Args>(args)...);
+    }
+    return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+} // namespace detail
+
+// Arena that is current while entered, e.g. as Python context manager.
+// Entering and exiting can be nested but must happen on the same thread.
+class Graph {
+public:
+    explicit Graph(std::size_t blockSize = Arena::defaultBlockSize)
+        : mArena{std::make_shared<Arena>(blockSize)}
+    {
+    }
+
+    void enter()
+    {
+        mPrevious.push_back(std::exchange(detail::threadState().arena, mArena));
+    }
+
+    void exit()
+    {
+        if (mPrevious.empty()) {
+            throw std::logic_error("Graph has not been entered.");
+        }
+        detail::threadState().arena = std::move(mPrevious.back());
+        mPrevious.pop_back();
+    }
+
+    [[nodiscard]] auto arena() const -> Arena const& { return *mArena; }
+
+    // Number of objects allocated from the arena that are still alive.
+    // Each of them shares ownership of the arena through its allocator.
+    [[nodiscard]] auto objects() const -> long
+    {
+        auto owners = long{1}; // the graph
+        owners += std::count(mPrevious.begin(), mPrevious.end(), mArena);
+        if (detail::threadState().arena == mArena) {
+            ++owners; // entered
+        }
+        return mArena.use_count() - owners;
+    }
+
+private:
+    std::shared_ptr<Arena> mArena;
+    std::vector<std::shared_ptr<Arena>> mPrevious;
+};
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_ARENA_HPP
@@ -0,0 +1,222 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_BUFFER_POOL_HPP
+#define AUTODIFF_PYTHON_BUFFER_POOL_HPP
+
+#include <algorithm>   // find
+#include <cstddef>     // ptrdiff_t, size_t
+#include <iterator>    // next
+#include <memory>      // make_unique, unique_ptr
+#include <mutex>
+#include <type_traits> // enable_if_t, false_type, true_type, void_t
+#include <utility>     // move
+#include <vector>
+
+namespace AutoDiff::Python {
+
+namespace detail {
+
+class AbstractBufferPool {
+public:
+    virtual ~AbstractBufferPool() = default;
+
+    // frees all buffers kept
+    virtual void clear() = 0;
+};
+
+// Pools of all threads (of this module), one per buffer type and thread,
+// registered while their thread runs
+struct PoolRegistry {
+    std::mutex mutex;
+    std::vector<AbstractBufferPool*> pools;
+};
+
+// never destroyed, since the pools of threads exiting during the shutdown
+// of the interpreter still unregister from it
+inline auto poolRegistry() -> PoolRegistry&
+{
+    static auto* const registry = new PoolRegistry{};
+    return *registry;
+}
+
+} // namespace detail
+
+// Thread-local free list of the (Eigen) buffers of released caches.
+// The caches of operations only live while the expression of one variable is
+// evaluated or differentiated, so recycling their buffers lets the
+// expressions of all variables of a graph share the memory of the largest
+// one, instead of allocating (and page-faulting) new memory for each.
+// Buffers are matched by their number of elements, which Eigen reuses when
+// resizing to a different shape of the same size.
+// The pool only recycles buffers at the release points of the caches; it does
+// not plan which buffers can be shared across a compiled graph.
+// Each pool is registered, so that any thread can clear the pools of all
+// threads (see clearBufferPools), including those of worker threads; its
+// mutex is only contended while it is cleared.
+template <typename Buffer>
+class BufferPool : public detail::AbstractBufferPool {
+public:
+    static constexpr std::size_t capacity = 32; // buffers kept per thread
+    static constexpr std::size_t maxBytes = std::size_t{64} << 20; // in total
+
+    BufferPool()
+    {
+        auto& registry  = detail::poolRegistry();
+        auto const lock = std::lock_guard{registry.mutex};
+        registry.pools.push_back(this);
+    }
+
+    ~BufferPool() override
+    {
+        auto& registry  = detail::poolRegistry();
+        auto const lock = std::lock_guard{registry.mutex};
+        auto& pools     = registry.pools;
+        pools.erase(std::find(pools.begin(), pools.end(), this));
+    }
+
+    BufferPool(BufferPool const&)                    = delete;
+    BufferPool(BufferPool&&)                         = delete;
+    auto operator=(BufferPool const&) -> BufferPool& = delete;
+    auto operator=(BufferPool&&) -> BufferPool&      = delete;
+
+    [[nodiscard]] static auto local() -> BufferPool&
+    {
+        thread_local auto pool = BufferPool{};
+        return pool;
+    }
+
+    // bytes of the buffers kept
+    [[nodiscard]] auto bytes() const -> std::size_t
+    {
+        auto const lock = std::lock_guard{mMutex};
+        return mBytes;
+    }
+
+    void clear() override
+    {
+        auto const lock = std::lock_guard{mMutex};
+        mBuffers.clear();
+        mBytes = 0;
+    }
+
+    // a recycled buffer with the given number of elements, or an empty one
+    [[nodiscard]] auto take(std::ptrdiff_t size) -> Buffer
+    {
+        auto const lock = std::lock_guard{mMutex};
+        for (auto it = mBuffers.rbegin(); it != mBuffers.rend(); ++it) {
+            if (it->size() == size) {
+                auto buffer = std::move(*it);
+                mBuffers.erase(std::next(it).base());
+                mBytes -= bytesOf(buffer);
+                return buffer;
+            }
+        }
+        return Buffer{};
+    }
+
+    // takes the storage of the buffer, leaving it empty; buffers beyond the
+    // limits are freed, the least recently released first
+    void give(Buffer& buffer)
+    {
+        auto const size = bytesOf(buffer);
+        if (size == 0 || size > maxBytes) {
+            buffer = Buffer{};
+            return;
+        }
+        auto const lock = std::lock_guard{mMutex};
+        while (mBuffers.size() == capacity || mBytes + size > maxBytes) {
+            mBytes -= bytesOf(mBuffers.front());
+            mBuffers.erase(mBuffers.begin());
+        }
+        mBuffers.push_back(std::move(buffer));
+        mBytes += size;
+        buffer = Buffer{};
+    }
+
+private:
+    static auto bytesOf(Buffer const& buffer) -> std::size_t
+    {
+        return static_cast<std::size_t>(buffer.size())
+            * sizeof(typename Buffer::Scalar);
+    }
+
+    std::vector<Buffer> mBuffers;
+    std::size_t mBytes = 0;
+    mutable std::mutex mMutex; // taken by the thread and by clearBufferPools
+};
+
+namespace detail {
+
+// Frees the buffers kept by the pools of all threads
+inline void clearBufferPools()
+{
+    auto& registry  = poolRegistry();
+    auto const lock = std::lock_guard{registry.mutex};
+    for (auto* pool : registry.pools) {
+        pool->clear();
+    }
+}
+
+// Buffers of dynamic size; scalars and fixed-size Eigen types are stored
+// inline and not pooled
+template <typename Buffer, typename = void>
+struct IsPooled : std::false_type { };
+
+template <typename Buffer>
+struct IsPooled<Buffer,
+    std::enable_if_t<(Buffer::SizeAtCompileTime < 0)>> : std::true_type { };
+
+// Releases a cache buffer, recycling its storage if pooled
+template <typename Buffer>
+void recycle(Buffer& buffer)
+{
+    if constexpr (!IsPooled<Buffer>::value) {
+        buffer = Buffer{};
+    } else {
+        BufferPool<Buffer>::local().give(buffer);
+    }
+}
+
+template <typename Buffer>
+void recycle(std::unique_ptr<Buffer>& cache)
+{
+    if (cache) {
+        recycle(*cache);
+        cache.reset();
+    }
+}
+
+// Gives an empty cache buffer the storage of a recycled one of the given
+// number of elements, if any, before it is resized and written to
+template <typename Buffer>
+void reuse(Buffer& buffer, std::ptrdiff_t size)
+{
+    if constexpr (IsPooled<Buffer>::value) {
+        if (buffer.size() == 0 && size != 0) {
+            buffer = BufferPool<Buffer>::local().take(size);
+        }
+    }
+}
+
+// new cache holding the result, in a recycled buffer if possible
+template <typename Buffer, typename Result>
+auto makeCache(Result const& result) -> std::unique_ptr<Buffer>
+{
+    if constexpr (!IsPooled<Buffer>::value || std::is_arithmetic_v<Result>) {
+        return std::make_unique<Buffer>(result);
+    } else {
+        auto cache = std::make_unique<Buffer>(
+            BufferPool<Buffer>::local().take(result.size()));
+        *cache = result;
+        return cache;
+    }
+}
+
+} // namespace detail
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_BUFFER_POOL_HPP
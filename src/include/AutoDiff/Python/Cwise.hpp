@@ -0,0 +1,1004 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_CWISE_HPP
+#define AUTODIFF_PYTHON_CWISE_HPP
+
+#include "BufferPool.hpp"
+#include "Evaluator.hpp" // detail::threadState
+#include "Expression.hpp"
+#include "ExpressionBinding.hpp"
+#include "Operation.hpp"
+
+#include <AutoDiff/src/Core/Expression.hpp>
+#include <Eigen/Core>
+
+#include <algorithm>   // min
+#include <cmath>       // log
+#include <optional>
+#include <stdexcept>   // invalid_argument
+#include <type_traits> // is_same_v
+#include <utility>     // move
+#include <vector>
+
+namespace AutoDiff::Python {
+
+// Element-wise functions; the binary ones take a scalar literal c
+enum class CwiseFunction {
+    Add,     // x + c
+    Cos,     //
+    Div,     // x / c
+    Exp,     //
+    Log,     //
+    Log1p,   // log(1 + x), accurate for small x
+    Max,     // maximum of x and zero
+    Min,     // minimum of x and zero
+    Mul,     // x * c
+    Neg,     // -x
+    Pow,     // x ^ c
+    RDiv,    // c / x
+    RPow,    // c ^ x
+    RSub,    // c - x
+    Sigmoid, // 1 / (1 + exp(-x))
+    Sin,     //
+    Sqrt,    //
+    Square,  //
+    Sub      // x - c
+};
+
+template <typename Scalar>
+struct CwiseStep {
+    CwiseFunction function;
+    Scalar constant = Scalar{0};
+};
+
+// Chain of element-wise functions of an array expression.
+// The chain is applied in a single pass over blocks of elements that fit into
+// the L1 cache, writing to one output buffer without intermediate arrays.
+// The Jacobian of an element-wise function is diagonal, so only its diagonal
+// (the partial derivatives) is stored. Tangents and gradients are scaled
+// row- or column-wise instead of being multiplied with a dense n⨉n matrix,
+// which makes differentiation O(n) per tangent or gradient direction.
+// Matrices are flattened in column-major order, consistent with derivatives.
+// For lane derivatives (of the same shape as the value), the scaling is
+// element-wise.
+template <typename Value, typename Derivative_>
+class CwiseOperation
+    : public AutoDiff::Expression<CwiseOperation<Value, Derivative_>> {
+public:
+    using Derivative = Derivative_;
+    using Operand    = ExpressionWrapper<Value, Derivative>;
+    using Scalar     = typename Value::Scalar;
+    using Step       = CwiseStep<Scalar>;
+    using Array      = Eigen::Array<Scalar, Eigen::Dynamic, 1>;
+
+    CwiseOperation(Step step, Operand operand)
+        : mSteps{step}
+        , mOperand{std::move(operand)}
+    {
+    }
+
+    [[nodiscard]] auto _valueImpl() -> Value const&
+    {
+        fuseOperand();
+        auto const& operand = mOperand._value();
+        mOperandValue       = &operand;
+        detail::reuse(mValue, operand.size());
+        mValue.resize(operand.rows(), operand.cols());
+        evaluate(operand.data(), operand.size(), mValue.data(), nullptr);
+        mHasPartials       = false; // operand might have changed
+        mHasSecondPartials = false;
+        return mValue;
+    }
+
+    [[nodiscard]] auto _pushForwardImpl() -> Derivative const&
+    {
+        auto const& partials = this->partials();
+        auto const& tangent  = mOperand._pushForward();
+        detail::reuse(mDerivative, tangent.size());
+        if constexpr (isLanes) {
+            mDerivative = partials * tangent;
+        } else {
+            mDerivative.noalias() = partials.matrix().asDiagonal() * tangent;
+        }
+        return mDerivative;
+    }
+
+    void _pullBackImpl(Derivative const& gradient)
+    {
+        auto const& partials = this->partials();
+        detail::reuse(mGradient, gradient.size());
+        if constexpr (isLanes) {
+            mGradient = gradient * partials;
+        } else {
+            mGradient.noalias() = gradient * partials.matrix().asDiagonal();
+        }
+        mOperand._pullBack(mGradient);
+    }
+
+    // Second-order sweep (see AbstractEvaluator::valueTangent), with the
+    // second derivatives q of the chain, by which the gradient g scales the
+    // tangent of the operand in the product.
+    [[nodiscard]] auto _valueTangent() -> Value const&
+    {
+        secondPartials();
+        auto const& tangent = mOperand._valueTangent();
+        detail::reuse(mTangent, tangent.size());
+        mTangent.resize(tangent.rows(), tangent.cols());
+        flat(mTangent) = mPartials * flat(tangent);
+        return mTangent;
+    }
+
+    void _pullBackSecond(Value const& gradient, Value const& product)
+    {
+        secondPartials();
+        auto const& tangent = mOperand._valueTangent();
+        detail::reuse(mGradientValue, gradient.size());
+        detail::reuse(mProduct, product.size());
+        mGradientValue.resize(gradient.rows(), gradient.cols());
+        mProduct.resize(product.rows(), product.cols());
+        flat(mGradientValue) = flat(gradient) * mPartials;
+        flat(mProduct)       = flat(product) * mPartials
+            + flat(gradient) * mSecondPartials * flat(tangent);
+        mOperand._pullBackSecond(mGradientValue, mProduct);
+    }
+
+    void _transferChildrenToImpl(internal::Node& node) const
+    {
+        mOperand._transferChildrenTo(node);
+    }
+
+    void _releaseCacheImpl() const
+    {
+        mHasPartials       = false;
+        mHasSecondPartials = false;
+        if (!detail::threadState().retainCache) {
+            mOperandValue = nullptr; // recycled by the operand
+            detail::recycle(mValue);
+            detail::recycle(mPartials);
+            detail::recycle(mScratch);
+            detail::recycle(mDerivative);
+            detail::recycle(mGradient);
+            detail::recycle(mSecondPartials);
+            detail::recycle(mTangent);
+            detail::recycle(mGradientValue);
+            detail::recycle(mProduct);
+        }
+        mOperand._releaseCache();
+    }
+
+private:
+    static constexpr Eigen::Index blockSize = 512;
+    static constexpr bool isLanes = std::is_same_v<Derivative, Array>;
+
+    // elements in column-major order
+    static auto flat(Value const& value) -> Eigen::Map<Array const>
+    {
+        return Eigen::Map<Array const>(value.data(), value.size());
+    }
+
+    static auto flat(Value& value) -> Eigen::Map<Array>
+    {
+        return Eigen::Map<Array>(value.data(), value.size());
+    }
+
+    // Absorbs the steps of operand chains that nothing else refers to (no
+    // other operation and no Python object), which can no longer be reused.
+    // Chains that are shared stay operations of their own, evaluated once.
+    void fuseOperand()
+    {
+        using Chain = Evaluator<CwiseOperation>;
+        while (mOperand.evaluator().use_count() == 1) {
+            auto const* chain
+                = dynamic_cast<Chain const*>(mOperand.evaluator().get());
+            if (chain == nullptr) {
+                return;
+            }
+            if (auto* profiler = detail::threadState().profiler) {
+                profiler->forget(chain);
+            }
+            auto const& inner = chain->expression();
+            mSteps.insert(
+                mSteps.begin(), inner.mSteps.begin(), inner.mSteps.end());
+            auto operand = inner.mOperand;
+            mOperand     = std::move(operand); // destroys the chain
+        }
+    }
+
+    // diagonal of the Jacobian matrix, evaluated at the operand's value
+    auto partials() -> Array const&
+    {
+        if (mHasPartials) {
+            return mPartials;
+        }
+        // evaluating the operand again would re-evaluate its whole subtree
+        auto const& operand
+            = mOperandValue != nullptr ? *mOperandValue : mOperand._value();
+        detail::reuse(mPartials, operand.size());
+        detail::reuse(mScratch, operand.size());
+        mPartials.resize(operand.size());
+        mScratch.resize(operand.size());
+        evaluate(operand.data(), operand.size(), mScratch.data(),
+            mPartials.data());
+        mHasPartials = true;
+        return mPartials;
+    }
+
+    // the partials and the second derivatives of the chain, for the
+    // second-order sweep
+    void secondPartials()
+    {
+        if (mHasSecondPartials) {
+            return;
+        }
+        auto const& operand = mOperandValue != nullptr
+            ? *mOperandValue
+            : mOperand._cachedValue();
+        auto const size = operand.size();
+        detail::reuse(mPartials, size);
+        detail::reuse(mSecondPartials, size);
+        detail::reuse(mScratch, size);
+        mPartials.resize(size);
+        mSecondPartials.resize(size);
+        mScratch.resize(size);
+        mStepPartials.resize(std::min(blockSize, size));
+        mStepSecondPartials.resize(std::min(blockSize, size));
+        evaluate(operand.data(), size, mScratch.data(), mPartials.data(),
+            mSecondPartials.data());
+        mHasPartials       = true;
+        mHasSecondPartials = true;
+    }
+
+    // y = f(x) and, if requested, the partials f'(x) and the second
+    // derivatives f''(x) by the chain rule
+    void evaluate(Scalar const* x, Eigen::Index size, Scalar* y,
+        Scalar* partials, Scalar* secondPartials = nullptr) const
+    {
+        for (auto start = Eigen::Index{0}; start < size; start += blockSize) {
+            auto const n = std::min(blockSize, size - start);
+            auto t       = Eigen::Map<Array>(y + start, n);
+            t            = Eigen::Map<Array const>(x + start, n);
+            if (partials == nullptr) {
+                for (auto const& step : mSteps) {
+                    apply(step, t);
+                }
+            } else if (secondPartials == nullptr) {
+                auto p = Eigen::Map<Array>(partials + start, n);
+                p.setOnes();
+                for (auto const& step : mSteps) {
+                    multiplyPartials(step, t, p);
+                    apply(step, t);
+                }
+            } else {
+                auto p  = Eigen::Map<Array>(partials + start, n);
+                auto q  = Eigen::Map<Array>(secondPartials + start, n);
+                auto d1 = Eigen::Map<Array>(mStepPartials.data(), n);
+                auto d2 = Eigen::Map<Array>(mStepSecondPartials.data(), n);
+                p.setOnes();
+                q.setZero();
+                for (auto const& step : mSteps) {
+                    derivatives(step, t, d1, d2);
+                    // (f∘g)'' = f'(g) g'' + f''(g) g'²
+                    q = q * d1 + p.square() * d2;
+                    p *= d1;
+                    apply(step, t);
+                }
+            }
+        }
+    }
+
+    static void apply(Step const& step, Eigen::Map<Array>& t)
+    {
+        auto const c = step.constant;
+        switch (step.function) {
+        case CwiseFunction::Add: t += c; break;
+        case CwiseFunction::Cos: t = t.cos(); break;
+        case CwiseFunction::Div: t /= c; break;
+        case CwiseFunction::Exp: t = t.exp(); break;
+        case CwiseFunction::Log: t = t.log(); break;
+        case CwiseFunction::Log1p: t = t.log1p(); break;
+        case CwiseFunction::Max: t = t.max(Scalar{0}); break;
+        case CwiseFunction::Min: t = t.min(Scalar{0}); break;
+        case CwiseFunction::Mul: t *= c; break;
+        case CwiseFunction::Neg: t = -t; break;
+        case CwiseFunction::Pow: t = t.pow(c); break;
+        case CwiseFunction::RDiv: t = c * t.inverse(); break;
+        case CwiseFunction::RPow: t = Eigen::pow(c, t); break;
+        case CwiseFunction::RSub: t = c - t; break;
+        case CwiseFunction::Sigmoid:
+            t = (Scalar{1} + (-t).exp()).inverse();
+            break;
+        case CwiseFunction::Sin: t = t.sin(); break;
+        case CwiseFunction::Sqrt: t = t.sqrt(); break;
+        case CwiseFunction::Square: t = t.square(); break;
+        case CwiseFunction::Sub: t -= c; break;
+        }
+    }
+
+    // p *= f'(t) for the input t of the step
+    static void multiplyPartials(
+        Step const& step, Eigen::Map<Array> const& t, Eigen::Map<Array>& p)
+    {
+        auto const c = step.constant;
+        switch (step.function) {
+        case CwiseFunction::Add:
+        case CwiseFunction::Sub: break;
+        case CwiseFunction::Cos: p *= -t.sin(); break;
+        case CwiseFunction::Div: p /= c; break;
+        case CwiseFunction::Exp: p *= t.exp(); break;
+        case CwiseFunction::Log: p *= t.inverse(); break;
+        case CwiseFunction::Log1p: p *= (Scalar{1} + t).inverse(); break;
+        case CwiseFunction::Max:
+            p *= (t > Scalar{0}).template cast<Scalar>();
+            break;
+        case CwiseFunction::Min:
+            p *= (t < Scalar{0}).template cast<Scalar>();
+            break;
+        case CwiseFunction::Mul: p *= c; break;
+        case CwiseFunction::Neg:
+        case CwiseFunction::RSub: p = -p; break;
+        case CwiseFunction::Pow: p *= c * t.pow(c - Scalar{1}); break;
+        case CwiseFunction::RDiv: p *= -c * t.square().inverse(); break;
+        case CwiseFunction::RPow: p *= Eigen::pow(c, t) * std::log(c); break;
+        case CwiseFunction::Sigmoid:
+            // s(t) (1 - s(t)) = s(t) s(-t), without overflow
+            p *= (Scalar{1} + (-t).exp()).inverse()
+                * (Scalar{1} + t.exp()).inverse();
+            break;
+        case CwiseFunction::Sin: p *= t.cos(); break;
+        case CwiseFunction::Sqrt: p *= Scalar{0.5} * t.rsqrt(); break;
+        case CwiseFunction::Square: p *= Scalar{2} * t; break;
+        }
+    }
+
+    // d1 = f'(t) and d2 = f''(t) for the input t of the step
+    static void derivatives(Step const& step, Eigen::Map<Array> const& t,
+        Eigen::Map<Array>& d1, Eigen::Map<Array>& d2)
+    {
+        auto const c = step.constant;
+        switch (step.function) {
+        case CwiseFunction::Add:
+        case CwiseFunction::Sub:
+            d1.setOnes();
+            d2.setZero();
+            break;
+        case CwiseFunction::Cos:
+            d1 = -t.sin();
+            d2 = -t.cos();
+            break;
+        case CwiseFunction::Div:
+            d1.setConstant(Scalar{1} / c);
+            d2.setZero();
+            break;
+        case CwiseFunction::Exp:
+            d1 = t.exp();
+            d2 = d1;
+            break;
+        case CwiseFunction::Log:
+            d1 = t.inverse();
+            d2 = -d1.square();
+            break;
+        case CwiseFunction::Log1p:
+            d1 = (Scalar{1} + t).inverse();
+            d2 = -d1.square();
+            break;
+        case CwiseFunction::Max:
+            d1 = (t > Scalar{0}).template cast<Scalar>();
+            d2.setZero();
+            break;
+        case CwiseFunction::Min:
+            d1 = (t < Scalar{0}).template cast<Scalar>();
+            d2.setZero();
+            break;
+        case CwiseFunction::Mul:
+            d1.setConstant(c);
+            d2.setZero();
+            break;
+        case CwiseFunction::Neg:
+        case CwiseFunction::RSub:
+            d1.setConstant(Scalar{-1});
+            d2.setZero();
+            break;
+        case CwiseFunction::Pow:
+            d1 = c * t.pow(c - Scalar{1});
+            d2 = c * (c - Scalar{1}) * t.pow(c - Scalar{2});
+            break;
+        case CwiseFunction::RDiv:
+            d1 = -c * t.square().inverse();
+            d2 = Scalar{2} * c * t.cube().inverse();
+            break;
+        case CwiseFunction::RPow:
+            d1 = Eigen::pow(c, t) * std::log(c);
+            d2 = d1 * std::log(c);
+            break;
+        case CwiseFunction::Sigmoid:
+            d2 = (Scalar{1} + (-t).exp()).inverse(); // s(t)
+            d1 = d2 * (Scalar{1} + t.exp()).inverse();
+            d2 = d1 * (Scalar{1} - Scalar{2} * d2);
+            break;
+        case CwiseFunction::Sin:
+            d1 = t.cos();
+            d2 = -t.sin();
+            break;
+        case CwiseFunction::Sqrt:
+            d1 = Scalar{0.5} * t.rsqrt();
+            d2 = Scalar{-0.5} * d1 / t;
+            break;
+        case CwiseFunction::Square:
+            d1 = Scalar{2} * t;
+            d2.setConstant(Scalar{2});
+            break;
+        }
+    }
+
+    std::vector<Step> mSteps; // applied in order
+    Operand mOperand;
+
+    // cache
+    mutable Value const* mOperandValue = nullptr; // of the last evaluation
+    mutable Value mValue;
+    mutable Array mPartials;
+    mutable Array mScratch; // intermediate values for the partials
+    mutable bool mHasPartials = false;
+    mutable Derivative mDerivative;
+    mutable Derivative mGradient; // passed on to the operand
+
+    // cache of the second-order sweep
+    mutable Array mSecondPartials;
+    mutable Array mStepPartials; // of a step, for a block of elements
+    mutable Array mStepSecondPartials;
+    mutable bool mHasSecondPartials = false;
+    mutable Value mTangent;
+    mutable Value mGradientValue; // passed on to the operand
+    mutable Value mProduct;
+};
+
+enum class CwiseBinaryFunction {
+    Add, // x + y
+    Div, // x / y
+    Mul, // x * y
+    Pow, // x ^ y
+    Sub  // x - y
+};
+
+// Element-wise function of two arrays of the same shape, one of which can be
+// a literal.
+// As for CwiseOperation, the Jacobians are diagonal and only their diagonals
+// are stored. Each operand gets its gradient from a single buffer reused by
+// both operands (and across sweeps if the cache is retained); sums and
+// differences pass the gradient on without scaling. Literals get no
+// derivatives.
+template <typename Value, typename Derivative_>
+class CwiseBinaryOperation
+    : public AutoDiff::Expression<CwiseBinaryOperation<Value, Derivative_>> {
+public:
+    using Derivative = Derivative_;
+    using Operand    = ExpressionWrapper<Value, Derivative>;
+    using Scalar     = typename Value::Scalar;
+    using Array      = Eigen::Array<Scalar, Eigen::Dynamic, 1>;
+
+    CwiseBinaryOperation(CwiseBinaryFunction function, Operand lhs, Operand rhs)
+        : mFunction{function}
+        , mLhs{std::move(lhs)}
+        , mRhs{std::move(rhs)}
+    {
+    }
+
+    CwiseBinaryOperation(CwiseBinaryFunction function, Operand lhs, Value rhs)
+        : mFunction{function}
+        , mLhs{std::move(lhs)}
+        , mRhsLiteral{std::move(rhs)}
+    {
+    }
+
+    CwiseBinaryOperation(CwiseBinaryFunction function, Value lhs, Operand rhs)
+        : mFunction{function}
+        , mRhs{std::move(rhs)}
+        , mLhsLiteral{std::move(lhs)}
+    {
+    }
+
+    [[nodiscard]] auto _valueImpl() -> Value const&
+    {
+        auto const& lhs = mLhs ? mLhs->_value() : mLhsLiteral;
+        auto const& rhs = mRhs ? mRhs->_value() : mRhsLiteral;
+        mLhsValue       = &lhs;
+        mRhsValue       = &rhs;
+        if (lhs.rows() != rhs.rows() || lhs.cols() != rhs.cols()) {
+            throw std::invalid_argument(
+                "Operands must have the same shape.");
+        }
+        detail::reuse(mValue, lhs.size());
+        mValue.resize(lhs.rows(), lhs.cols());
+        auto const x = flat(lhs);
+        auto const y = flat(rhs);
+        auto z       = Eigen::Map<Array>(mValue.data(), mValue.size());
+        switch (mFunction) {
+        case CwiseBinaryFunction::Add: z = x + y; break;
+        case CwiseBinaryFunction::Div: z = x / y; break;
+        case CwiseBinaryFunction::Mul: z = x * y; break;
+        case CwiseBinaryFunction::Pow: z = x.pow(y); break;
+        case CwiseBinaryFunction::Sub: z = x - y; break;
+        }
+        mHasPartials = false; // operands might have changed
+        return mValue;
+    }
+
+    [[nodiscard]] auto _pushForwardImpl() -> Derivative const&
+    {
+        auto const linear = mFunction == CwiseBinaryFunction::Add
+            || mFunction == CwiseBinaryFunction::Sub;
+        if (linear && !mRhs) {
+            return mLhs->_pushForward(); // x ± literal
+        }
+        if (mFunction == CwiseBinaryFunction::Add && !mLhs) {
+            return mRhs->_pushForward(); // literal + y
+        }
+        auto const* dx = mLhs ? &mLhs->_pushForward() : nullptr;
+        auto const* dy = mRhs ? &mRhs->_pushForward() : nullptr;
+        detail::reuse(mDerivative, (dx != nullptr ? dx : dy)->size());
+        if (linear) {
+            if (dx == nullptr) {
+                mDerivative = -*dy; // literal - y
+            } else if (mFunction == CwiseBinaryFunction::Add) {
+                mDerivative = *dx + *dy;
+            } else {
+                mDerivative = *dx - *dy;
+            }
+            return mDerivative;
+        }
+        partials();
+        if constexpr (isLanes) {
+            if (dx == nullptr) {
+                mDerivative = mPartialsRhs * *dy;
+            } else if (dy == nullptr) {
+                mDerivative = mPartialsLhs * *dx;
+            } else {
+                mDerivative = mPartialsLhs * *dx + mPartialsRhs * *dy;
+            }
+        } else if (dx == nullptr) {
+            mDerivative.noalias() = mPartialsRhs.matrix().asDiagonal() * *dy;
+        } else {
+            mDerivative.noalias() = mPartialsLhs.matrix().asDiagonal() * *dx;
+            if (dy != nullptr) {
+                mDerivative.noalias()
+                    += mPartialsRhs.matrix().asDiagonal() * *dy;
+            }
+        }
+        return mDerivative;
+    }
+
+    void _pullBackImpl(Derivative const& gradient)
+    {
+        if (mFunction == CwiseBinaryFunction::Add) {
+            pullBack(mLhs, gradient);
+            pullBack(mRhs, gradient);
+            return;
+        }
+        detail::reuse(mGradient, gradient.size());
+        if (mFunction == CwiseBinaryFunction::Sub) {
+            pullBack(mLhs, gradient);
+            if (mRhs) {
+                mGradient = -gradient;
+                mRhs->_pullBack(mGradient);
+            }
+            return;
+        }
+        partials();
+        if (mLhs) {
+            scale(gradient, mPartialsLhs);
+            mLhs->_pullBack(mGradient);
+        }
+        if (mRhs) {
+            scale(gradient, mPartialsRhs);
+            mRhs->_pullBack(mGradient);
+        }
+    }
+
+    // Second-order sweep (see AbstractEvaluator::valueTangent). The product
+    // of each operand gets the gradient g times the second partials with
+    // respect to both operands, applied to their tangents; the cross terms
+    // are skipped for literals (whose tangents are zero).
+    [[nodiscard]] auto _valueTangent() -> Value const&
+    {
+        auto const* dx   = mLhs ? &mLhs->_valueTangent() : nullptr;
+        auto const* dy   = mRhs ? &mRhs->_valueTangent() : nullptr;
+        auto const& like = dx != nullptr ? *dx : *dy;
+        detail::reuse(mTangent, like.size());
+        mTangent.resize(like.rows(), like.cols());
+        auto z = flat(mTangent);
+        z.setZero();
+        if (mFunction == CwiseBinaryFunction::Add
+            || mFunction == CwiseBinaryFunction::Sub) {
+            auto const sign
+                = mFunction == CwiseBinaryFunction::Sub ? -1 : 1;
+            if (dx != nullptr) {
+                z += flat(*dx);
+            }
+            if (dy != nullptr) {
+                z += Scalar(sign) * flat(*dy);
+            }
+            return mTangent;
+        }
+        partials();
+        if (dx != nullptr) {
+            z += mPartialsLhs * flat(*dx);
+        }
+        if (dy != nullptr) {
+            z += mPartialsRhs * flat(*dy);
+        }
+        return mTangent;
+    }
+
+    void _pullBackSecond(Value const& gradient, Value const& product)
+    {
+        if (mFunction == CwiseBinaryFunction::Add
+            || (mFunction == CwiseBinaryFunction::Sub && !mRhs)) {
+            pullBackSecond(mLhs, gradient, product);
+            pullBackSecond(mRhs, gradient, product);
+            return;
+        }
+        detail::reuse(mGradientValue, gradient.size());
+        detail::reuse(mProduct, product.size());
+        mGradientValue.resize(gradient.rows(), gradient.cols());
+        mProduct.resize(product.rows(), product.cols());
+        if (mFunction == CwiseBinaryFunction::Sub) {
+            pullBackSecond(mLhs, gradient, product);
+            mGradientValue = -gradient;
+            mProduct       = -product;
+            mRhs->_pullBackSecond(mGradientValue, mProduct);
+            return;
+        }
+        partials();
+        auto const x   = flat(operandValue(mLhsValue, mLhs, mLhsLiteral));
+        auto const y   = flat(operandValue(mRhsValue, mRhs, mRhsLiteral));
+        auto const g   = flat(gradient);
+        auto const p   = flat(product);
+        auto const* dx = mLhs ? &mLhs->_valueTangent() : nullptr;
+        auto const* dy = mRhs ? &mRhs->_valueTangent() : nullptr;
+        auto gx        = flat(mGradientValue);
+        auto px        = flat(mProduct);
+        if (mLhs) {
+            gx = g * mPartialsLhs;
+            px = p * mPartialsLhs;
+            switch (mFunction) {
+            case CwiseBinaryFunction::Div:
+                if (dy != nullptr) {
+                    px -= g * flat(*dy) / y.square();
+                }
+                break;
+            case CwiseBinaryFunction::Mul:
+                if (dy != nullptr) {
+                    px += g * flat(*dy);
+                }
+                break;
+            case CwiseBinaryFunction::Pow:
+                px += g * y * (y - Scalar{1}) * x.pow(y - Scalar{2})
+                    * flat(*dx);
+                if (dy != nullptr) {
+                    px += g * x.pow(y - Scalar{1})
+                        * (Scalar{1} + y * x.log()) * flat(*dy);
+                }
+                break;
+            case CwiseBinaryFunction::Add:
+            case CwiseBinaryFunction::Sub: break;
+            }
+            mLhs->_pullBackSecond(mGradientValue, mProduct);
+        }
+        if (mRhs) {
+            gx = g * mPartialsRhs;
+            px = p * mPartialsRhs;
+            switch (mFunction) {
+            case CwiseBinaryFunction::Div:
+                px += Scalar{2} * g * x * flat(*dy) / y.cube();
+                if (dx != nullptr) {
+                    px -= g * flat(*dx) / y.square();
+                }
+                break;
+            case CwiseBinaryFunction::Mul:
+                if (dx != nullptr) {
+                    px += g * flat(*dx);
+                }
+                break;
+            case CwiseBinaryFunction::Pow:
+                px += g * mPartialsRhs * x.log() * flat(*dy);
+                if (dx != nullptr) {
+                    px += g * x.pow(y - Scalar{1})
+                        * (Scalar{1} + y * x.log()) * flat(*dx);
+                }
+                break;
+            case CwiseBinaryFunction::Add:
+            case CwiseBinaryFunction::Sub: break;
+            }
+            mRhs->_pullBackSecond(mGradientValue, mProduct);
+        }
+    }
+
+    void _transferChildrenToImpl(internal::Node& node) const
+    {
+        if (mLhs) {
+            mLhs->_transferChildrenTo(node);
+        }
+        if (mRhs) {
+            mRhs->_transferChildrenTo(node);
+        }
+    }
+
+    void _releaseCacheImpl() const
+    {
+        mHasPartials = false;
+        if (!detail::threadState().retainCache) {
+            mLhsValue = nullptr; // recycled by the operands
+            mRhsValue = nullptr;
+            detail::recycle(mValue);
+            detail::recycle(mPartialsLhs);
+            detail::recycle(mPartialsRhs);
+            detail::recycle(mDerivative);
+            detail::recycle(mGradient);
+            detail::recycle(mTangent);
+            detail::recycle(mGradientValue);
+            detail::recycle(mProduct);
+        }
+        if (mLhs) {
+            mLhs->_releaseCache();
+        }
+        if (mRhs) {
+            mRhs->_releaseCache();
+        }
+    }
+
+private:
+    static constexpr bool isLanes = std::is_same_v<Derivative, Array>;
+
+    // elements in column-major order
+    static auto flat(Value const& value) -> Eigen::Map<Array const>
+    {
+        return Eigen::Map<Array const>(value.data(), value.size());
+    }
+
+    static auto flat(Value& value) -> Eigen::Map<Array>
+    {
+        return Eigen::Map<Array>(value.data(), value.size());
+    }
+
+    static void pullBack(
+        std::optional<Operand>& operand, Derivative const& gradient)
+    {
+        if (operand) {
+            operand->_pullBack(gradient);
+        }
+    }
+
+    static void pullBackSecond(std::optional<Operand>& operand,
+        Value const& gradient, Value const& product)
+    {
+        if (operand) {
+            operand->_pullBackSecond(gradient, product);
+        }
+    }
+
+    // gradient scaled column-wise by the partials, into the gradient buffer
+    void scale(Derivative const& gradient, Array const& partials)
+    {
+        if constexpr (isLanes) {
+            mGradient = gradient * partials;
+        } else {
+            mGradient.noalias() = gradient * partials.matrix().asDiagonal();
+        }
+    }
+
+    // of the last evaluation; evaluating the operand again would re-evaluate
+    // its whole subtree
+    static auto operandValue(Value const* cached,
+        std::optional<Operand>& operand, Value const& literal) -> Value const&
+    {
+        if (cached != nullptr) {
+            return *cached;
+        }
+        return operand ? operand->_value() : literal;
+    }
+
+    // diagonals of the Jacobians with respect to the operands that are not
+    // literals, evaluated at their values (not needed for sums and
+    // differences)
+    void partials()
+    {
+        if (mHasPartials) {
+            return;
+        }
+        auto const x = flat(operandValue(mLhsValue, mLhs, mLhsLiteral));
+        auto const y = flat(operandValue(mRhsValue, mRhs, mRhsLiteral));
+        if (mLhs) {
+            detail::reuse(mPartialsLhs, x.size());
+        }
+        if (mRhs) {
+            detail::reuse(mPartialsRhs, y.size());
+        }
+        switch (mFunction) {
+        case CwiseBinaryFunction::Div:
+            if (mLhs) {
+                mPartialsLhs = y.inverse();
+            }
+            if (mRhs) {
+                mPartialsRhs = -x / y.square();
+            }
+            break;
+        case CwiseBinaryFunction::Mul:
+            if (mLhs) {
+                mPartialsLhs = y;
+            }
+            if (mRhs) {
+                mPartialsRhs = x;
+            }
+            break;
+        case CwiseBinaryFunction::Pow:
+            if (mLhs) {
+                mPartialsLhs = y * x.pow(y - Scalar{1});
+            }
+            if (mRhs) {
+                mPartialsRhs = x.pow(y) * x.log();
+            }
+            break;
+        case CwiseBinaryFunction::Add:
+        case CwiseBinaryFunction::Sub: break;
+        }
+        mHasPartials = true;
+    }
+
+    CwiseBinaryFunction mFunction;
+    std::optional<Operand> mLhs; // empty for a literal
+    std::optional<Operand> mRhs;
+    Value mLhsLiteral;
+    Value mRhsLiteral;
+
+    // cache
+    mutable Value const* mLhsValue = nullptr; // of the last evaluation
+    mutable Value const* mRhsValue = nullptr;
+    mutable Value mValue;
+    mutable Array mPartialsLhs;
+    mutable Array mPartialsRhs;
+    mutable bool mHasPartials = false;
+    mutable Derivative mDerivative;
+    mutable Derivative mGradient; // passed on to the operands
+
+    // cache of the second-order sweep
+    mutable Value mTangent;
+    mutable Value mGradientValue; // passed on to the operands
+    mutable Value mProduct;
+};
+
+// Applies an element-wise function to an expression.
+// If the operand is itself an element-wise operation that is not used
+// otherwise by the time of the evaluation, the function is fused into its
+// chain then (see CwiseOperation::fuseOperand).
+template <typename Value, typename Derivative>
+auto cwise(Expression<Value, Derivative> const& operand,
+    CwiseFunction function,
+    typename Value::Scalar constant = 0) -> Operation<Value, Derivative>
+{
+    using Cwise = CwiseOperation<Value, Derivative>;
+    return Operation<Value, Derivative>{
+        Cwise{typename Cwise::Step{function, constant}, operand.wrapper()}};
+}
+
+template <typename Value, typename Derivative>
+auto cwise(Expression<Value, Derivative> const& lhs,
+    Expression<Value, Derivative> const& rhs,
+    CwiseBinaryFunction function) -> Operation<Value, Derivative>
+{
+    return Operation<Value, Derivative>{CwiseBinaryOperation<Value,
+        Derivative>{function, lhs.wrapper(), rhs.wrapper()}};
+}
+
+template <typename Value, typename Derivative>
+auto cwise(Expression<Value, Derivative> const& lhs, Value rhs,
+    CwiseBinaryFunction function) -> Operation<Value, Derivative>
+{
+    return Operation<Value, Derivative>{CwiseBinaryOperation<Value,
+        Derivative>{function, lhs.wrapper(), std::move(rhs)}};
+}
+
+template <typename Value, typename Derivative>
+auto cwise(Value lhs, Expression<Value, Derivative> const& rhs,
+    CwiseBinaryFunction function) -> Operation<Value, Derivative>
+{
+    return Operation<Value, Derivative>{CwiseBinaryOperation<Value,
+        Derivative>{function, std::move(lhs), rhs.wrapper()}};
+}
+
+} // namespace AutoDiff::Python
+
+#define AUTODIFF_PYTHON_DEF_CWISE_OP(                                          \
+    Binding, module, name, function, description)                              \
+    {                                                                          \
+        using Expr = typename Binding::Expr;                                   \
+        auto func = [](Expr const& x) {                                        \
+            return AutoDiff::Python::cwise(                                    \
+                x, AutoDiff::Python::CwiseFunction::function);                 \
+        };                                                                     \
+        AutoDiff::Python::defUnaryOp(module, name, func, description);         \
+    }
+
+// A @ B, A @ BLiteral and BLiteral @ A element-wise
+#define AUTODIFF_PYTHON_DEF_CWISE_INFIX_OP(                                    \
+    binding, name, function, description)                                      \
+    {                                                                          \
+        using Binding = decltype(binding);                                     \
+        using Expr    = typename Binding::Expr;                                \
+        using Value   = typename Binding::Value;                               \
+                                                                               \
+        auto funcExpr = [](Expr const& x, Expr const& y) {                     \
+            return AutoDiff::Python::cwise(                                    \
+                x, y, AutoDiff::Python::CwiseBinaryFunction::function);        \
+        };                                                                     \
+        auto funcValue = [](Expr const& x, Value y) {                          \
+            return AutoDiff::Python::cwise(x, std::move(y),                    \
+                AutoDiff::Python::CwiseBinaryFunction::function);              \
+        };                                                                     \
+        auto funcRValue = [](Expr const& y, Value x) {                         \
+            return AutoDiff::Python::cwise(std::move(x), y,                    \
+                AutoDiff::Python::CwiseBinaryFunction::function);              \
+        };                                                                     \
+        binding.defInfixOp(name, funcExpr, funcValue, description);            \
+        binding.defRInfixOp(name, funcRValue, description);                    \
+    }
+
+#define AUTODIFF_PYTHON_DEF_CWISE_METHOD(binding, name, function, description) \
+    {                                                                          \
+        using Binding = decltype(binding);                                     \
+        using Expr    = typename Binding::Expr;                                \
+                                                                               \
+        auto func = [](Expr const& x) {                                        \
+            return AutoDiff::Python::cwise(                                    \
+                x, AutoDiff::Python::CwiseFunction::function);                 \
+        };                                                                     \
+        binding.defUnaryOp(name, func, description);                           \
+    }
+
+// A @ ScalarLiteral fused element-wise, A @ Scalar with operation
+#define AUTODIFF_PYTHON_DEF_CWISE_BROADCAST_INFIX_OP(                          \
+    binding, name, operation, function, description)                           \
+    {                                                                          \
+        using Binding    = decltype(binding);                                  \
+        using Expr       = typename Binding::Expr;                             \
+        using Op         = typename Binding::Op;                               \
+        using Scalar     = typename Binding::Scalar;                           \
+        using ScalarExpr = typename Binding::ScalarExpr;                       \
+                                                                               \
+        auto funcScalar = [](Expr const& x, Scalar y) {                        \
+            return AutoDiff::Python::cwise(                                    \
+                x, AutoDiff::Python::CwiseFunction::function, y);              \
+        };                                                                     \
+        auto funcScalarExpr                                                    \
+            = [](Expr const& x, ScalarExpr const& y) {                         \
+                  return Op{operation(x.wrapper(), y.wrapper())};              \
+              };                                                               \
+        binding.defBroadcastInfixOp(                                           \
+            name, funcScalar, funcScalarExpr, description);                    \
+    }
+
+// ScalarLiteral @ A fused element-wise, Scalar @ A with operation
+#define AUTODIFF_PYTHON_DEF_CWISE_R_BROADCAST_INFIX_OP(                        \
+    binding, name, operation, function, description)                           \
+    {                                                                          \
+        using Binding    = decltype(binding);                                  \
+        using Expr       = typename Binding::Expr;                             \
+        using Op         = typename Binding::Op;                               \
+        using Scalar     = typename Binding::Scalar;                           \
+        using ScalarExpr = typename Binding::ScalarExpr;                       \
+                                                                               \
+        auto funcRScalar = [](Expr const& y, Scalar x) {                       \
+            return AutoDiff::Python::cwise(                                    \
+                y, AutoDiff::Python::CwiseFunction::function, x);              \
+        };                                                                     \
+        auto funcRScalarExpr                                                   \
+            = [](Expr const& y, ScalarExpr const& x) {                         \
+                  return Op{operation(x.wrapper(), y.wrapper())};              \
+              };                                                               \
+        binding.defRBroadcastInfixOp(                                          \
+            name, funcRScalar, funcRScalarExpr, description);                  \
+    }
+
+#endif // AUTODIFF_PYTHON_CWISE_HPP
@@ -6,16 +6,67 @@
 #ifndef AUTODIFF_PYTHON_EVALUATOR_HPP
 #define AUTODIFF_PYTHON_EVALUATOR_HPP
 
+#include "BufferPool.hpp"
+#include "Profiler.hpp"
+#include "State.hpp"
+
 #include <AutoDiff/src/Core/AbstractVariable.hpp>
 #include <AutoDiff/src/Core/Expression.hpp> // ValueType
 #include <AutoDiff/src/internal/traits.hpp> // Evaluated
 
+#include <algorithm>   // copy, min
+#include <cstddef>     // ptrdiff_t, size_t
 #include <memory>
-#include <type_traits> // enable_if_t
-#include <utility>     // move
+#include <optional>
+#include <stdexcept>   // invalid_argument, logic_error, runtime_error
+#include <string>
+#include <type_traits> // decay_t, enable_if_t, is_arithmetic_v, is_same_v
+#include <utility>     // declval, move
 
 namespace AutoDiff::Python {
 
+// Keeps the cache buffers of all evaluators alive while in scope.
+// Released caches are then overwritten in place by the next evaluation,
+// which avoids reallocations as long as the value shapes stay the same.
+// Otherwise, released buffers go to the BufferPool of the thread.
+class CacheScope {
+public:
+    explicit CacheScope(bool retain)
+        : mPrevious{detail::threadState().retainCache}
+    {
+        detail::threadState().retainCache = retain;
+    }
+
+    ~CacheScope() { detail::threadState().retainCache = mPrevious; }
+
+    CacheScope(CacheScope const&)                    = delete;
+    CacheScope(CacheScope&&)                         = delete;
+    auto operator=(CacheScope const&) -> CacheScope& = delete;
+    auto operator=(CacheScope&&) -> CacheScope&      = delete;
+
+private:
+    bool mPrevious;
+};
+
+namespace detail {
+
+// Second-order rule of an operation of the core library, whose expressions
+// are opaque to the bindings (see makeRule)
+template <typename Value>
+class SecondOrderRule {
+public:
+    virtual ~SecondOrderRule() = default;
+
+    // tangent of the value of the operation
+    virtual auto tangent(Value const& value) -> Value const& = 0;
+
+    // pulls the gradient and the product back to the operands
+    virtual void pullBack(Value const& value, Value const& gradient,
+        Value const& product) = 0;
+};
+
+} // namespace detail
+
 template <typename Value_, typename Derivative_>
 class AbstractEvaluator {
 public:
@@ -29,6 +80,17 @@ public:
     virtual auto pushForward() -> Derivative const&       = 0;
     virtual void pullBack(Derivative const& gradient)     = 0;
     virtual void releaseCache()                           = 0;
+
+    // Second-order sweep of Function::hvp, at the values cached by the last
+    // evaluation: the tangent of the value in a single direction, then the
+    // gradient of a scalar and its tangent (the product) pulled back
+    // together, all of the shape of the value.
+    virtual auto cachedValue() -> Value const&  = 0;
+    virtual auto valueTangent() -> Value const& = 0;
+    virtual void pullBackSecond(Value const& gradient, Value const& product)
+        = 0;
+    virtual void setRule(std::shared_ptr<detail::SecondOrderRule<Value>> rule)
+        = 0;
 };
 
 template <typename Expr>
@@ -41,6 +103,30 @@ struct EvaluatorType {
 template <typename Expr>
 using EvaluatorType_t = typename EvaluatorType<Expr>::type;
 
+namespace detail {
+
+// operations of the bindings, which implement the second-order sweep
+// themselves (see AbstractEvaluator::valueTangent)
+template <typename Expr, typename = void>
+struct HasSecondOrder : std::false_type { };
+
+template <typename Expr>
+struct HasSecondOrder<Expr,
+    std::void_t<decltype(std::declval<Expr&>()._valueTangent())>>
+    : std::true_type { };
+
+// the second-order sweep of this thread (see Function::hvp)
+inline auto secondOrder() -> SecondOrder&
+{
+    auto* sweep = threadState().secondOrder;
+    if (sweep == nullptr) {
+        throw std::logic_error("No second-order sweep is running.");
+    }
+    return *sweep;
+}
+
+} // namespace detail
+
 template <typename Expr, typename = void>
 class Evaluator : public EvaluatorType_t<Expr> {
 public:
@@ -53,83 +139,422 @@ public:
     {
     }
 
+    [[nodiscard]] auto expression() const -> Expr const& { return mExpression; }
+
     void transferChildrenTo(internal::Node& node) final
     {
+        if (auto* operands = detail::threadState().operands) {
+            operands->operations.push_back(this);
+            operands->names.push_back(&detail::operationName<Expr>());
+        }
         mExpression._transferChildrenTo(node);
     }
 
     [[nodiscard]] auto value() -> Value const& final
     {
-        mValuePtr = std::make_unique<Value>(mExpression._value());
+        auto probe = Probe{this, Sweep::Evaluate};
+        if (mValuePtr) {
+            *mValuePtr = mExpression._value(); // reuse buffer if same shape
+        } else {
+            mValuePtr = detail::makeCache<Value>(mExpression._value());
+        }
+        probe.stop<Expr>(*mValuePtr);
         return *mValuePtr;
     }
 
     [[nodiscard]] auto pushForward() -> Derivative const& final
     {
-        mDerivativePtr
-            = std::make_unique<Derivative>(mExpression._pushForward());
+        auto probe = Probe{this, Sweep::PushTangent};
+        if (mDerivativePtr) {
+            *mDerivativePtr = mExpression._pushForward();
+        } else {
+            mDerivativePtr
+                = detail::makeCache<Derivative>(mExpression._pushForward());
+        }
+        probe.stop<Expr>(*mDerivativePtr);
         return *mDerivativePtr;
     }
 
     void pullBack(Derivative const& gradient) final
     {
+        auto probe = Probe{this, Sweep::PullGradient};
         mExpression._pullBack(gradient);
+        probe.stop<Expr>(gradient);
     }
 
     void releaseCache() final
     {
-        mValuePtr.reset();
-        mDerivativePtr.reset();
+        if (!detail::threadState().retainCache) {
+            detail::recycle(mValuePtr);
+            detail::recycle(mDerivativePtr);
+            if (auto* profiler = detail::threadState().profiler) {
+                profiler->release(this);
+            }
+        }
         mExpression._releaseCache();
     }
 
+    // evaluated again if released
+    [[nodiscard]] auto cachedValue() -> Value const& final
+    {
+        return mValuePtr ? *mValuePtr : value();
+    }
+
+    // once per sweep, even if the operation is shared
+    [[nodiscard]] auto valueTangent() -> Value const& final
+    {
+        auto& entry = detail::secondOrder().entries[this];
+        if (!entry.tangent) {
+            if constexpr (detail::HasSecondOrder<Expr>::value) {
+                entry.tangent
+                    = std::make_shared<Value>(mExpression._valueTangent());
+            } else {
+                entry.tangent
+                    = std::make_shared<Value>(rule().tangent(cachedValue()));
+            }
+        }
+        return *static_cast<Value const*>(entry.tangent.get());
+    }
+
+    void pullBackSecond(Value const& gradient, Value const& product) final
+    {
+        if constexpr (detail::HasSecondOrder<Expr>::value) {
+            mExpression._pullBackSecond(gradient, product);
+        } else {
+            rule().pullBack(cachedValue(), gradient, product);
+        }
+    }
+
+    void setRule(std::shared_ptr<detail::SecondOrderRule<Value>> rule) final
+    {
+        mRule = std::move(rule);
+    }
+
 private:
+    auto rule() -> detail::SecondOrderRule<Value>&
+    {
+        if (!mRule) {
+            throw std::invalid_argument("Hessian-vector products do not "
+                                        "support the operation "
+                + detail::operationName<Expr>() + ".");
+        }
+        return *mRule;
+    }
+
     Expr mExpression;
+    std::shared_ptr<detail::SecondOrderRule<Value>> mRule; // if opaque
 
     // cache
     std::unique_ptr<Value> mValuePtr;
     std::unique_ptr<Derivative> mDerivativePtr;
 };
 
+namespace detail {
+
+// Sets the derivative of a variable of the core library to the identity map,
+// seeding `count` directions, or to zero of the same dimensions.
+// Scalar and lanes derivatives hold a single direction per element.
 template <typename Var>
-class Evaluator<Var, std::enable_if_t<std::is_base_of_v<AbstractVariable, Var>>>
-    : public EvaluatorType_t<Var> {
+void seedDerivative(
+    Var const& variable, bool identity, std::ptrdiff_t count, bool tangent)
+{
+    using Value      = std::decay_t<decltype(variable())>;
+    using Derivative = typename Var::Derivative;
+    if constexpr (std::is_arithmetic_v<Derivative>) {
+        variable.setDerivative(identity ? Derivative{1} : Derivative{0});
+    } else if constexpr (std::is_same_v<Value, Derivative>
+        && Derivative::ColsAtCompileTime == 1) { // lanes
+        auto derivative = Derivative(variable().size());
+        derivative.setConstant(identity ? 1 : 0);
+        variable.setDerivative(std::move(derivative));
+    } else {
+        auto size = std::ptrdiff_t{1};
+        if constexpr (!std::is_arithmetic_v<Value>) {
+            size = variable().size();
+        }
+        auto derivative
+            = tangent ? Derivative(size, count) : Derivative(count, size);
+        derivative.setZero();
+        if (identity) {
+            for (std::ptrdiff_t i = 0; i < std::min(size, count); ++i) {
+                derivative(i, i) = 1;
+            }
+        }
+        variable.setDerivative(std::move(derivative));
+    }
+}
+
+// value of the shape of another one with all elements set to a scalar
+template <typename Value>
+auto filledLike(Value const& value, double scalar) -> Value
+{
+    if constexpr (std::is_arithmetic_v<Value>) {
+        return static_cast<Value>(scalar);
+    } else {
+        using Scalar = typename Value::Scalar;
+        return Value::Constant(
+            value.rows(), value.cols(), static_cast<Scalar>(scalar));
+    }
+}
+
+// Tangent of the shape of the value, given a derivative of a variable with
+// a single tangent direction (see AbstractVariable::_setDirection)
+template <typename Value, typename Derivative>
+auto asTangent(Value const& value, Derivative const& derivative) -> Value
+{
+    if constexpr (std::is_arithmetic_v<Derivative>
+        || std::is_same_v<Value, Derivative>) {
+        return derivative;
+    } else {
+        auto size = std::ptrdiff_t{1};
+        if constexpr (!std::is_arithmetic_v<Value>) {
+            size = value.size();
+        }
+        if (derivative.size() != size) {
+            throw std::invalid_argument(
+                "The derivative of a source must be a single direction.");
+        }
+        if constexpr (std::is_arithmetic_v<Value>) {
+            return derivative(0, 0);
+        } else {
+            auto tangent = value; // of the same shape
+            std::copy(derivative.data(), derivative.data() + size,
+                tangent.data());
+            return tangent;
+        }
+    }
+}
+
+// derivative with a single gradient row, given a gradient of the shape of
+// the value
+template <typename Derivative, typename Value>
+auto asGradient(Value const& gradient) -> Derivative
+{
+    if constexpr (std::is_arithmetic_v<Derivative>
+        || std::is_same_v<Value, Derivative>) {
+        return gradient;
+    } else if constexpr (std::is_arithmetic_v<Value>) {
+        auto row  = Derivative(1, 1);
+        row(0, 0) = gradient;
+        return row;
+    } else {
+        auto row = Derivative(1, gradient.size());
+        std::copy(gradient.data(), gradient.data() + gradient.size(),
+            row.data());
+        return row;
+    }
+}
+
+// adds a value to a type-erased sum, which is empty at first
+template <typename Value>
+void accumulate(std::shared_ptr<void>& sum, Value const& value)
+{
+    if (sum) {
+        *static_cast<Value*>(sum.get()) += value;
+    } else {
+        sum = std::make_shared<Value>(value);
+    }
+}
+
+} // namespace detail
+
+// variables of the core library (qualified, since Python::AbstractVariable
+// would be found instead if declared before)
+template <typename Var>
+class Evaluator<Var,
+    std::enable_if_t<std::is_base_of_v<AutoDiff::AbstractVariable, Var>>>
+    : public EvaluatorType_t<Var>
+    , public detail::GradientSlot {
 public:
     using Base = EvaluatorType_t<Var>;
     using typename Base::Derivative;
     using typename Base::Value;
 
-    explicit Evaluator(Var variable)
+    // the status is recorded as read by evaluations and expressions, if any
+    explicit Evaluator(Var variable,
+        std::shared_ptr<detail::VariableStatus> status = nullptr)
         : mVariable{std::move(variable)}
+        , mStatus{std::move(status)}
     {
     }
 
     void transferChildrenTo(internal::Node& node) final
     {
         mVariable._transferChildrenTo(node);
+        if (auto* operands = detail::threadState().operands) {
+            operands->variables.add(mVariable._node(), mStatus, this);
+        }
     }
 
     [[nodiscard]] auto value() -> Value const& final
     {
-        return mVariable._value();
+        auto const& value = mVariable._value();
+        probeVariable(mVariable._node(), Sweep::Evaluate, value);
+        if (auto* reads = detail::threadState().reads) {
+            reads->add(mVariable._node(), mStatus);
+        }
+        return value;
     }
 
     [[nodiscard]] auto pushForward() -> Derivative const& final
     {
-        return mVariable._pushForward();
+        auto const& derivative = mVariable._pushForward();
+        probeVariable(mVariable._node(), Sweep::PushTangent, derivative);
+        return derivative;
     }
 
     void pullBack(Derivative const& gradient) final
     {
         mVariable._pullBack(gradient);
+        // accumulated into a derivative of the same shape
+        probeVariable(mVariable._node(), Sweep::PullGradient, gradient);
     }
 
     void releaseCache() final { } // no cache
 
+    void keep() final
+    {
+        auto const& derivative = d(mVariable);
+        if (mKept) {
+            *mKept += derivative;
+        } else {
+            mKept = derivative;
+        }
+    }
+
+    void restore() final
+    {
+        if (mKept) {
+            mVariable.setDerivative(std::move(*mKept));
+            mKept.reset();
+        }
+    }
+
+    void seed(bool identity, std::ptrdiff_t count, bool tangent) final
+    {
+        detail::seedDerivative(mVariable, identity, count, tangent);
+    }
+
+    [[nodiscard]] auto valueBytes() const -> std::size_t final
+    {
+        return detail::bytesOf(mVariable());
+    }
+
+    [[nodiscard]] auto derivativeBytes() const -> std::size_t final
+    {
+        return detail::bytesOf(d(mVariable));
+    }
+
+    [[nodiscard]] auto cachedValue() -> Value const& final
+    {
+        return mVariable();
+    }
+
+    // Set by the expression of the variable earlier in the sweep, if any.
+    // Otherwise, the tangent of a leaf is its derivative if it has a
+    // direction, or zero.
+    [[nodiscard]] auto valueTangent() -> Value const& final
+    {
+        auto& sweep = detail::secondOrder();
+        auto& entry = sweep.entries[mVariable._node()];
+        if (!entry.tangent) {
+            auto const& value = mVariable();
+            auto const seeded = sweep.directions != nullptr
+                && sweep.directions->count(mVariable._node()) != 0;
+            entry.tangent = std::make_shared<Value>(seeded
+                    ? detail::asTangent(value, d(mVariable))
+                    : detail::filledLike(value, 0));
+        }
+        return *static_cast<Value const*>(entry.tangent.get());
+    }
+
+    // summed over all expressions reading the variable
+    void pullBackSecond(Value const& gradient, Value const& product) final
+    {
+        auto& entry = detail::secondOrder().entries[mVariable._node()];
+        detail::accumulate(entry.gradient, gradient);
+        detail::accumulate(entry.product, product);
+    }
+
+    void setRule(std::shared_ptr<detail::SecondOrderRule<Value>>) final { }
+
+    void storeProduct() final
+    {
+        auto const& entries = detail::secondOrder().entries;
+        auto const found    = entries.find(mVariable._node());
+        if (found != entries.end() && found->second.product) {
+            mVariable.setDerivative(detail::asGradient<Derivative>(
+                *static_cast<Value const*>(found->second.product.get())));
+        } else {
+            mVariable.setDerivative(detail::asGradient<Derivative>(
+                detail::filledLike(mVariable(), 0)));
+        }
+    }
+
 private:
     Var mVariable;
+    std::shared_ptr<detail::VariableStatus> mStatus;
+    std::optional<Derivative> mKept; // see keep
+};
+
+namespace detail {
+
+// Expression of a variable in the second-order sweeps, see SecondOrderRoot.
+// The evaluator is owned by the variable (the node of the core library).
+template <typename Value, typename Derivative>
+class ExpressionRoot : public SecondOrderRoot {
+public:
+    using Evaluator = AbstractEvaluator<Value, Derivative>;
+
+    explicit ExpressionRoot(std::shared_ptr<Evaluator> const& evaluator)
+        : mEvaluator{evaluator}
+    {
+    }
+
+    void pushTangent(void const* key) final
+    {
+        auto const evaluator = this->evaluator();
+        secondOrder().entries[key].tangent
+            = std::make_shared<Value>(evaluator->valueTangent());
+    }
+
+    void seed(void const* key) final
+    {
+        auto const evaluator = this->evaluator();
+        auto const& value    = evaluator->cachedValue();
+        auto& entry          = secondOrder().entries[key];
+        entry.gradient = std::make_shared<Value>(filledLike(value, 1));
+        entry.product  = std::make_shared<Value>(filledLike(value, 0));
+    }
+
+    void pullBack(void const* key) final
+    {
+        auto const& entries = secondOrder().entries;
+        auto const found    = entries.find(key);
+        if (found != entries.end() && found->second.gradient) {
+            auto const& entry = found->second;
+            evaluator()->pullBackSecond(
+                *static_cast<Value const*>(entry.gradient.get()),
+                *static_cast<Value const*>(entry.product.get()));
+        }
+    }
+
+private:
+    [[nodiscard]] auto evaluator() const -> std::shared_ptr<Evaluator>
+    {
+        auto evaluator = mEvaluator.lock();
+        if (!evaluator) {
+            throw std::runtime_error(
+                "The expression of a variable was destroyed.");
+        }
+        return evaluator;
+    }
+
+    std::weak_ptr<Evaluator> mEvaluator;
 };
 
+} // namespace detail
+
 } // namespace AutoDiff::Python
 
 #endif // AUTODIFF_PYTHON_EVALUATOR_HPP
@@ -6,6 +6,7 @@
 #ifndef AUTODIFF_PYTHON_EXPRESSION_HPP
 #define AUTODIFF_PYTHON_EXPRESSION_HPP
 
+#include "Arena.hpp"
 #include "Evaluator.hpp"
 
 #include <AutoDiff/src/Core/Expression.hpp>
@@ -23,7 +24,7 @@ public:
 
     template <typename Expr>
     explicit ExpressionWrapper(Expr expression)
-        : mEvaluator{std::make_shared<Evaluator<Expr>>(std::move(expression))}
+        : mEvaluator{detail::makeShared<Evaluator<Expr>>(std::move(expression))}
     {
     }
 
@@ -63,6 +64,29 @@ public:
 
     void _releaseCacheImpl() const { mEvaluator->releaseCache(); }
 
+    // second-order sweep, see AbstractEvaluator::valueTangent
+
+    [[nodiscard]] auto _cachedValue() const -> Value const&
+    {
+        return mEvaluator->cachedValue();
+    }
+
+    [[nodiscard]] auto _valueTangent() const -> Value const&
+    {
+        return mEvaluator->valueTangent();
+    }
+
+    void _pullBackSecond(Value const& gradient, Value const& product) const
+    {
+        mEvaluator->pullBackSecond(gradient, product);
+    }
+
+    [[nodiscard]] auto evaluator() const
+        -> std::shared_ptr<AbstractEvaluator<Value, Derivative>> const&
+    {
+        return mEvaluator;
+    }
+
 private:
     // shared to allow copy
     std::shared_ptr<AbstractEvaluator<Value, Derivative>> mEvaluator;
@@ -73,6 +97,9 @@ class Expression {
 public:
     [[nodiscard]] virtual auto
     wrapper() const -> ExpressionWrapper<Value, Derivative> = 0;
+
+    // identifies the expression (shared by copies), e.g. on a Tape
+    [[nodiscard]] virtual auto _key() const -> void const* = 0;
 };
 
 } // namespace AutoDiff::Python
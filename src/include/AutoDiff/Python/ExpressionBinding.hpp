@@ -8,10 +8,10 @@
 
 #include "Expression.hpp"
 #include "Operation.hpp"
+#include "Tape.hpp"
 #include "Variable.hpp"
 
 #include <AutoDiff/src/Core/AbstractVariable.hpp>
-#include <AutoDiff/src/Core/Variable.hpp> // var
 #include <pybind11/pybind11.h>
 
 #include <string>
@@ -19,23 +19,30 @@
 
 namespace AutoDiff::Python {
 
-template <typename Value_, typename Derivative>
+template <typename Value_, typename Derivative_>
 struct ExpressionBinding {
-    using Value     = Value_;
-    using Expr      = Python::Expression<Value, Derivative>;
-    using Op        = Python::Operation<Value, Derivative>;
-    using Var       = Python::Variable<Value, Derivative>;
-    using ExprClass = pybind11::class_<Expr>;
-    using OpClass   = pybind11::class_<Op, Expr>;
-    using VarClass  = pybind11::class_<Var, Expr, AbstractVariable>;
-
-    using Scalar     = double;
+    using Value      = Value_;
+    using Derivative = Derivative_;
+    using Expr       = Python::Expression<Value, Derivative>;
+    using Op         = Python::Operation<Value, Derivative>;
+    using Var        = Python::Variable<Value, Derivative>;
+    using ExprClass  = pybind11::class_<Expr>;
+    using OpClass    = pybind11::class_<Op, Expr>;
+    using VarClass   = pybind11::class_<Var, Expr, AbstractVariable>;
+
+    using Scalar     = typename detail::ScalarType<Value>::type;
     using ScalarExpr = Python::Expression<Scalar, Derivative>;
 
-    ExpressionBinding(pybind11::module& module, std::string const& name)
-        : mExprClass{module, (name + "Expression").c_str()}
-        , mOpClass{module, (name + "Operation").c_str()}
-        , mVarClass{module, (name + "Variable").c_str()}
+    // Classes of a local binding are visible to its module only, which can
+    // then bind the same C++ types as another module
+    ExpressionBinding(pybind11::module& module, std::string const& name,
+        bool local = false)
+        : mExprClass{module, (name + "Expression").c_str(),
+            pybind11::module_local(local)}
+        , mOpClass{module, (name + "Operation").c_str(),
+              pybind11::module_local(local)}
+        , mVarClass{module, (name + "Variable").c_str(),
+              pybind11::module_local(local)}
     {
         mExprClass.doc()
             = R"doc(Composition of literals, variables, and other expressions.
@@ -90,17 +97,26 @@ Examples
 >>> d(x)                  # get its derivative
 )doc";
 
-        mVarClass.def(pybind11::init<Value>(), pybind11::arg("value") = Value{},
+        mVarClass.def(pybind11::init([](Value value) {
+            auto variable = Var{std::move(value)};
+            detail::recordVariable(variable, nullptr);
+            return variable;
+        }),
+            pybind11::arg("value") = detail::defaultValue<Value>(),
             R"doc(Create a variable holding a literal.)doc");
 
         mVarClass.def("__call__", &Var::value,
             pybind11::return_value_policy::reference_internal,
-            R"doc(Returns the cached value.)doc");
+            R"doc(Returns the cached value.
+
+Arrays are returned as read-only views (without copying) that are valid
+until the value is updated.)doc");
 
         mVarClass.def(
             "set",
             [](Var const& variable, Value value) {
                 variable.set(std::move(value));
+                detail::recordVariable(variable, nullptr);
             },
             pybind11::arg("value"),
             R"doc(Assign a literal to replace the current value or expression.)doc");
@@ -109,6 +125,7 @@ Examples
             "set",
             [](Var const& variable, Expr const& expression) {
                 variable.set(expression);
+                detail::recordVariable(variable, expression._key());
             },
             pybind11::arg("expression"),
             R"doc(Assign an expression to replace the current value or expression.
@@ -123,8 +140,13 @@ The derivative is propagated during forward- or reverse-mode
 automatic differentiation with a `Function` object.)doc");
 
         module.def(
-            "var", [](Value value) { return Var{var(std::move(value))}; },
-            pybind11::arg("value") = Value{},
+            "var",
+            [](Value value) {
+                auto variable = Var{std::move(value)};
+                detail::recordVariable(variable, nullptr);
+                return variable;
+            },
+            pybind11::arg("value") = detail::defaultValue<Value>(),
             R"doc(Create a variable holding a literal.
 
 The value is stored in the variable and can be accessed with the `()` method.)doc");
@@ -132,7 +154,9 @@ The value is stored in the variable and can be accessed with the `()` method.)do
         module.def(
             "var",
             [](Expr const& expression) {
-                return Var{var(expression.wrapper())};
+                auto variable = Var{expression};
+                detail::recordVariable(variable, expression._key());
+                return variable;
             },
             pybind11::arg("expression"),
             R"doc(Create a variable that evaluates an expression of other variables.
@@ -140,13 +164,42 @@ The value is stored in the variable and can be accessed with the `()` method.)do
 The expression is immediately evaluated (eager evaluation).)doc");
 
         module.def(
-            "d", [](Var const& variable) { return variable.derivative(); },
+            "d",
+            [](Var const& variable) -> Derivative const& {
+                return variable.derivative();
+            },
             pybind11::return_value_policy::reference_internal,
             pybind11::arg("variable"),
             R"doc(Returns the differential (i.e., the cached derivative) of a variable.
 
 Depending on the mode of differentiation, this derivative
-can be a tangent vector or gradient.)doc");
+can be a tangent vector or gradient.
+
+Arrays are returned as read-only views (without copying) that are valid
+until the derivative is updated.)doc");
+    }
+
+    // A.assign(array) without intermediate copies if ValueRef maps the array
+    template <typename ValueRef>
+    void defAssign()
+    {
+        mVarClass.def(
+            "assign",
+            [](Var const& variable, ValueRef value) { variable.assign(value); },
+            pybind11::arg("value"),
+            R"doc(Overwrite the current value in place.
+
+Unlike `set`, the array is copied directly into the existing storage of the
+variable, avoiding intermediate copies and (for arrays of the same shape)
+reallocations.
+Any expression of the variable is kept and overwrites the value again
+during its next evaluation, so this is typically used for source variables.
+
+Examples
+--------
+>>> x = var(np.zeros(3))
+
+>>> x.assign(np.array([1., 2., 3.]))  # no reallocation)doc");
     }
 
     // A @ B, A @ BLiteral
@@ -154,10 +207,13 @@ can be a tangent vector or gradient.)doc");
     void defInfixOp(std::string const& name, FuncExpr&& funcExpr,
         FuncValue&& funcValue, std::string const& description)
     {
-        mExprClass.def(("__" + name + "__").c_str(), funcExpr,
-            pybind11::arg("other"), description.c_str());
-        mExprClass.def(("__" + name + "__").c_str(), funcValue,
-            pybind11::arg("other"), description.c_str());
+        auto const method = "__" + name + "__";
+        mExprClass.def(method.c_str(),
+            detail::recorded(method, true, +funcExpr), pybind11::arg("other"),
+            description.c_str());
+        mExprClass.def(method.c_str(),
+            detail::recorded(method, true, +funcValue), pybind11::arg("other"),
+            description.c_str());
     }
 
     // BLiteral @ A
@@ -165,8 +221,10 @@ can be a tangent vector or gradient.)doc");
     void defRInfixOp(std::string const& name, FuncRValue&& funcRValue,
         std::string const& description)
     {
-        mExprClass.def(("__r" + name + "__").c_str(), funcRValue,
-            pybind11::arg("other"), description.c_str());
+        auto const method = "__r" + name + "__";
+        mExprClass.def(method.c_str(),
+            detail::recorded(method, true, +funcRValue), pybind11::arg("other"),
+            description.c_str());
     }
 
     // A @ Scalar, A @ ScalarLiteral
@@ -174,9 +232,12 @@ can be a tangent vector or gradient.)doc");
     void defBroadcastInfixOp(std::string const& name, FuncScalar&& funcScalar,
         FuncScalarExpr&& funcScalarExpr, std::string const& description)
     {
-        mExprClass.def(("__" + name + "__").c_str(), funcScalar,
+        auto const method = "__" + name + "__";
+        mExprClass.def(method.c_str(),
+            detail::recorded(method, true, +funcScalar),
             pybind11::arg("scalar"), description.c_str());
-        mExprClass.def(("__" + name + "__").c_str(), funcScalarExpr,
+        mExprClass.def(method.c_str(),
+            detail::recorded(method, true, +funcScalarExpr),
             pybind11::arg("expression"), description.c_str());
     }
 
@@ -186,9 +247,12 @@ can be a tangent vector or gradient.)doc");
         FuncRScalar&& funcRScalar, FuncRScalarExpr&& funcRScalarExpr,
         std::string const& description)
     {
-        mExprClass.def(("__r" + name + "__").c_str(), funcRScalar,
+        auto const method = "__r" + name + "__";
+        mExprClass.def(method.c_str(),
+            detail::recorded(method, true, +funcRScalar),
             pybind11::arg("scalar"), description.c_str());
-        mExprClass.def(("__r" + name + "__").c_str(), funcRScalarExpr,
+        mExprClass.def(method.c_str(),
+            detail::recorded(method, true, +funcRScalarExpr),
             pybind11::arg("expression"), description.c_str());
     }
 
@@ -197,7 +261,9 @@ can be a tangent vector or gradient.)doc");
     void defUnaryOp(
         std::string const& name, Func&& func, std::string const& description)
     {
-        mExprClass.def(("__" + name + "__").c_str(), func, description.c_str());
+        auto const method = "__" + name + "__";
+        mExprClass.def(method.c_str(), detail::recorded(method, true, +func),
+            description.c_str());
     }
 
 private:
@@ -210,8 +276,8 @@ template <typename Func>
 void defUnaryOp(pybind11::module& module, std::string const& name, Func&& func,
     std::string const& description)
 {
-    module.def(
-        name.c_str(), func, pybind11::arg("operand"), description.c_str());
+    module.def(name.c_str(), detail::recorded(name, false, +func),
+        pybind11::arg("operand"), description.c_str());
 }
 
 template <typename FuncExpr, typename FuncValue, typename FuncRValue>
@@ -219,12 +285,12 @@ void defBinaryOp(pybind11::module& module, std::string const& name,
     FuncExpr&& funcExpr, FuncValue&& funcValue, FuncRValue&& funcRValue,
     std::string const& description)
 {
-    module.def(name.c_str(), funcExpr, pybind11::arg("lhs"),
-        pybind11::arg("rhs"), description.c_str());
-    module.def(name.c_str(), funcValue, pybind11::arg("lhs"),
-        pybind11::arg("rhs"), description.c_str());
-    module.def(name.c_str(), funcRValue, pybind11::arg("lhs"),
-        pybind11::arg("rhs"), description.c_str());
+    module.def(name.c_str(), detail::recorded(name, false, +funcExpr),
+        pybind11::arg("lhs"), pybind11::arg("rhs"), description.c_str());
+    module.def(name.c_str(), detail::recorded(name, false, +funcValue),
+        pybind11::arg("lhs"), pybind11::arg("rhs"), description.c_str());
+    module.def(name.c_str(), detail::recorded(name, false, +funcRValue),
+        pybind11::arg("lhs"), pybind11::arg("rhs"), description.c_str());
 }
 
 } // namespace AutoDiff::Python
@@ -233,15 +299,18 @@ void defBinaryOp(pybind11::module& module, std::string const& name,
     binding, name, operation, description)                                     \
     {                                                                          \
         using Binding = decltype(binding);                                     \
+        using Expr    = typename Binding::Expr;                                \
+        using Op      = typename Binding::Op;                                  \
+        using Value   = typename Binding::Value;                               \
                                                                                \
-        auto funcExpr = [](Binding::Expr const& x, Binding::Expr const& y) {   \
-            return Binding::Op{operation(x.wrapper(), y.wrapper())};           \
+        auto funcExpr = [](Expr const& x, Expr const& y) {                     \
+            return Op{operation(x.wrapper(), y.wrapper())};                    \
         };                                                                     \
-        auto funcValue = [](Binding::Expr const& x, Binding::Value y) {        \
-            return Binding::Op{operation(x.wrapper(), std::move(y))};          \
+        auto funcValue = [](Expr const& x, Value y) {                          \
+            return Op{operation(x.wrapper(), std::move(y))};                   \
         };                                                                     \
-        auto funcRValue = [](Binding::Expr const& y, Binding::Value x) {       \
-            return Binding::Op{operation(std::move(x), y.wrapper())};          \
+        auto funcRValue = [](Expr const& y, Value x) {                         \
+            return Op{operation(std::move(x), y.wrapper())};                   \
         };                                                                     \
         binding.defInfixOp(name, funcExpr, funcValue, description);            \
         binding.defRInfixOp(name, funcRValue, description);                    \
@@ -252,17 +321,22 @@ void defBinaryOp(pybind11::module& module, std::string const& name,
     {                                                                          \
         using BindingX = decltype(bindingX);                                   \
         using BindingY = decltype(bindingY);                                   \
+        using ExprX    = typename BindingX::Expr;                              \
+        using ExprY    = typename BindingY::Expr;                              \
+        using Op       = typename Binding::Op;                                 \
+        using ValueX   = typename BindingX::Value;                             \
+        using ValueY   = typename BindingY::Value;                             \
                                                                                \
-        auto funcExpr = [](BindingX::Expr const& x, BindingY::Expr const& y) { \
-            return Binding::Op{operation(x.wrapper(), y.wrapper())};           \
+        auto funcExpr = [](ExprX const& x, ExprY const& y) {                   \
+            return Op{operation(x.wrapper(), y.wrapper())};                    \
         };                                                                     \
-        auto funcValue = [](BindingX::Expr const& x, BindingY::Value y) {      \
-            return Binding::Op{operation(x.wrapper(), std::move(y))};          \
+        auto funcValue = [](ExprX const& x, ValueY y) {                        \
+            return Op{operation(x.wrapper(), std::move(y))};                   \
         };                                                                     \
         bindingX.defInfixOp(name, funcExpr, funcValue, description);           \
-        if constexpr (std::is_arithmetic_v<BindingX::Value>) {                 \
-            auto funcRValue = [](BindingY::Expr const& y, BindingX::Value x) { \
-                return Binding::Op{operation(std::move(x), y.wrapper())};      \
+        if constexpr (std::is_arithmetic_v<ValueX>) {                          \
+            auto funcRValue = [](ExprY const& y, ValueX x) {                   \
+                return Op{operation(std::move(x), y.wrapper())};               \
             };                                                                 \
             bindingY.defRInfixOp(name, funcRValue, description);               \
         }                                                                      \
@@ -271,9 +345,11 @@ void defBinaryOp(pybind11::module& module, std::string const& name,
 #define AUTODIFF_PYTHON_DEF_METHOD(binding, name, operation, description)      \
     {                                                                          \
         using Binding = decltype(binding);                                     \
+        using Expr    = typename Binding::Expr;                                \
+        using Op      = typename Binding::Op;                                  \
                                                                                \
-        auto func = [](Binding::Expr const& x) {                               \
-            return Binding::Op{operation(x.wrapper())};                        \
+        auto func = [](Expr const& x) {                                        \
+            return Op{operation(x.wrapper())};                                 \
         };                                                                     \
         binding.defUnaryOp(name, func, description);                           \
     }
@@ -281,8 +357,10 @@ void defBinaryOp(pybind11::module& module, std::string const& name,
 #define AUTODIFF_PYTHON_DEF_UNARY_OP(                                          \
     Binding, module, name, operation, description)                             \
     {                                                                          \
-        auto func = [](Binding::Expr const& x) {                               \
-            return Binding::Op{operation(x.wrapper())};                        \
+        using Expr = typename Binding::Expr;                                   \
+        using Op   = typename Binding::Op;                                     \
+        auto func = [](Expr const& x) {                                        \
+            return Op{operation(x.wrapper())};                                 \
         };                                                                     \
         AutoDiff::Python::defUnaryOp(module, name, func, description);         \
     }
@@ -290,8 +368,10 @@ void defBinaryOp(pybind11::module& module, std::string const& name,
 #define AUTODIFF_PYTHON_DEF_REDUCTION(                                         \
     BindingX, Binding, module, name, operation, description)                   \
     {                                                                          \
-        auto func = [](BindingX::Expr const& x) {                              \
-            return Binding::Op{operation(x.wrapper())};                        \
+        using ExprX = typename BindingX::Expr;                                 \
+        using Op    = typename Binding::Op;                                    \
+        auto func = [](ExprX const& x) {                                       \
+            return Op{operation(x.wrapper())};                                 \
         };                                                                     \
         AutoDiff::Python::defUnaryOp(module, name, func, description);         \
     }
@@ -299,14 +379,19 @@ void defBinaryOp(pybind11::module& module, std::string const& name,
 #define AUTODIFF_PYTHON_DEF_BINARY_OP(                                         \
     BindingX, BindingY, Binding, module, name, operation, description)         \
     {                                                                          \
-        auto funcExpr = [](BindingX::Expr const& x, BindingY::Expr const& y) { \
-            return Binding::Op{operation(x.wrapper(), y.wrapper())};           \
+        using ExprX  = typename BindingX::Expr;                                \
+        using ExprY  = typename BindingY::Expr;                                \
+        using Op     = typename Binding::Op;                                   \
+        using ValueX = typename BindingX::Value;                               \
+        using ValueY = typename BindingY::Value;                               \
+        auto funcExpr = [](ExprX const& x, ExprY const& y) {                   \
+            return Op{operation(x.wrapper(), y.wrapper())};                    \
         };                                                                     \
-        auto funcValue = [](BindingX::Expr const& x, BindingY::Value y) {      \
-            return Binding::Op{operation(x.wrapper(), std::move(y))};          \
+        auto funcValue = [](ExprX const& x, ValueY y) {                        \
+            return Op{operation(x.wrapper(), std::move(y))};                   \
         };                                                                     \
-        auto funcRValue = [](BindingX::Value x, BindingY::Expr const& y) {     \
-            return Binding::Op{operation(std::move(x), y.wrapper())};          \
+        auto funcRValue = [](ValueX x, ExprY const& y) {                       \
+            return Op{operation(std::move(x), y.wrapper())};                   \
         };                                                                     \
         AutoDiff::Python::defBinaryOp(                                         \
             module, name, funcExpr, funcValue, funcRValue, description);       \
@@ -315,14 +400,18 @@ void defBinaryOp(pybind11::module& module, std::string const& name,
 #define AUTODIFF_PYTHON_DEF_BROADCAST_INFIX_OP(                                \
     binding, name, operation, description)                                     \
     {                                                                          \
-        using Binding = decltype(binding);                                     \
+        using Binding    = decltype(binding);                                  \
+        using Expr       = typename Binding::Expr;                             \
+        using Op         = typename Binding::Op;                               \
+        using Scalar     = typename Binding::Scalar;                           \
+        using ScalarExpr = typename Binding::ScalarExpr;                       \
                                                                                \
-        auto funcScalar = [](Binding::Expr const& x, Binding::Scalar y) {      \
-            return Binding::Op{operation(x.wrapper(), std::move(y))};          \
+        auto funcScalar = [](Expr const& x, Scalar y) {                        \
+            return Op{operation(x.wrapper(), std::move(y))};                   \
         };                                                                     \
         auto funcScalarExpr                                                    \
-            = [](Binding::Expr const& x, Binding::ScalarExpr const& y) {       \
-                  return Binding::Op{operation(x.wrapper(), y.wrapper())};     \
+            = [](Expr const& x, ScalarExpr const& y) {                         \
+                  return Op{operation(x.wrapper(), y.wrapper())};              \
               };                                                               \
         binding.defBroadcastInfixOp(                                           \
             name, funcScalar, funcScalarExpr, description);                    \
@@ -331,14 +420,18 @@ void defBinaryOp(pybind11::module& module, std::string const& name,
 #define AUTODIFF_PYTHON_DEF_R_BROADCAST_INFIX_OP(                              \
     binding, name, operation, description)                                     \
     {                                                                          \
-        using Binding = decltype(binding);                                     \
+        using Binding    = decltype(binding);                                  \
+        using Expr       = typename Binding::Expr;                             \
+        using Op         = typename Binding::Op;                               \
+        using Scalar     = typename Binding::Scalar;                           \
+        using ScalarExpr = typename Binding::ScalarExpr;                       \
                                                                                \
-        auto funcRScalar = [](Binding::Expr const& y, Binding::Scalar x) {     \
-            return Binding::Op{operation(std::move(x), y.wrapper())};          \
+        auto funcRScalar = [](Expr const& y, Scalar x) {                       \
+            return Op{operation(std::move(x), y.wrapper())};                   \
         };                                                                     \
         auto funcRScalarExpr                                                   \
-            = [](Binding::Expr const& y, Binding::ScalarExpr const& x) {       \
-                  return Binding::Op{operation(x.wrapper(), y.wrapper())};     \
+            = [](Expr const& y, ScalarExpr const& x) {                         \
+                  return Op{operation(x.wrapper(), y.wrapper())};              \
               };                                                               \
         binding.defRBroadcastInfixOp(                                          \
             name, funcRScalar, funcRScalarExpr, description);                  \
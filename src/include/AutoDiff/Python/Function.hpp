@@ -0,0 +1,1003 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_FUNCTION_HPP
+#define AUTODIFF_PYTHON_FUNCTION_HPP
+
+#include "AbstractVariable.hpp"
+#include "Evaluator.hpp"        // CacheScope
+#include "Profiler.hpp"
+#include "State.hpp" // graph and value versions
+#include "ThreadPool.hpp"
+
+#include <AutoDiff/src/Core/AbstractVariable.hpp>
+#include <AutoDiff/src/Core/Function.hpp>
+#include <pybind11/pybind11.h>
+
+#include <algorithm>  // all_of, any_of, equal, max, none_of, sort, unique
+#include <chrono>     // seconds
+#include <cstddef>    // size_t
+#include <functional> // invoke, less
+#include <future>     // future_status, shared_future
+#include <map>
+#include <memory>     // shared_ptr, unique_ptr
+#include <optional>
+#include <stdexcept>  // invalid_argument, runtime_error
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>    // exchange, move, pair
+#include <vector>
+
+namespace AutoDiff::Python {
+
+// Records the variables read by evaluations on this thread while in scope,
+// if not null
+class ReadScope {
+public:
+    explicit ReadScope(detail::Reads* reads)
+        : mPrevious{std::exchange(detail::threadState().reads, reads)}
+    {
+    }
+
+    ~ReadScope() { detail::threadState().reads = mPrevious; }
+
+    ReadScope(ReadScope const&)                    = delete;
+    ReadScope(ReadScope&&)                         = delete;
+    auto operator=(ReadScope const&) -> ReadScope& = delete;
+    auto operator=(ReadScope&&) -> ReadScope&      = delete;
+
+private:
+    detail::Reads* mPrevious;
+};
+
+// Runs a second-order sweep on this thread while in scope (see Function::hvp)
+class SecondOrderScope {
+public:
+    explicit SecondOrderScope(detail::SecondOrder* sweep)
+        : mPrevious{std::exchange(detail::threadState().secondOrder, sweep)}
+    {
+    }
+
+    ~SecondOrderScope() { detail::threadState().secondOrder = mPrevious; }
+
+    SecondOrderScope(SecondOrderScope const&)                    = delete;
+    SecondOrderScope(SecondOrderScope&&)                         = delete;
+    auto operator=(SecondOrderScope const&) -> SecondOrderScope& = delete;
+    auto operator=(SecondOrderScope&&) -> SecondOrderScope&      = delete;
+
+private:
+    detail::SecondOrder* mPrevious;
+};
+
+// AutoDiff function with execution options for the Python bindings
+class Function : public AutoDiff::Function {
+public:
+    using AutoDiff::Function::Function;
+
+    [[nodiscard]] auto retainsCache() const -> bool { return mRetainCache; }
+
+    void setRetainCache(bool retain) { mRetainCache = retain; }
+
+    [[nodiscard]] auto releasesGil() const -> bool { return mReleaseGil; }
+
+    void setReleaseGil(bool release) { mReleaseGil = release; }
+
+    // number of threads running the levels of the graph (see schedule)
+    [[nodiscard]] auto threads() const -> std::size_t
+    {
+        return mPool ? mPool->size() : 1;
+    }
+
+    // one runs the whole program on the calling thread, zero means one
+    // thread per hardware thread
+    void setThreads(std::size_t threads)
+    {
+        mPool = threads == 1 ? nullptr : std::make_unique<ThreadPool>(threads);
+        unschedule();
+    }
+
+    // Python variables passed at construction (the sources might not be the
+    // actual sources of the function)
+    void setVariables(pybind11::tuple sources, pybind11::tuple targets)
+    {
+        mSourceVariables.clear();
+        mSourceKeys.clear();
+        for (auto const& source : sources) {
+            auto const& variable = source.cast<AbstractVariable const&>();
+            mSourceVariables.push_back(&variable);
+            mSourceKeys.insert(variable._node());
+        }
+        mTargetVariables.clear();
+        for (auto const& target : targets) {
+            mTargetVariables.push_back(&target.cast<AbstractVariable const&>());
+        }
+        mSources = std::move(sources);
+        mTargets = std::move(targets);
+    }
+
+    // statuses of variables, sorted and without duplicates
+    using Statuses = std::vector<std::shared_ptr<detail::VariableStatus>>;
+
+    // The statuses of the variables of the graph, including intermediate
+    // variables and inferred sources.
+    // If the graph is not known (see sortGraph), only those of the variables
+    // passed at construction.
+    [[nodiscard]] auto variableStatuses() const -> Statuses
+    {
+        auto statuses = Statuses{};
+        if (auto const graph = sortGraph()) {
+            for (auto const* variables : {&graph->variables, &graph->leaves}) {
+                for (auto const& variable : *variables) {
+                    statuses.push_back(variable.status);
+                }
+            }
+        }
+        for (auto const* variables : {&mSourceVariables, &mTargetVariables}) {
+            for (auto const* variable : *variables) {
+                statuses.push_back(variable->_status());
+            }
+        }
+        std::sort(statuses.begin(), statuses.end());
+        statuses.erase(
+            std::unique(statuses.begin(), statuses.end()), statuses.end());
+        return statuses;
+    }
+
+    // Locks the variables of the graph (see variableStatuses) against
+    // modifications while an asynchronous sweep runs (see Variable::set)
+    [[nodiscard]] auto lockVariables() const -> Statuses
+    {
+        auto locked = variableStatuses();
+        for (auto const& status : locked) {
+            ++status->locks;
+        }
+        return locked;
+    }
+
+    static void unlockVariables(Statuses const& locked)
+    {
+        for (auto const& status : locked) {
+            --status->locks;
+        }
+    }
+
+    // graph of the function, for memory reports
+    struct Summary {
+        std::map<std::string, std::size_t> operations; // nodes by type
+        std::size_t variables       = 0;
+        std::size_t valueBytes      = 0; // held by the variables
+        std::size_t derivativeBytes = 0;
+        std::vector<std::size_t> levels; // variables with expressions by depth
+    };
+
+    // Summary of the graph and the variables passed at construction,
+    // empty if the graph is not known (see sortGraph)
+    [[nodiscard]] auto summary() const -> std::optional<Summary>
+    {
+        auto const graph = sortGraph();
+        if (!graph) {
+            return std::nullopt;
+        }
+        auto summary    = Summary{};
+        auto operations = std::unordered_set<void const*>{}; // counted
+        auto held       = std::unordered_set<void const*>{}; // variables
+        for (auto const& variable : graph->variables) {
+            auto const& operands = *variable.status->operands;
+            for (std::size_t i = 0; i < operands.operations.size(); ++i) {
+                if (operations.insert(operands.operations[i]).second) {
+                    ++summary.operations[*operands.names[i]];
+                }
+            }
+            // read variables, whose evaluators hold them
+            for (auto const& operand : operands.variables.reads) {
+                if (held.insert(operand.key).second) {
+                    summary.valueBytes += operand.slot->valueBytes();
+                    summary.derivativeBytes += operand.slot->derivativeBytes();
+                }
+            }
+            auto const depth
+                = static_cast<std::size_t>(graph->depths.at(variable.key));
+            summary.levels.resize(std::max(summary.levels.size(), depth + 1));
+            ++summary.levels[depth];
+        }
+        // including the variables passed at construction, even if not read
+        for (auto const* variables : {&mSourceVariables, &mTargetVariables}) {
+            for (auto const* variable : *variables) {
+                if (held.insert(variable->_node()).second) {
+                    summary.valueBytes += variable->_valueBytes();
+                    summary.derivativeBytes += variable->_derivativeBytes();
+                }
+            }
+        }
+        summary.variables = held.size();
+        return summary;
+    }
+
+    // whether the last asynchronous sweep has not completed yet
+    [[nodiscard]] auto running() const -> bool
+    {
+        return mPending.valid()
+            && mPending.wait_for(std::chrono::seconds{0})
+            != std::future_status::ready;
+    }
+
+    // waits for the last asynchronous sweep (and thus all previous ones)
+    void wait() const
+    {
+        if (mPending.valid()) {
+            mPending.wait();
+        }
+    }
+
+    void setPending(std::shared_future<void> pending)
+    {
+        mPending = std::move(pending);
+    }
+
+    [[nodiscard]] auto incremental() const -> bool { return mIncremental; }
+
+    // incremental sweeps run the steps of the levels (see schedule)
+    void setIncremental(bool incremental)
+    {
+        mIncremental = incremental;
+        unschedule();
+    }
+
+    // enabling starts a new profile, disabling keeps the recorded one
+    void setProfiling(bool enabled)
+    {
+        if (enabled) {
+            mProfiler = std::make_unique<Profiler>();
+        }
+        mProfiling = enabled;
+    }
+
+    // null if never profiled
+    [[nodiscard]] auto profiler() const -> Profiler const*
+    {
+        return mProfiler.get();
+    }
+
+    [[nodiscard]] auto sources() const -> pybind11::tuple
+    {
+        return mSources ? pybind11::reinterpret_borrow<pybind11::tuple>(mSources)
+                        : pybind11::tuple{};
+    }
+
+    [[nodiscard]] auto targets() const -> pybind11::tuple
+    {
+        return mTargets ? pybind11::reinterpret_borrow<pybind11::tuple>(mTargets)
+                        : pybind11::tuple{};
+    }
+
+    // Skips compilation if no expression was set since the last compilation,
+    // or if the structure of the graph is still the same: no variable of the
+    // graph reads other variables than at the last compilation.
+    // With several threads or if incremental, also schedules the levels of
+    // the graph.
+    void compile()
+    {
+        auto const version = detail::state().graphVersion.load();
+        if (compiled() && mScheduled) {
+            if (version == mCompiledVersion) {
+                return;
+            }
+            if (unchanged()) {
+                if (auto const graph = splits() ? sortGraph() : std::nullopt) {
+                    mLevels = schedule(*graph); // might share other operations
+                }
+                mCompiledVersion = version;
+                return;
+            }
+        }
+        AutoDiff::Function::compile();
+        auto const graph = sortGraph();
+        mStructure.clear();
+        if (graph) {
+            for (auto const* variables : {&graph->variables, &graph->leaves}) {
+                for (auto const& variable : *variables) {
+                    auto const& status = variable.status;
+                    auto operands      = std::vector<void const*>{};
+                    if (status->operands) {
+                        for (auto const& operand :
+                            status->operands->variables.reads) {
+                            operands.push_back(operand.key);
+                        }
+                    }
+                    mStructure.push_back(
+                        {status, status->structure, std::move(operands)});
+                }
+            }
+        }
+        mStructureKnown  = graph.has_value();
+        mLevels          = splits() && graph ? schedule(*graph) : Levels{};
+        mScheduled       = true;
+        mCompiledVersion = version;
+    }
+
+    // Skips evaluation if incremental and none of the variables read by the
+    // last one was modified since.
+    // Otherwise, an incremental function whose graph is unchanged only
+    // evaluates the steps affected by the modifications (see runCone).
+    void evaluate()
+    {
+        if (mIncremental && upToDate()) {
+            return;
+        }
+        auto const scope        = CacheScope{mRetainCache};
+        auto const profile      = ProfileScope{activeProfiler()};
+        auto const graphVersion = detail::state().graphVersion.load();
+        if (splits()) {
+            compile(); // might have been skipped by the user
+        }
+        if (mIncremental && mEvaluated && mReads.complete && !mLevels.empty()
+            && mEvaluatedGraphVersion == graphVersion) {
+            auto const version = mEvaluatedValueVersion;
+            auto const record  = ReadScope{nullptr}; // same as last time
+            mEvaluated         = false;              // in case of exceptions
+            auto const evaluated = runCone(&AutoDiff::Function::evaluate,
+                [version](detail::VariableStatus const& status) {
+                    return status.modified > version;
+                });
+            for (auto* status : evaluated) {
+                status->modified = ++detail::state().valueVersion;
+            }
+            mEvaluated             = true;
+            mEvaluatedValueVersion = detail::state().valueVersion.load();
+            return;
+        }
+
+        auto reads        = detail::Reads{};
+        auto const record = ReadScope{&reads};
+        mEvaluated        = false; // in case of exceptions
+        runSweep(&AutoDiff::Function::evaluate, &reads);
+
+        // modified for other functions reading them
+        for (auto const* target : mTargetVariables) {
+            target->_touch();
+        }
+        auto& read       = reads.reads;
+        auto const order = [](auto const& lhs, auto const& rhs) {
+            return std::less<>{}(lhs.key, rhs.key);
+        };
+        auto const same = [](auto const& lhs, auto const& rhs) {
+            return lhs.key == rhs.key;
+        };
+        std::sort(read.begin(), read.end(), order);
+        read.erase(std::unique(read.begin(), read.end(), same), read.end());
+        for (auto const& variable : read) {
+            // evaluated, unless a source
+            if (variable.status->hasExpression
+                && mSourceKeys.count(variable.key) == 0) {
+                variable.status->modified = ++detail::state().valueVersion;
+            }
+        }
+        mReads                 = std::move(reads);
+        mEvaluated             = true;
+        mEvaluatedGraphVersion = graphVersion;
+        mEvaluatedValueVersion = detail::state().valueVersion.load();
+    }
+
+    // An incremental function only pushes the tangents through the steps
+    // affected by modifications of values and derivatives since its last
+    // call, unless another sweep wrote derivatives in the meantime (see
+    // State::derivativeVersion)
+    void pushTangent()
+    {
+        auto const scope        = CacheScope{mRetainCache};
+        auto const profile      = ProfileScope{activeProfiler()};
+        auto const graphVersion = detail::state().graphVersion.load();
+        if (splits()) {
+            compile(); // might have been skipped by the user
+        }
+        auto& derivativeVersion = detail::state().derivativeVersion;
+        if (mIncremental && mPushed && !mLevels.empty()
+            && mPushedGraphVersion == graphVersion
+            && mPushedDerivativeVersion == derivativeVersion.load()) {
+            auto const version = mPushedVersion;
+            mPushed            = false; // in case of exceptions
+            auto const pushed  = runCone(&AutoDiff::Function::pushTangent,
+                [version](detail::VariableStatus const& status) {
+                    return status.modified > version
+                        || status.derivativeModified > version;
+                });
+            for (auto* status : pushed) {
+                status->derivativeModified = ++detail::state().valueVersion;
+            }
+        } else {
+            mPushed = false;
+            ++derivativeVersion; // of any variable of the graph
+            runSweep(&AutoDiff::Function::pushTangent, nullptr);
+        }
+        mPushed                  = true;
+        mPushedGraphVersion      = graphVersion;
+        mPushedVersion           = detail::state().valueVersion.load();
+        mPushedDerivativeVersion = derivativeVersion.load();
+    }
+
+    // Seeds the leaves of the graph (the sources passed at construction and
+    // any other variable without an expression) to run the levels, like the
+    // whole program seeds its sources
+    void pushTangentAt(AbstractVariable const& seed)
+    {
+        auto const scope   = CacheScope{mRetainCache};
+        auto const profile = ProfileScope{activeProfiler()};
+        if (splits()) {
+            compile(); // might have been skipped by the user
+        }
+        ++detail::state().derivativeVersion;
+        if (mLevels.empty() || mLeafSlots.count(seed._node()) == 0) {
+            AutoDiff::Function::pushTangentAt(seed);
+            return;
+        }
+        auto const count = sizeOf(seed);
+        for (auto const& [key, slot] : mLeafSlots) {
+            slot->seed(key == seed._node(), count, true);
+        }
+        runSweep(&AutoDiff::Function::pushTangent, nullptr);
+    }
+
+    void pullGradient()
+    {
+        auto const scope   = CacheScope{mRetainCache};
+        auto const profile = ProfileScope{activeProfiler()};
+        if (splits()) {
+            compile(); // might have been skipped by the user
+        }
+        ++detail::state().derivativeVersion;
+        if (mLevels.empty() || !mSeparable) {
+            AutoDiff::Function::pullGradient();
+            return;
+        }
+        pullLevels();
+    }
+
+    void pullGradientAt(AbstractVariable const& seed)
+    {
+        auto const scope   = CacheScope{mRetainCache};
+        auto const profile = ProfileScope{activeProfiler()};
+        if (splits()) {
+            compile(); // might have been skipped by the user
+        }
+        ++detail::state().derivativeVersion;
+        auto const isSeed = [&](AbstractVariable const* target) {
+            return target->_node() == seed._node();
+        };
+        if (mLevels.empty() || !mSeparable
+            || std::none_of(
+                mTargetVariables.begin(), mTargetVariables.end(), isSeed)) {
+            AutoDiff::Function::pullGradientAt(seed);
+            return;
+        }
+        auto const count = sizeOf(seed);
+        for (auto const* target : mTargetVariables) {
+            target->_seed(isSeed(target), count, false);
+        }
+        pullLevels();
+    }
+
+    // Hessian-vector product of a scalar target (the seed), given the
+    // tangents of the sources as single directions in their derivatives, and
+    // stored in them as gradient rows.
+    // Forward-over-reverse through the evaluators of the graph, at the values
+    // of a new evaluation: the tangents are pushed through the variables in
+    // topological order, then the gradient of the seed and its tangent are
+    // pulled back together in reverse order.
+    void hvp(AbstractVariable const& seed)
+    {
+        auto const isSeed = [&](AbstractVariable const* target) {
+            return target->_node() == seed._node();
+        };
+        if (std::none_of(
+                mTargetVariables.begin(), mTargetVariables.end(), isSeed)) {
+            throw std::invalid_argument("The seed must be a target.");
+        }
+        if (sizeOf(seed) != 1) {
+            throw std::invalid_argument("The seed must be a scalar.");
+        }
+        auto const graph = sortGraph();
+        if (!graph) {
+            throw std::runtime_error(
+                "Hessian-vector products need the graph of the function, "
+                "whose variables must all be created from Python.");
+        }
+        // a full evaluation whose caches stay for the sweep, also on the
+        // threads of the pool
+        struct Retain {
+            bool& retain;
+            bool previous;
+            ~Retain() { retain = previous; }
+        };
+        auto const scope = CacheScope{true};
+        {
+            auto const retain
+                = Retain{mRetainCache, std::exchange(mRetainCache, true)};
+            mEvaluated = false;
+            evaluate();
+        }
+        ++detail::state().derivativeVersion;
+        mPushed = false;
+
+        auto sweep       = detail::SecondOrder{};
+        sweep.directions = &mSourceKeys;
+        auto const running = SecondOrderScope{&sweep};
+        for (auto const& variable : graph->variables) {
+            variable.status->operands->root->pushTangent(variable.key);
+        }
+        if (graph->depths.at(seed._node()) >= 0) { // zero for a leaf
+            seed._status()->operands->root->seed(seed._node());
+        }
+        for (auto it = graph->variables.rbegin(); it != graph->variables.rend();
+            ++it) {
+            it->status->operands->root->pullBack(it->key);
+        }
+        // by the slots of the expressions reading them, zero if not read
+        auto slots = std::unordered_map<void const*, detail::GradientSlot*>{};
+        for (auto const& variable : graph->variables) {
+            for (auto const& read : variable.status->operands->variables.reads) {
+                if (read.slot != nullptr && mSourceKeys.count(read.key) != 0) {
+                    slots.emplace(read.key, read.slot);
+                }
+            }
+        }
+        for (auto const* source : mSourceVariables) {
+            auto const found = slots.find(source->_node());
+            if (found != slots.end()) {
+                found->second->storeProduct();
+            } else {
+                source->_seed(false, 1, false);
+            }
+        }
+    }
+
+private:
+    // function of a variable, see schedule
+    struct Step {
+        std::size_t structure = 0; // of the variable when compiled
+        std::unique_ptr<AutoDiff::Function> function;
+    };
+
+    // functions of the variables in a level (owned by the steps)
+    struct Level {
+        std::vector<AutoDiff::Function*> functions;
+        bool parallel = true; // false if their expressions share operations
+        // false if they also read the same variables, whose derivatives they
+        // would set at the same time when pulling gradients back
+        bool parallelGradient = true;
+        // by function, the variables read by other functions as well, whose
+        // gradients are kept (see GradientSlot)
+        std::vector<std::vector<detail::GradientSlot*>> kept;
+        // variables of the level read by several functions, whose kept
+        // gradients are restored before the level pulls them back
+        std::vector<detail::GradientSlot*> sums;
+        // by function, its variable and the variables it reads
+        std::vector<detail::Reads::Read> variables;
+        std::vector<std::vector<detail::Reads::Read>> operands;
+    };
+
+    using Levels = std::vector<Level>;
+
+    [[nodiscard]] auto activeProfiler() const -> Profiler*
+    {
+        return mProfiling ? mProfiler.get() : nullptr;
+    }
+
+    [[nodiscard]] static auto
+    sizeOf(AbstractVariable const& variable) -> pybind11::ssize_t
+    {
+        auto size = pybind11::ssize_t{1};
+        for (auto const extent : variable._shape()) {
+            size *= extent;
+        }
+        return size;
+    }
+
+    // whether to split the graph into levels of steps (see schedule)
+    [[nodiscard]] auto splits() const -> bool { return mPool || mIncremental; }
+
+    // drops the levels, scheduled again by the next compilation
+    void unschedule()
+    {
+        mScheduled = false;
+        mLevels.clear();
+        mSteps.clear();
+        mLeafSums.clear();
+        mLeafSlots.clear();
+    }
+
+    // Runs `size` tasks for the functions of a level, on the thread pool if
+    // parallel.
+    // While profiling, the level runs on the calling thread, since the
+    // profiler is not thread-safe.
+    template <typename Task>
+    void runLevel(std::size_t size, bool parallel, Task const& task)
+    {
+        if (!mPool || !parallel || size <= 1 || activeProfiler() != nullptr) {
+            for (std::size_t i = 0; i < size; ++i) {
+                task(i);
+            }
+            return;
+        }
+        mPool->parallelFor(size, [&](std::size_t i) {
+            auto const scope = CacheScope{mRetainCache};
+            task(i);
+        });
+    }
+
+    // Runs a sweep in the direction of evaluation through the whole program,
+    // or level by level on the thread pool, recording the variables read by
+    // the levels if not null
+    template <typename Sweep>
+    void runSweep(Sweep sweep, detail::Reads* reads)
+    {
+        if (splits()) {
+            compile(); // might have been skipped by the user
+        }
+        if (mLevels.empty()) {
+            std::invoke(sweep, static_cast<AutoDiff::Function&>(*this));
+            return;
+        }
+        for (auto const& level : mLevels) {
+            auto const& functions = level.functions;
+            auto levelReads
+                = std::vector<detail::Reads>(reads ? functions.size() : 0);
+            runLevel(functions.size(), level.parallel, [&](std::size_t i) {
+                auto const record = ReadScope{reads ? &levelReads[i] : nullptr};
+                std::invoke(sweep, *functions[i]);
+            });
+            if (reads != nullptr) {
+                for (auto& read : levelReads) {
+                    reads->reads.insert(reads->reads.end(),
+                        read.reads.begin(), read.reads.end());
+                    reads->complete = reads->complete && read.complete;
+                }
+            }
+        }
+    }
+
+    // Pulls the gradients back level by level, in reverse order.
+    // The gradients pulled into a variable read by several functions are
+    // kept after each of them and summed before the level of the variable
+    // (or, for leaves, at the end), since each function sets the gradients
+    // of the variables it reads.
+    void pullLevels()
+    {
+        for (auto level = mLevels.rbegin(); level != mLevels.rend(); ++level) {
+            for (auto* slot : level->sums) {
+                slot->restore();
+            }
+            auto const& functions = level->functions;
+            auto const& kept      = level->kept;
+            runLevel(functions.size(),
+                level->parallel && level->parallelGradient, [&](std::size_t i) {
+                    functions[i]->pullGradient();
+                    for (auto* slot : kept[i]) {
+                        slot->keep();
+                    }
+                });
+        }
+        for (auto* slot : mLeafSums) {
+            slot->restore();
+        }
+    }
+
+    // Runs a sweep in the direction of evaluation through the steps of the
+    // cone of modifications: the steps whose variable or one of the
+    // variables it reads was modified, and the steps downstream of them.
+    // Returns the statuses of the variables of the steps run.
+    template <typename Sweep, typename Modified>
+    auto runCone(Sweep sweep, Modified const& modified)
+        -> std::vector<detail::VariableStatus*>
+    {
+        auto run   = std::vector<detail::VariableStatus*>{};
+        auto dirty = std::unordered_set<void const*>{}; // variables run
+        for (auto const& level : mLevels) {
+            auto indices = std::vector<std::size_t>{};
+            for (std::size_t i = 0; i < level.functions.size(); ++i) {
+                auto const& operands = level.operands[i];
+                if (modified(*level.variables[i].status)
+                    || std::any_of(operands.begin(), operands.end(),
+                        [&](detail::Reads::Read const& operand) {
+                            return dirty.count(operand.key) != 0
+                                || modified(*operand.status);
+                        })) {
+                    indices.push_back(i);
+                }
+            }
+            for (auto const i : indices) { // read by higher levels only
+                dirty.insert(level.variables[i].key);
+                run.push_back(level.variables[i].status.get());
+            }
+            runLevel(indices.size(), level.parallel, [&](std::size_t i) {
+                std::invoke(sweep, *level.functions[indices[i]]);
+            });
+        }
+        return run;
+    }
+
+    // variables reachable from the targets, see sortGraph
+    struct Graph {
+        std::vector<detail::Reads::Read> variables; // in topological order
+        std::vector<detail::Reads::Read> leaves; // sources and literals
+        std::unordered_map<void const*, int> depths; // -1 for leaves
+    };
+
+    // The variables reachable from the targets, not beyond the sources.
+    // Variables with an expression are sorted topologically and their depth is
+    // the length of the longest path from a leaf.
+    // Empty if the expression of a variable was not recorded (the variable
+    // was not created from Python) or if the graph has a cycle.
+    [[nodiscard]] auto sortGraph() const -> std::optional<Graph>
+    {
+        using Read   = detail::Reads::Read;
+        auto graph   = Graph{};
+        auto& depths = graph.depths;
+        auto pending = std::unordered_set<void const*>{}; // being visited
+        // depth-first search without recursion (graphs can be deep)
+        auto stack = std::vector<std::pair<Read, bool>>{};
+        for (auto const* target : mTargetVariables) {
+            stack.push_back({{target->_node(), target->_status()}, false});
+        }
+        while (!stack.empty()) {
+            auto const [variable, expanded] = stack.back();
+            auto const& status              = *variable.status;
+            if (depths.count(variable.key) != 0) {
+                stack.pop_back();
+            } else if (!status.hasExpression
+                || mSourceKeys.count(variable.key) != 0) {
+                stack.pop_back();
+                depths.emplace(variable.key, -1);
+                graph.leaves.push_back(variable);
+            } else if (!status.operands
+                || !status.operands->variables.complete) {
+                return std::nullopt;
+            } else if (expanded) {
+                stack.pop_back();
+                pending.erase(variable.key);
+                auto depth = 0;
+                for (auto const& operand : status.operands->variables.reads) {
+                    depth = std::max(depth, depths.at(operand.key) + 1);
+                }
+                depths.emplace(variable.key, depth);
+                graph.variables.push_back(variable);
+            } else {
+                stack.back().second = true;
+                pending.insert(variable.key);
+                for (auto const& operand : status.operands->variables.reads) {
+                    if (pending.count(operand.key) != 0) {
+                        return std::nullopt;
+                    }
+                    if (depths.count(operand.key) == 0) {
+                        stack.emplace_back(operand, false);
+                    }
+                }
+            }
+        }
+        return graph;
+    }
+
+    // Whether the graph has the structure recorded at the last compilation.
+    // The operands are compared if the hashes match, since a collision would
+    // keep a stale order of evaluation.
+    [[nodiscard]] auto unchanged() const -> bool
+    {
+        auto const same = [](Recorded const& variable) {
+            auto const& status = *variable.status;
+            if (status.structure != variable.structure) {
+                return false;
+            }
+            if (!status.operands) {
+                return variable.operands.empty();
+            }
+            auto const& reads = status.operands->variables.reads;
+            return std::equal(reads.begin(), reads.end(),
+                variable.operands.begin(), variable.operands.end(),
+                [](auto const& read, void const* key) {
+                    return read.key == key;
+                });
+        };
+        return mStructureKnown
+            && std::all_of(mStructure.begin(), mStructure.end(), same);
+    }
+
+    // Splits the graph into one function per variable with an expression,
+    // mapping the variables read by the expression to the variable.
+    // Level n holds the functions of the variables at depth n, which read
+    // only sources and variables of lower levels, so that the functions of
+    // a level can run in parallel, unless their expressions share operations
+    // (whose caches they would write at the same time).
+    // The functions are cached by variable and only compiled again if the
+    // variable reads other variables.
+    // Also records which gradients to sum when pulling gradients back (see
+    // pullLevels) and how to seed the leaves (see pushTangentAt).
+    auto schedule(Graph const& graph) -> Levels
+    {
+        auto const node = [](void const* key) {
+            return const_cast<internal::AbstractComputation*>(
+                static_cast<internal::AbstractComputation const*>(key));
+        };
+        // distinct variables read by an expression, with a slot of each
+        auto const operandsOf = [](detail::VariableStatus const& status) {
+            auto operands
+                = std::unordered_map<void const*, detail::GradientSlot*>{};
+            for (auto const& operand : status.operands->variables.reads) {
+                operands.emplace(operand.key, operand.slot);
+            }
+            return operands;
+        };
+        // number of functions reading each variable
+        auto readers = std::unordered_map<void const*, std::size_t>{};
+        auto slots   = std::unordered_map<void const*, detail::GradientSlot*>{};
+        for (auto const& variable : graph.variables) {
+            for (auto const& [key, slot] : operandsOf(*variable.status)) {
+                ++readers[key];
+                slots.emplace(key, slot);
+            }
+        }
+        auto const shared = [&](void const* key) {
+            auto const found = readers.find(key);
+            return found != readers.end() && found->second > 1;
+        };
+
+        auto steps      = std::unordered_map<void const*, Step>{};
+        auto levels     = Levels{};
+        auto operations = std::vector<std::unordered_set<void const*>>{};
+        auto read       = std::vector<std::unordered_set<void const*>>{};
+        for (auto const& variable : graph.variables) {
+            auto const& status = *variable.status;
+            auto step          = Step{};
+            auto cached        = mSteps.find(variable.key);
+            if (cached != mSteps.end()
+                && cached->second.structure == status.structure) {
+                step = std::move(cached->second);
+            } else {
+                auto sources = Sources{};
+                for (auto const& operand : status.operands->variables.reads) {
+                    sources.obj.insert(node(operand.key));
+                }
+                auto targets = Targets{};
+                targets.obj.insert(node(variable.key));
+                step.structure = status.structure;
+                step.function  = std::make_unique<AutoDiff::Function>(
+                    std::move(sources), std::move(targets));
+                step.function->compile();
+            }
+
+            auto const depth
+                = static_cast<std::size_t>(graph.depths.at(variable.key));
+            if (levels.size() <= depth) {
+                levels.resize(depth + 1);
+                operations.resize(depth + 1);
+                read.resize(depth + 1);
+            }
+            auto& level = levels[depth];
+            level.functions.push_back(step.function.get());
+            auto const& own = status.operands->operations;
+            for (auto const* operation :
+                std::unordered_set<void const*>(own.begin(), own.end())) {
+                if (!operations[depth].insert(operation).second) {
+                    level.parallel = false;
+                }
+            }
+            auto& kept = level.kept.emplace_back();
+            for (auto const& [key, slot] : operandsOf(status)) {
+                if (!read[depth].insert(key).second) {
+                    level.parallelGradient = false;
+                }
+                if (shared(key)) {
+                    kept.push_back(slots.at(key));
+                }
+            }
+            level.variables.push_back(variable);
+            auto& operands = level.operands.emplace_back();
+            for (auto const& operand : status.operands->variables.reads) {
+                operands.push_back(operand);
+            }
+            if (shared(variable.key)) {
+                level.sums.push_back(slots.at(variable.key));
+            }
+            steps.emplace(variable.key, std::move(step));
+        }
+        mSteps = std::move(steps); // without the variables no longer read
+
+        mLeafSums.clear();
+        mLeafSlots.clear();
+        auto seedable = true; // false if a leaf is not read (but a target)
+        for (auto const& leaf : graph.leaves) {
+            auto const found = slots.find(leaf.key);
+            if (found == slots.end()) {
+                seedable = false;
+                continue;
+            }
+            mLeafSlots.emplace(leaf.key, found->second);
+            if (shared(leaf.key)) {
+                mLeafSums.push_back(found->second);
+            }
+        }
+        if (!seedable) {
+            mLeafSlots.clear();
+        }
+        // the gradients of the targets are only read by their own levels
+        mSeparable = std::none_of(mTargetVariables.begin(),
+            mTargetVariables.end(), [&](AbstractVariable const* target) {
+                auto const key = static_cast<void const*>(target->_node());
+                return readers.count(key) != 0 || graph.depths.at(key) < 0;
+            });
+        return levels;
+    }
+
+    // Whether the values are still those of the last evaluation: the graph
+    // is unchanged and neither the variables read by it nor the targets were
+    // modified since. Variables without a status (not created from Python)
+    // might have been modified, so their reads force an evaluation.
+    [[nodiscard]] auto upToDate() const -> bool
+    {
+        auto const unmodified = [this](std::size_t modified) {
+            return modified <= mEvaluatedValueVersion;
+        };
+        return mEvaluated && mReads.complete && compiled()
+            && mEvaluatedGraphVersion == detail::state().graphVersion.load()
+            && std::all_of(mReads.reads.begin(), mReads.reads.end(),
+                [&](auto const& variable) {
+                    return unmodified(variable.status->modified);
+                })
+            && std::all_of(mTargetVariables.begin(), mTargetVariables.end(),
+                [&](AbstractVariable const* target) {
+                    return unmodified(target->_modified());
+                });
+    }
+
+    bool mRetainCache = false;
+    bool mReleaseGil  = false;
+
+    std::size_t mCompiledVersion = 0; // graph version at the last compilation
+
+    // variable of the graph at the last compilation, see unchanged
+    struct Recorded {
+        std::shared_ptr<detail::VariableStatus> status;
+        std::size_t structure;             // hash of the operands
+        std::vector<void const*> operands; // read by the expression
+    };
+
+    std::vector<Recorded> mStructure; // of the variables of the graph
+    bool mStructureKnown = false; // false if not all variables were recorded
+
+    std::unique_ptr<ThreadPool> mPool; // null for one thread
+    bool mScheduled = false; // whether mLevels is up to date, see splits
+    std::unordered_map<void const*, Step> mSteps; // by variable
+    Levels mLevels; // empty to run the whole program
+    // leaves read by several functions, see pullLevels
+    std::vector<detail::GradientSlot*> mLeafSums;
+    // by leaf, empty if not all leaves can be seeded (see pushTangentAt)
+    std::unordered_map<void const*, detail::GradientSlot*> mLeafSlots;
+    bool mSeparable = false; // whether the levels can pull gradients back
+
+    bool mIncremental                  = false;
+    bool mEvaluated                    = false;
+    std::size_t mEvaluatedGraphVersion = 0;
+    std::size_t mEvaluatedValueVersion = 0;
+    detail::Reads mReads; // by the last evaluation
+    bool mPushed                         = false; // see pushTangent
+    std::size_t mPushedGraphVersion      = 0;
+    std::size_t mPushedVersion           = 0; // value version after it
+    std::size_t mPushedDerivativeVersion = 0;
+    std::vector<AbstractVariable const*> mSourceVariables; // in mSources
+    std::unordered_set<void const*> mSourceKeys;           // their nodes
+    std::vector<AbstractVariable const*> mTargetVariables; // in mTargets
+
+    bool mProfiling = false;
+    std::unique_ptr<Profiler> mProfiler;
+
+    std::shared_future<void> mPending; // last asynchronous sweep
+
+    // null if not created from Python
+    pybind11::object mSources;
+    pybind11::object mTargets;
+};
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_FUNCTION_HPP
@@ -0,0 +1,87 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_FUNCTION_GROUP_HPP
+#define AUTODIFF_PYTHON_FUNCTION_GROUP_HPP
+
+#include "Function.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstddef>    // size_t
+#include <functional> // invoke
+#include <stdexcept>  // invalid_argument
+#include <unordered_set>
+#include <utility>    // move
+#include <vector>
+
+namespace AutoDiff::Python {
+
+// Independent functions (sharing no variables) that are evaluated and
+// differentiated in parallel on a thread pool.
+// The functions are not owned by the group.
+class FunctionGroup {
+public:
+    // throws if the graphs of the functions share variables
+    FunctionGroup(std::vector<Function*> functions, std::size_t threads)
+        : mFunctions{std::move(functions)}
+        , mPool{threads}
+    {
+        checkIndependent();
+    }
+
+    [[nodiscard]] auto threads() const -> std::size_t { return mPool.size(); }
+
+    void evaluate() { run(&Function::evaluate); }
+
+    void pushTangent() { run(&Function::pushTangent); }
+
+    void pullGradient() { run(&Function::pullGradient); }
+
+private:
+    // Waits for the asynchronous sweeps of the functions, which would run at
+    // the same time otherwise
+    template <typename Sweep>
+    void run(Sweep sweep)
+    {
+        for (auto const* function : mFunctions) {
+            function->wait();
+        }
+        checkIndependent();
+        mPool.parallelFor(mFunctions.size(),
+            [&](std::size_t i) { std::invoke(sweep, *mFunctions[i]); });
+    }
+
+    // Throws if the graphs of two functions share a variable, which both
+    // would write at the same time.
+    // Checked again only if a variable got a new expression since.
+    void checkIndependent()
+    {
+        auto const version = detail::state().graphVersion.load();
+        if (mChecked && version == mCheckedVersion) {
+            return;
+        }
+        mChecked = false;
+        auto seen = std::unordered_set<detail::VariableStatus const*>{};
+        for (auto const* function : mFunctions) {
+            for (auto const& status : function->variableStatuses()) {
+                if (!seen.insert(status.get()).second) {
+                    throw std::invalid_argument("The functions of a group "
+                                                "must not share variables.");
+                }
+            }
+        }
+        mChecked        = true;
+        mCheckedVersion = version;
+    }
+
+    std::vector<Function*> mFunctions;
+    ThreadPool mPool;
+    bool mChecked               = false; // see checkIndependent
+    std::size_t mCheckedVersion = 0;     // graph version of the last check
+};
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_FUNCTION_GROUP_HPP
@@ -0,0 +1,60 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_LANES_HPP
+#define AUTODIFF_PYTHON_LANES_HPP
+
+#include "Cwise.hpp"
+
+#include <Eigen/Core>
+
+namespace AutoDiff::Python {
+
+// Scalar programs evaluated at many points at once: each lane of an array
+// holds the scalar value (and derivative) at one point.
+// Both values and derivatives are 1D arrays of the same length, so every
+// operation is element-wise and a single sweep spreads the dispatch cost of
+// the graph over all lanes, leaving Eigen to vectorize the loops (SIMD).
+// Lane operations are CwiseOperations and CwiseBinaryOperations, which scale
+// lane derivatives element-wise.
+using Lanes = Eigen::Array<double, Eigen::Dynamic, 1>;
+
+} // namespace AutoDiff::Python
+
+// A @ B (lanes), A @ ScalarLiteral fused element-wise
+#define AUTODIFF_PYTHON_DEF_LANE_INFIX_OP(                                     \
+    binding, name, function, scalarFunction, description)                      \
+    {                                                                          \
+        using Binding = decltype(binding);                                     \
+        using Expr    = typename Binding::Expr;                                \
+        using Scalar  = typename Binding::Scalar;                              \
+                                                                               \
+        auto funcExpr = [](Expr const& x, Expr const& y) {                     \
+            return AutoDiff::Python::cwise(                                    \
+                x, y, AutoDiff::Python::CwiseBinaryFunction::function);        \
+        };                                                                     \
+        auto funcScalar = [](Expr const& x, Scalar y) {                        \
+            return AutoDiff::Python::cwise(                                    \
+                x, AutoDiff::Python::CwiseFunction::scalarFunction, y);        \
+        };                                                                     \
+        binding.defInfixOp(name, funcExpr, funcScalar, description);           \
+    }
+
+// ScalarLiteral @ A fused element-wise
+#define AUTODIFF_PYTHON_DEF_LANE_R_INFIX_OP(                                   \
+    binding, name, scalarFunction, description)                                \
+    {                                                                          \
+        using Binding = decltype(binding);                                     \
+        using Expr    = typename Binding::Expr;                                \
+        using Scalar  = typename Binding::Scalar;                              \
+                                                                               \
+        auto funcRScalar = [](Expr const& y, Scalar x) {                       \
+            return AutoDiff::Python::cwise(                                    \
+                y, AutoDiff::Python::CwiseFunction::scalarFunction, x);        \
+        };                                                                     \
+        binding.defRInfixOp(name, funcRScalar, description);                   \
+    }
+
+#endif // AUTODIFF_PYTHON_LANES_HPP
@@ -6,6 +6,7 @@
 #ifndef AUTODIFF_PYTHON_OPERATION_HPP
 #define AUTODIFF_PYTHON_OPERATION_HPP
 
+#include "Arena.hpp"
 #include "Evaluator.hpp"
 #include "Expression.hpp"
 
@@ -18,7 +19,7 @@ class Operation : public Expression<Value, Derivative> {
 public:
     template <typename Op>
     explicit Operation(Op operation)
-        : mEvaluator{std::make_shared<Evaluator<Op>>(std::move(operation))}
+        : mEvaluator{detail::makeShared<Evaluator<Op>>(std::move(operation))}
     {
     }
 
@@ -35,6 +36,17 @@ public:
         return ExpressionWrapper<Value, Derivative>(mEvaluator);
     }
 
+    [[nodiscard]] auto _key() const -> void const* override
+    {
+        return mEvaluator.get();
+    }
+
+    [[nodiscard]] auto evaluator() const
+        -> std::shared_ptr<AbstractEvaluator<Value, Derivative>> const&
+    {
+        return mEvaluator;
+    }
+
 private:
     std::shared_ptr<AbstractEvaluator<Value, Derivative>> mEvaluator;
 };
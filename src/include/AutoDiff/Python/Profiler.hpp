@@ -0,0 +1,322 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_PROFILER_HPP
+#define AUTODIFF_PYTHON_PROFILER_HPP
+
+#include "State.hpp"
+
+#include <algorithm> // max
+#include <array>
+#include <chrono>
+#include <cstddef> // ptrdiff_t, size_t
+#include <memory>  // free, unique_ptr
+#include <string>
+#include <type_traits> // is_arithmetic_v
+#include <typeinfo>
+#include <unordered_map>
+#include <utility> // exchange, move
+#include <vector>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+namespace AutoDiff::Python {
+
+enum class Sweep { Evaluate, PushTangent, PullGradient };
+
+// Records the time spent in the evaluators of operations during sweeps.
+// Times are self times, excluding the time spent in nested operations.
+// Also accounts for the memory held by the cache buffers of the evaluators
+// and the values and derivatives of the variables read by the operations.
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        std::size_t calls = 0;
+        double seconds    = 0; // self time
+        std::size_t bytes = 0; // written to value or derivative buffers
+    };
+
+    struct Node {
+        std::string operation;
+        std::vector<std::ptrdiff_t> shape; // of the value
+        std::array<Stats, 3> sweeps;       // indexed by Sweep
+        std::size_t valueBytes      = 0;   // held by the value cache
+        std::size_t derivativeBytes = 0;   // held by the derivative cache
+    };
+
+    // largest buffers of a variable seen during the sweeps
+    struct Variable {
+        std::size_t valueBytes      = 0;
+        std::size_t derivativeBytes = 0;
+    };
+
+    // complete event in the Chrome trace event format
+    struct Event {
+        std::size_t node; // index into nodes()
+        Sweep sweep;
+        double start;    // in microseconds since the profiler was created
+        double duration; // in microseconds, including nested operations
+    };
+
+    // nodes in order of their first call
+    [[nodiscard]] auto nodes() const -> std::vector<Node> const&
+    {
+        return mNodes;
+    }
+
+    [[nodiscard]] auto events() const -> std::vector<Event> const&
+    {
+        return mEvents;
+    }
+
+    // by the keys of their nodes (as of AbstractVariable::_node)
+    [[nodiscard]] auto variables() const
+        -> std::unordered_map<void const*, Variable> const&
+    {
+        return mVariables;
+    }
+
+    // bytes currently held by the cache buffers of the evaluators
+    [[nodiscard]] auto cacheBytes() const -> std::size_t { return mCacheBytes; }
+
+    // Peak of the bytes held by the cache buffers during a sweep, including
+    // the gradient being pulled back
+    [[nodiscard]] auto peakBytes(Sweep sweep) const -> std::size_t
+    {
+        return mPeakBytes[static_cast<std::size_t>(sweep)];
+    }
+
+    [[nodiscard]] auto start() -> Clock::time_point
+    {
+        mChildTimes.push_back(Clock::duration::zero());
+        return Clock::now();
+    }
+
+    void stop(void const* evaluator, std::string const& operation, Sweep sweep,
+        Clock::time_point start, std::vector<std::ptrdiff_t> shape,
+        std::size_t bytes)
+    {
+        auto const duration  = Clock::now() - start;
+        auto const childTime = mChildTimes.back();
+        cancel();
+        if (!mChildTimes.empty()) {
+            mChildTimes.back() += duration;
+        }
+
+        auto [it, inserted] = mIndices.try_emplace(evaluator, mNodes.size());
+        if (inserted) {
+            mNodes.push_back(Node{operation, {}, {}});
+        }
+        auto& node = mNodes[it->second];
+        if (sweep == Sweep::Evaluate) {
+            node.shape = std::move(shape);
+        }
+        auto& stats = node.sweeps[static_cast<std::size_t>(sweep)];
+        ++stats.calls;
+        stats.seconds += std::chrono::duration<double>(duration - childTime)
+                             .count();
+        stats.bytes += bytes;
+
+        // the output of the evaluation and forward sweeps is cached
+        auto transient = bytes;
+        if (sweep == Sweep::Evaluate) {
+            hold(node.valueBytes, bytes);
+            transient = 0;
+        } else if (sweep == Sweep::PushTangent) {
+            hold(node.derivativeBytes, bytes);
+            transient = 0;
+        }
+        auto& peak = mPeakBytes[static_cast<std::size_t>(sweep)];
+        peak       = std::max(peak, mCacheBytes + transient);
+
+        using Micros = std::chrono::duration<double, std::micro>;
+        mEvents.push_back(Event{it->second, sweep,
+            Micros(start - mCreated).count(), Micros(duration).count()});
+    }
+
+    // discard the running operation (e.g., if it threw an exception)
+    void cancel() { mChildTimes.pop_back(); }
+
+    // the cache buffers of the evaluator were released
+    void release(void const* evaluator)
+    {
+        if (auto it = mIndices.find(evaluator); it != mIndices.end()) {
+            auto& node = mNodes[it->second];
+            hold(node.valueBytes, 0);
+            hold(node.derivativeBytes, 0);
+        }
+    }
+
+    // the evaluator is destroyed; its statistics are kept
+    void forget(void const* evaluator)
+    {
+        release(evaluator);
+        mIndices.erase(evaluator); // the address might be reused
+    }
+
+    // a variable's value (evaluation) or derivative (otherwise) was read
+    void variable(void const* key, Sweep sweep, std::size_t bytes)
+    {
+        auto& variable = mVariables[key];
+        auto& held     = sweep == Sweep::Evaluate ? variable.valueBytes
+                                                  : variable.derivativeBytes;
+        held           = std::max(held, bytes);
+    }
+
+private:
+    // replaces the bytes held by a cache buffer
+    void hold(std::size_t& held, std::size_t bytes)
+    {
+        mCacheBytes = mCacheBytes - held + bytes;
+        held        = bytes;
+    }
+
+    Clock::time_point mCreated = Clock::now();
+    std::vector<Clock::duration> mChildTimes; // of the running operations
+    std::unordered_map<void const*, std::size_t> mIndices; // into mNodes
+    std::vector<Node> mNodes;
+    std::vector<Event> mEvents;
+    std::unordered_map<void const*, Variable> mVariables;
+    std::size_t mCacheBytes = 0;
+    std::array<std::size_t, 3> mPeakBytes{}; // indexed by Sweep
+};
+
+namespace detail {
+
+// readable name of an operation type, without namespaces and template
+// arguments, e.g. "CwiseOperation"
+template <typename Op>
+auto operationName() -> std::string const&
+{
+    static auto const name = [] {
+        auto name = std::string{typeid(Op).name()};
+#if defined(__GNUG__)
+        auto status = 0;
+        auto const demangled = std::unique_ptr<char, void (*)(void*)>{
+            abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status),
+            std::free};
+        if (status == 0) {
+            name = demangled.get();
+        }
+#endif
+        name = name.substr(0, name.find('<'));
+        auto const scope = name.rfind("::");
+        if (scope != std::string::npos) {
+            name = name.substr(scope + 2);
+        }
+        if (auto const space = name.rfind(' '); space != std::string::npos) {
+            name = name.substr(space + 1); // e.g. MSVC's "class "
+        }
+        return name;
+    }();
+    return name;
+}
+
+// NumPy shape of a value or derivative
+template <typename T>
+auto shapeOf(T const& array) -> std::vector<std::ptrdiff_t>
+{
+    if constexpr (std::is_arithmetic_v<T>) {
+        return {};
+    } else if constexpr (T::ColsAtCompileTime == 1) {
+        return {static_cast<std::ptrdiff_t>(array.rows())};
+    } else {
+        return {static_cast<std::ptrdiff_t>(array.rows()),
+            static_cast<std::ptrdiff_t>(array.cols())};
+    }
+}
+
+template <typename T>
+auto bytesOf(T const& array) -> std::size_t
+{
+    if constexpr (std::is_arithmetic_v<T>) {
+        return sizeof(T);
+    } else {
+        return static_cast<std::size_t>(array.size())
+            * sizeof(typename T::Scalar);
+    }
+}
+
+} // namespace detail
+
+// Profiles the given sweep of an evaluator while in scope, if profiling
+class Probe {
+public:
+    Probe(void const* evaluator, Sweep sweep)
+        : mProfiler{detail::threadState().profiler}
+        , mEvaluator{evaluator}
+        , mSweep{sweep}
+    {
+        if (mProfiler != nullptr) {
+            mStart = mProfiler->start();
+        }
+    }
+
+    // record the output of the sweep before leaving the scope
+    template <typename Op, typename Output>
+    void stop(Output const& output)
+    {
+        if (mProfiler == nullptr) {
+            return;
+        }
+        mProfiler->stop(mEvaluator, detail::operationName<Op>(), mSweep,
+            mStart, detail::shapeOf(output), detail::bytesOf(output));
+        mProfiler = nullptr;
+    }
+
+    ~Probe()
+    {
+        if (mProfiler != nullptr) { // exception thrown by the sweep
+            mProfiler->cancel();
+        }
+    }
+
+    Probe(Probe const&)                    = delete;
+    Probe(Probe&&)                         = delete;
+    auto operator=(Probe const&) -> Probe& = delete;
+    auto operator=(Probe&&) -> Probe&      = delete;
+
+private:
+    Profiler* mProfiler;
+    void const* mEvaluator;
+    Sweep mSweep;
+    Profiler::Clock::time_point mStart;
+};
+
+// Records a variable's value or derivative read during a sweep, if profiling
+template <typename Buffer>
+void probeVariable(void const* key, Sweep sweep, Buffer const& buffer)
+{
+    if (auto* profiler = detail::threadState().profiler) {
+        profiler->variable(key, sweep, detail::bytesOf(buffer));
+    }
+}
+
+// Profiles all sweeps on this thread while in scope, if not null
+class ProfileScope {
+public:
+    explicit ProfileScope(Profiler* profiler)
+        : mPrevious{std::exchange(detail::threadState().profiler, profiler)}
+    {
+    }
+
+    ~ProfileScope() { detail::threadState().profiler = mPrevious; }
+
+    ProfileScope(ProfileScope const&)                    = delete;
+    ProfileScope(ProfileScope&&)                         = delete;
+    auto operator=(ProfileScope const&) -> ProfileScope& = delete;
+    auto operator=(ProfileScope&&) -> ProfileScope&      = delete;
+
+private:
+    Profiler* mPrevious;
+};
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_PROFILER_HPP
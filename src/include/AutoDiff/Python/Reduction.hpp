@@ -0,0 +1,291 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_REDUCTION_HPP
+#define AUTODIFF_PYTHON_REDUCTION_HPP
+
+#include "BufferPool.hpp"
+#include "Evaluator.hpp" // detail::threadState
+#include "Expression.hpp"
+#include "ExpressionBinding.hpp"
+#include "Operation.hpp"
+
+#include <AutoDiff/src/Core/Expression.hpp>
+#include <Eigen/Core>
+
+#include <stdexcept> // invalid_argument
+#include <utility>   // move
+
+namespace AutoDiff::Python {
+
+enum class Reduction {
+    Max,  // first maximum
+    Mean, //
+    Norm, // L²-norm
+    Sum   //
+};
+
+// Reduction of the columns (axis 0) or rows (axis 1) of a matrix expression
+// to a vector, in a single node.
+// Each element of the matrix contributes to one element of the vector, so
+// the Jacobian has one non-zero per column, the partial derivative of that
+// element. Only these partials are stored (as a matrix of the operand's
+// shape), and tangents and gradients are scaled and summed element-wise
+// instead of being multiplied with a dense Jacobian matrix.
+template <typename Matrix, typename Vector, typename Derivative_>
+class AxisReduction
+    : public AutoDiff::Expression<AxisReduction<Matrix, Vector, Derivative_>> {
+public:
+    using Derivative = Derivative_;
+    using Operand    = ExpressionWrapper<Matrix, Derivative>;
+    using Scalar     = typename Matrix::Scalar;
+    using Partials   = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+
+    AxisReduction(Reduction reduction, int axis, Operand operand)
+        : mReduction{reduction}
+        , mAxis{axis}
+        , mOperand{std::move(operand)}
+    {
+        if (axis != 0 && axis != 1) {
+            throw std::invalid_argument("The axis must be 0 or 1.");
+        }
+    }
+
+    [[nodiscard]] auto _valueImpl() -> Vector const&
+    {
+        auto const& x = mOperand._value();
+        mOperandValue = &x;
+        reduce(x);
+        mHasPartials = false; // operand might have changed
+        return mValue;
+    }
+
+    [[nodiscard]] auto _pushForwardImpl() -> Derivative const&
+    {
+        auto const& partials = this->partials();
+        auto const& tangent  = mOperand._pushForward();
+        auto const rows      = partials.rows();
+        auto const cols      = partials.cols();
+        auto const size      = mAxis == 0 ? cols : rows;
+        detail::reuse(mDerivative, size * tangent.cols());
+        mDerivative.resize(size, tangent.cols());
+        // each tangent direction is a flattened matrix of the operand's shape
+        for (Eigen::Index q = 0; q < tangent.cols(); ++q) {
+            auto const dx = Eigen::Map<Partials const>(
+                tangent.data() + q * tangent.rows(), rows, cols);
+            if (mAxis == 0) {
+                mDerivative.col(q)
+                    = partials.cwiseProduct(dx).colwise().sum().transpose();
+            } else {
+                mDerivative.col(q) = partials.cwiseProduct(dx).rowwise().sum();
+            }
+        }
+        return mDerivative;
+    }
+
+    void _pullBackImpl(Derivative const& gradient)
+    {
+        auto const& partials = this->partials();
+        auto const rows      = partials.rows();
+        auto const cols      = partials.cols();
+        detail::reuse(mGradient, gradient.rows() * partials.size());
+        mGradient.resize(gradient.rows(), partials.size());
+        for (Eigen::Index j = 0; j < cols; ++j) {
+            for (Eigen::Index i = 0; i < rows; ++i) {
+                mGradient.col(j * rows + i)
+                    = partials(i, j) * gradient.col(mAxis == 0 ? j : i);
+            }
+        }
+        mOperand._pullBack(mGradient);
+    }
+
+    // Second-order sweep (see AbstractEvaluator::valueTangent). The partials
+    // are constant except for the norm, whose partials x/z have the tangents
+    // (ẋ - ż x/z)/z.
+    [[nodiscard]] auto _valueTangent() -> Vector const&
+    {
+        auto const& partials = this->partials();
+        auto const& dx       = mOperand._valueTangent();
+        detail::reuse(mTangent, mAxis == 0 ? partials.cols() : partials.rows());
+        if (mAxis == 0) {
+            mTangent = partials.cwiseProduct(dx).colwise().sum().transpose();
+        } else {
+            mTangent = partials.cwiseProduct(dx).rowwise().sum();
+        }
+        return mTangent;
+    }
+
+    void _pullBackSecond(Vector const& gradient, Vector const& product)
+    {
+        auto const& partials = this->partials();
+        auto const& dx       = mOperand._valueTangent();
+        auto const rows      = partials.rows();
+        auto const cols      = partials.cols();
+        detail::reuse(mGradientValue, partials.size());
+        detail::reuse(mProduct, partials.size());
+        mGradientValue.resize(rows, cols);
+        mProduct.resize(rows, cols);
+        for (Eigen::Index j = 0; j < cols; ++j) {
+            for (Eigen::Index i = 0; i < rows; ++i) {
+                auto const k         = mAxis == 0 ? j : i;
+                mGradientValue(i, j) = partials(i, j) * gradient(k);
+                mProduct(i, j)       = partials(i, j) * product(k);
+            }
+        }
+        if (mReduction == Reduction::Norm) {
+            auto const& dz = _valueTangent();
+            for (Eigen::Index j = 0; j < cols; ++j) {
+                for (Eigen::Index i = 0; i < rows; ++i) {
+                    auto const k    = mAxis == 0 ? j : i;
+                    auto const norm = mValue(k);
+                    if (norm != 0) {
+                        mProduct(i, j) += gradient(k)
+                            * (dx(i, j) - partials(i, j) * dz(k)) / norm;
+                    }
+                }
+            }
+        }
+        mOperand._pullBackSecond(mGradientValue, mProduct);
+    }
+
+    void _transferChildrenToImpl(internal::Node& node) const
+    {
+        mOperand._transferChildrenTo(node);
+    }
+
+    void _releaseCacheImpl() const
+    {
+        mHasPartials = false;
+        if (!detail::threadState().retainCache) {
+            mOperandValue = nullptr; // recycled by the operand
+            detail::recycle(mValue);
+            detail::recycle(mPartials);
+            detail::recycle(mDerivative);
+            detail::recycle(mGradient);
+            detail::recycle(mTangent);
+            detail::recycle(mGradientValue);
+            detail::recycle(mProduct);
+        }
+        mOperand._releaseCache();
+    }
+
+private:
+    // reduces the operand's value into the value buffer
+    void reduce(Matrix const& x)
+    {
+        if (mReduction == Reduction::Max && x.size() == 0) {
+            throw std::invalid_argument(
+                "Cannot take the maximum of an empty matrix.");
+        }
+        detail::reuse(mValue, mAxis == 0 ? x.cols() : x.rows());
+        if (mAxis == 0) {
+            reduce(x.colwise());
+        } else {
+            reduce(x.rowwise());
+        }
+    }
+
+    template <typename Vectorwise>
+    void reduce(Vectorwise const& x)
+    {
+        switch (mReduction) {
+        case Reduction::Max: mValue = x.maxCoeff(); break;
+        case Reduction::Mean: mValue = x.mean(); break;
+        case Reduction::Norm: mValue = x.norm(); break;
+        case Reduction::Sum: mValue = x.sum(); break;
+        }
+    }
+
+    // partial derivatives of the reduced elements with respect to the
+    // operand's elements, evaluated at its value
+    auto partials() -> Partials const&
+    {
+        if (mHasPartials) {
+            return mPartials;
+        }
+        // evaluating the operand again would re-evaluate its whole subtree
+        auto const& x
+            = mOperandValue != nullptr ? *mOperandValue : mOperand._value();
+        detail::reuse(mPartials, x.size());
+        mPartials.resize(x.rows(), x.cols());
+        auto const count = mAxis == 0 ? x.rows() : x.cols();
+        switch (mReduction) {
+        case Reduction::Max:
+            reduce(x); // the value buffer might have been released
+            mPartials.setZero();
+            for (Eigen::Index k = 0; k < mValue.size(); ++k) {
+                auto index = Eigen::Index{0};
+                if (mAxis == 0) {
+                    x.col(k).maxCoeff(&index);
+                    mPartials(index, k) = 1;
+                } else {
+                    x.row(k).maxCoeff(&index);
+                    mPartials(k, index) = 1;
+                }
+            }
+            break;
+        case Reduction::Mean:
+            mPartials.setConstant(Scalar{1} / static_cast<Scalar>(count));
+            break;
+        case Reduction::Norm:
+            reduce(x);
+            for (Eigen::Index j = 0; j < x.cols(); ++j) {
+                for (Eigen::Index i = 0; i < x.rows(); ++i) {
+                    auto const norm = mValue(mAxis == 0 ? j : i);
+                    // subgradient zero at the origin
+                    mPartials(i, j) = norm == 0 ? 0 : x(i, j) / norm;
+                }
+            }
+            break;
+        case Reduction::Sum: mPartials.setOnes(); break;
+        }
+        mHasPartials = true;
+        return mPartials;
+    }
+
+    Reduction mReduction;
+    int mAxis;
+    Operand mOperand;
+
+    // cache
+    mutable Matrix const* mOperandValue = nullptr; // of the last evaluation
+    mutable Vector mValue;
+    mutable Partials mPartials;
+    mutable bool mHasPartials = false;
+    mutable Derivative mDerivative;
+    mutable Derivative mGradient; // passed on to the operand
+
+    // cache of the second-order sweep
+    mutable Vector mTangent;
+    mutable Matrix mGradientValue; // passed on to the operand
+    mutable Matrix mProduct;
+};
+
+// Reduces the columns (axis 0) or rows (axis 1) of a matrix expression
+template <typename Vector, typename Matrix, typename Derivative>
+auto reduce(Expression<Matrix, Derivative> const& operand, int axis,
+    Reduction reduction) -> Operation<Vector, Derivative>
+{
+    return Operation<Vector, Derivative>{AxisReduction<Matrix, Vector,
+        Derivative>{reduction, axis, operand.wrapper()}};
+}
+
+} // namespace AutoDiff::Python
+
+#define AUTODIFF_PYTHON_DEF_AXIS_REDUCTION(                                    \
+    BindingX, Binding, module, name, reduction, description)                   \
+    {                                                                          \
+        using ExprX = typename BindingX::Expr;                                 \
+        using Value = typename Binding::Value;                                 \
+        auto func   = [](ExprX const& x, int axis) {                           \
+            return AutoDiff::Python::reduce<Value>(                            \
+                x, axis, AutoDiff::Python::Reduction::reduction);              \
+        };                                                                     \
+        module.def(name,                                                       \
+            AutoDiff::Python::detail::recorded(name, false, +func),            \
+            pybind11::arg("operand"), pybind11::arg("axis"), description);     \
+    }
+
+#endif // AUTODIFF_PYTHON_REDUCTION_HPP
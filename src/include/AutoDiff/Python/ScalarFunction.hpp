@@ -0,0 +1,156 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_SCALAR_FUNCTION_HPP
+#define AUTODIFF_PYTHON_SCALAR_FUNCTION_HPP
+
+#include "BufferPool.hpp"
+#include "Evaluator.hpp" // detail::threadState
+#include "Expression.hpp"
+
+#include <AutoDiff/src/Core/Expression.hpp>
+
+#include <cmath>    // exp, log1p
+#include <optional>
+#include <utility>  // move
+
+namespace AutoDiff::Python {
+
+// Scalar functions that are not part of the AutoDiff library
+enum class ScalarFunction {
+    Log1p,  // log(1 + x), accurate for small x
+    Sigmoid // 1 / (1 + exp(-x))
+};
+
+// Numerically stable scalar function in a single node, with its derivative
+// in closed form (for array expressions, see CwiseFunction)
+template <typename Value, typename Derivative_>
+class ScalarFunctionOperation
+    : public AutoDiff::Expression<ScalarFunctionOperation<Value, Derivative_>> {
+public:
+    using Derivative = Derivative_;
+    using Operand    = ExpressionWrapper<Value, Derivative>;
+
+    ScalarFunctionOperation(ScalarFunction function, Operand operand)
+        : mFunction{function}
+        , mOperand{std::move(operand)}
+    {
+    }
+
+    [[nodiscard]] auto _valueImpl() -> Value const&
+    {
+        auto const x  = mOperand._value();
+        mOperandValue = x;
+        switch (mFunction) {
+        case ScalarFunction::Log1p: mValue = std::log1p(x); break;
+        case ScalarFunction::Sigmoid: mValue = sigmoid(x); break;
+        }
+        return mValue;
+    }
+
+    [[nodiscard]] auto _pushForwardImpl() -> Derivative const&
+    {
+        auto const& tangent = mOperand._pushForward();
+        mDerivative         = partial() * tangent;
+        return mDerivative;
+    }
+
+    void _pullBackImpl(Derivative const& gradient)
+    {
+        mGradient = gradient * partial();
+        mOperand._pullBack(mGradient);
+    }
+
+    // second-order sweep (see AbstractEvaluator::valueTangent)
+    [[nodiscard]] auto _valueTangent() -> Value const&
+    {
+        mTangent = partial() * mOperand._valueTangent();
+        return mTangent;
+    }
+
+    void _pullBackSecond(Value const& gradient, Value const& product)
+    {
+        mOperand._pullBackSecond(gradient * partial(),
+            product * partial()
+                + gradient * secondPartial() * mOperand._valueTangent());
+    }
+
+    void _transferChildrenToImpl(internal::Node& node) const
+    {
+        mOperand._transferChildrenTo(node);
+    }
+
+    void _releaseCacheImpl() const
+    {
+        if (!detail::threadState().retainCache) {
+            mOperandValue.reset();
+            detail::recycle(mDerivative);
+            detail::recycle(mGradient);
+        }
+        mOperand._releaseCache();
+    }
+
+private:
+    // without overflow of exp for large |x|
+    static auto sigmoid(Value x) -> Value
+    {
+        if (x >= 0) {
+            return Value{1} / (Value{1} + std::exp(-x));
+        }
+        auto const e = std::exp(x);
+        return e / (Value{1} + e);
+    }
+
+    // derivative at the operand's value (of the last evaluation; evaluating
+    // the operand again would re-evaluate its whole subtree)
+    [[nodiscard]] auto partial() -> Value
+    {
+        auto const x = mOperandValue ? *mOperandValue : mOperand._value();
+        switch (mFunction) {
+        case ScalarFunction::Log1p: return Value{1} / (Value{1} + x);
+        case ScalarFunction::Sigmoid: return sigmoid(x) * sigmoid(-x);
+        }
+        return Value{0};
+    }
+
+    [[nodiscard]] auto secondPartial() -> Value
+    {
+        auto const x = mOperandValue ? *mOperandValue : mOperand._value();
+        switch (mFunction) {
+        case ScalarFunction::Log1p: return -partial() * partial();
+        case ScalarFunction::Sigmoid:
+            return partial() * (Value{1} - Value{2} * sigmoid(x));
+        }
+        return Value{0};
+    }
+
+    ScalarFunction mFunction;
+    Operand mOperand;
+
+    // cache
+    mutable Value mValue{};
+    mutable std::optional<Value> mOperandValue; // of the last evaluation
+    mutable Derivative mDerivative;
+    mutable Derivative mGradient; // passed on to the operand
+    mutable Value mTangent{};     // of the second-order sweep
+};
+
+template <typename Value, typename Derivative>
+auto log1p(ExpressionWrapper<Value, Derivative> operand)
+    -> ScalarFunctionOperation<Value, Derivative>
+{
+    return {ScalarFunction::Log1p, std::move(operand)};
+}
+
+template <typename Value, typename Derivative>
+auto sigmoid(ExpressionWrapper<Value, Derivative> operand)
+    -> ScalarFunctionOperation<Value, Derivative>
+{
+    return {ScalarFunction::Sigmoid, std::move(operand)};
+}
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_SCALAR_FUNCTION_HPP
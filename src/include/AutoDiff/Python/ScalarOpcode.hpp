@@ -0,0 +1,179 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_SCALAR_OPCODE_HPP
+#define AUTODIFF_PYTHON_SCALAR_OPCODE_HPP
+
+#include <cmath>
+#include <cstdint> // uint8_t
+#include <string>
+#include <unordered_map>
+
+namespace AutoDiff::Python::detail {
+
+// Scalar operations z = f(x, y) (or f(x) if unary) with known first and
+// second derivatives, shared by TapeFunction and the second-order rules of
+// the evaluators (see Function::hvp).
+enum class ScalarOpcode : std::uint8_t {
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Pow,
+    Neg,
+    Cos,
+    Exp,
+    Log,
+    Log1p,
+    Max,
+    Min,
+    Sigmoid,
+    Sin,
+    Sqrt,
+    Square
+};
+
+[[nodiscard]] inline auto isUnary(ScalarOpcode opcode) -> bool
+{
+    return opcode >= ScalarOpcode::Neg;
+}
+
+// Opcode of the Python name of an operation, e.g. "__radd__" (swapped) or
+// "sigmoid". Returns false if the operation is not a scalar opcode.
+inline auto parseScalarOpcode(
+    std::string const& name, ScalarOpcode& opcode, bool& swapped) -> bool
+{
+    using Op = ScalarOpcode;
+    static auto const opcodes = std::unordered_map<std::string, Op>{
+        {"add", Op::Add}, {"sub", Op::Sub}, {"mul", Op::Mul},
+        {"truediv", Op::Div}, {"pow", Op::Pow}, {"neg", Op::Neg},
+        {"cos", Op::Cos}, {"exp", Op::Exp}, {"log", Op::Log},
+        {"log1p", Op::Log1p}, {"maximum", Op::Max}, {"minimum", Op::Min},
+        {"sigmoid", Op::Sigmoid}, {"sin", Op::Sin}, {"sqrt", Op::Sqrt},
+        {"square", Op::Square}};
+    auto base = name;
+    swapped   = false;
+    if (base.size() > 4 && base.compare(0, 2, "__") == 0
+        && base.compare(base.size() - 2, 2, "__") == 0) {
+        base = base.substr(2, base.size() - 4); // method, e.g. __add__
+        if (base.size() > 1 && base[0] == 'r'
+            && opcodes.count(base.substr(1)) != 0) {
+            base    = base.substr(1);
+            swapped = true;
+        }
+    }
+    auto const it = opcodes.find(base);
+    if (it == opcodes.end()) {
+        return false;
+    }
+    opcode = it->second;
+    return true;
+}
+
+// Tangent dz of z = f(x, y), given the tangents dx and dy (y = x if unary).
+template <typename Scalar>
+[[nodiscard]] inline auto scalarTangent(ScalarOpcode opcode, Scalar x,
+    Scalar y, Scalar z, Scalar dx, Scalar dy) -> Scalar
+{
+    using Op = ScalarOpcode;
+    switch (opcode) {
+    case Op::Add: return dx + dy;
+    case Op::Sub: return dx - dy;
+    case Op::Mul: return dx * y + x * dy;
+    case Op::Div: return (dx - z * dy) / y;
+    case Op::Pow:
+        return dx * y * std::pow(x, y - 1)
+            + (dy != 0 ? dy * z * std::log(x) : Scalar(0));
+    case Op::Neg: return -dx;
+    case Op::Cos: return -dx * std::sin(x);
+    case Op::Exp: return dx * z;
+    case Op::Log: return dx / x;
+    case Op::Log1p: return dx / (1 + x);
+    case Op::Max: return x > 0 ? dx : Scalar(0);
+    case Op::Min: return x < 0 ? dx : Scalar(0);
+    case Op::Sigmoid: return dx * z * (1 - z);
+    case Op::Sin: return dx * std::cos(x);
+    case Op::Sqrt: return dx / (2 * z);
+    case Op::Square: return 2 * x * dx;
+    }
+    return Scalar(0);
+}
+
+// Partials px and py of z = f(x, y) and their tangents dpx and dpy, given the
+// tangents dx, dy, and dz of the forward sweep (zero for y if unary).
+template <typename Scalar>
+struct ScalarPartials {
+    Scalar px  = 0;
+    Scalar py  = 0;
+    Scalar dpx = 0;
+    Scalar dpy = 0;
+};
+
+template <typename Scalar>
+[[nodiscard]] inline auto scalarPartials(ScalarOpcode opcode, Scalar x,
+    Scalar y, Scalar z, Scalar dx, Scalar dy, Scalar dz)
+    -> ScalarPartials<Scalar>
+{
+    using Op = ScalarOpcode;
+    auto p   = ScalarPartials<Scalar>{};
+    switch (opcode) {
+    case Op::Add: p.px = 1; p.py = 1; break;
+    case Op::Sub: p.px = 1; p.py = -1; break;
+    case Op::Mul:
+        p.px  = y;
+        p.py  = x;
+        p.dpx = dy;
+        p.dpy = dx;
+        break;
+    case Op::Div:
+        p.px  = 1 / y;
+        p.py  = -z / y;
+        p.dpx = -dy / (y * y);
+        p.dpy = (z * dy / y - dz) / y;
+        break;
+    case Op::Pow: {
+        auto const power = std::pow(x, y - 1);
+        auto const logX  = std::log(x);
+        p.px  = y * power;
+        p.py  = z * logX;
+        p.dpx = dy * power
+            + (y != 1 ? y * (y - 1) * std::pow(x, y - 2) * dx : Scalar(0))
+            + (dy != 0 ? y * dy * power * logX : Scalar(0));
+        p.dpy = dz * logX + z * dx / x;
+        break;
+    }
+    case Op::Neg: p.px = -1; break;
+    case Op::Cos:
+        p.px  = -std::sin(x);
+        p.dpx = -std::cos(x) * dx;
+        break;
+    case Op::Exp: p.px = z; p.dpx = dz; break;
+    case Op::Log: p.px = 1 / x; p.dpx = -dx / (x * x); break;
+    case Op::Log1p:
+        p.px  = 1 / (1 + x);
+        p.dpx = -dx * p.px * p.px;
+        break;
+    case Op::Max: p.px = x > 0 ? 1 : 0; break;
+    case Op::Min: p.px = x < 0 ? 1 : 0; break;
+    case Op::Sigmoid:
+        p.px  = z * (1 - z);
+        p.dpx = dz * (1 - 2 * z);
+        break;
+    case Op::Sin:
+        p.px  = std::cos(x);
+        p.dpx = -std::sin(x) * dx;
+        break;
+    case Op::Sqrt:
+        p.px  = 1 / (2 * z);
+        p.dpx = -dz / (2 * z * z);
+        break;
+    case Op::Square: p.px = 2 * x; p.dpx = 2 * dx; break;
+    }
+    return p;
+}
+
+} // namespace AutoDiff::Python::detail
+
+#endif // AUTODIFF_PYTHON_SCALAR_OPCODE_HPP
@@ -0,0 +1,456 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_SECOND_ORDER_HPP
+#define AUTODIFF_PYTHON_SECOND_ORDER_HPP
+
+#include "Evaluator.hpp"
+#include "Expression.hpp"
+#include "ScalarOpcode.hpp"
+
+#include <Eigen/Core>
+
+#include <memory>      // make_shared, shared_ptr
+#include <string>
+#include <type_traits> // decay_t, is_arithmetic_v, is_base_of_v, is_same_v
+#include <unordered_map>
+#include <utility>     // declval, move
+
+namespace AutoDiff::Python::detail {
+
+// Second-order rules of the operations of the core library (see
+// AbstractEvaluator::valueTangent), whose expressions are opaque to the
+// bindings. The rule of an operation is chosen by the name of its binding
+// and the types of its arguments when it is created (see recorded); other
+// operations of the core library do not support Function.hvp.
+
+enum class FullReduction {
+    Mean,
+    Norm,
+    SquaredNorm,
+    Sum
+};
+
+// parsed once per binding
+struct RuleKind {
+    enum class Type {
+        None,
+        Scalar,    // see ScalarOpcode
+        Reduction, // of all elements to a scalar
+        Product    // dot, outer, and matrix products
+    };
+
+    Type type            = Type::None;
+    ScalarOpcode opcode  = ScalarOpcode::Add;
+    FullReduction reduce = FullReduction::Sum;
+    bool swapped         = false; // reflected method, e.g. __radd__
+};
+
+inline auto ruleKind(std::string const& name) -> RuleKind
+{
+    static auto const reductions
+        = std::unordered_map<std::string, FullReduction>{
+            {"mean", FullReduction::Mean}, {"norm", FullReduction::Norm},
+            {"squared_norm", FullReduction::SquaredNorm},
+            {"sum", FullReduction::Sum}};
+    auto kind = RuleKind{};
+    if (parseScalarOpcode(name, kind.opcode, kind.swapped)) {
+        kind.type = RuleKind::Type::Scalar;
+    } else if (auto const it = reductions.find(name); it != reductions.end()) {
+        kind.type   = RuleKind::Type::Reduction;
+        kind.reduce = it->second;
+    } else if (name == "dot" || name == "outer" || name == "matmul"
+        || name == "__matmul__" || name == "__rmatmul__") {
+        kind.type    = RuleKind::Type::Product;
+        kind.swapped = name == "__rmatmul__";
+    }
+    return kind;
+}
+
+// Argument of a binding function, an expression or a literal
+template <typename Arg>
+struct RuleArgument {
+    static constexpr bool isExpression = false;
+    using Value                        = Arg;
+};
+
+template <typename Value_, typename Derivative_>
+struct RuleArgument<Expression<Value_, Derivative_>> {
+    static constexpr bool isExpression = true;
+    using Value                        = Value_;
+    using Derivative                   = Derivative_;
+};
+
+// Operand of a rule: the evaluator of an expression, or a copy of a literal
+// (the arguments are moved into the operation)
+template <typename Value, typename Derivative>
+struct RuleOperand {
+    std::shared_ptr<AbstractEvaluator<Value, Derivative>> evaluator;
+    Value literal{};
+
+    [[nodiscard]] auto value() const -> Value const&
+    {
+        return evaluator ? evaluator->cachedValue() : literal;
+    }
+
+    // null for literals, whose tangents are zero
+    [[nodiscard]] auto tangent() const -> Value const*
+    {
+        return evaluator ? &evaluator->valueTangent() : nullptr;
+    }
+
+    void pullBack(Value const& gradient, Value const& product) const
+    {
+        if (evaluator) {
+            evaluator->pullBackSecond(gradient, product);
+        }
+    }
+};
+
+template <typename Value, typename Derivative, typename Arg>
+auto ruleOperand(Arg const& arg) -> RuleOperand<Value, Derivative>
+{
+    if constexpr (RuleArgument<Arg>::isExpression) {
+        return {arg.wrapper().evaluator(), {}};
+    } else {
+        return {nullptr, static_cast<Value>(arg)};
+    }
+}
+
+// Scalar operation with the partials of ScalarOpcode (as TapeFunction)
+template <typename Scalar, typename Derivative>
+class ScalarRule final : public SecondOrderRule<Scalar> {
+public:
+    using Operand = RuleOperand<Scalar, Derivative>;
+
+    // y is ignored if unary
+    ScalarRule(ScalarOpcode opcode, Operand x, Operand y)
+        : mOpcode{opcode}
+        , mX{std::move(x)}
+        , mY{std::move(y)}
+    {
+    }
+
+    auto tangent(Scalar const& value) -> Scalar const& final
+    {
+        auto const o = operands();
+        mTangent     = scalarTangent(mOpcode, o.x, o.y, value, o.dx, o.dy);
+        return mTangent;
+    }
+
+    void pullBack(Scalar const& value, Scalar const& gradient,
+        Scalar const& product) final
+    {
+        auto const o  = operands();
+        auto const dz = scalarTangent(mOpcode, o.x, o.y, value, o.dx, o.dy);
+        auto const [px, py, dpx, dpy]
+            = scalarPartials(mOpcode, o.x, o.y, value, o.dx, o.dy, dz);
+        mX.pullBack(gradient * px, product * px + gradient * dpx);
+        if (!isUnary(mOpcode)) {
+            mY.pullBack(gradient * py, product * py + gradient * dpy);
+        }
+    }
+
+private:
+    struct Values {
+        Scalar x, y, dx, dy;
+    };
+
+    // the same for x and y if unary
+    [[nodiscard]] auto operands() const -> Values
+    {
+        auto const* dx = mX.tangent();
+        auto o         = Values{mX.value(), 0, dx ? *dx : Scalar(0), 0};
+        if (isUnary(mOpcode)) {
+            o.y  = o.x;
+            o.dy = o.dx;
+        } else {
+            auto const* dy = mY.tangent();
+            o.y            = mY.value();
+            o.dy           = dy ? *dy : Scalar(0);
+        }
+        return o;
+    }
+
+    ScalarOpcode mOpcode;
+    Operand mX;
+    Operand mY;
+    Scalar mTangent{};
+};
+
+// Reduction of all elements of an array expression to a scalar
+template <typename ValueX, typename Derivative>
+class ReductionRule final
+    : public SecondOrderRule<typename ValueX::Scalar> {
+public:
+    using Scalar  = typename ValueX::Scalar;
+    using Operand = AbstractEvaluator<ValueX, Derivative>;
+
+    ReductionRule(FullReduction reduction, std::shared_ptr<Operand> operand)
+        : mReduction{reduction}
+        , mOperand{std::move(operand)}
+    {
+    }
+
+    auto tangent(Scalar const& value) -> Scalar const& final
+    {
+        auto const x  = mOperand->cachedValue().array();
+        auto const dx = mOperand->valueTangent().array();
+        switch (mReduction) {
+        case FullReduction::Mean: mTangent = dx.mean(); break;
+        case FullReduction::Norm:
+            mTangent = value == 0 ? Scalar(0) : (x * dx).sum() / value;
+            break;
+        case FullReduction::SquaredNorm:
+            mTangent = Scalar(2) * (x * dx).sum();
+            break;
+        case FullReduction::Sum: mTangent = dx.sum(); break;
+        }
+        return mTangent;
+    }
+
+    void pullBack(Scalar const& value, Scalar const& gradient,
+        Scalar const& product) final
+    {
+        auto const dz   = tangent(value);
+        auto const& x   = mOperand->cachedValue();
+        auto const& dx  = mOperand->valueTangent();
+        auto const size = static_cast<Scalar>(x.size());
+        switch (mReduction) {
+        case FullReduction::Mean:
+            mGradient = ValueX::Constant(x.rows(), x.cols(), gradient / size);
+            mProduct  = ValueX::Constant(x.rows(), x.cols(), product / size);
+            break;
+        case FullReduction::Norm:
+            if (value == 0) { // subgradient zero at the origin
+                mGradient = ValueX::Zero(x.rows(), x.cols());
+                mProduct  = mGradient;
+            } else {
+                mGradient = (gradient / value) * x;
+                mProduct  = (product / value) * x
+                    + (gradient / value) * (dx - (dz / value) * x);
+            }
+            break;
+        case FullReduction::SquaredNorm:
+            mGradient = (Scalar(2) * gradient) * x;
+            mProduct  = (Scalar(2) * product) * x
+                + (Scalar(2) * gradient) * dx;
+            break;
+        case FullReduction::Sum:
+            mGradient = ValueX::Constant(x.rows(), x.cols(), gradient);
+            mProduct  = ValueX::Constant(x.rows(), x.cols(), product);
+            break;
+        }
+        mOperand->pullBackSecond(mGradient, mProduct);
+    }
+
+private:
+    FullReduction mReduction;
+    std::shared_ptr<Operand> mOperand;
+    Scalar mTangent{};
+    ValueX mGradient; // passed on to the operand
+    ValueX mProduct;
+};
+
+// Bilinear product z = x · y (dot), x yᵀ (outer), or X Y (matrix product)
+// of two array expressions, one of which can be a literal. Each operand gets
+// the gradient G times the other operand, and the product additionally G
+// times the tangent of the other operand.
+template <typename ValueX, typename ValueY, typename Value,
+    typename Derivative>
+class ProductRule final : public SecondOrderRule<Value> {
+public:
+    using OperandX = RuleOperand<ValueX, Derivative>;
+    using OperandY = RuleOperand<ValueY, Derivative>;
+
+    ProductRule(OperandX x, OperandY y)
+        : mX{std::move(x)}
+        , mY{std::move(y)}
+    {
+    }
+
+    auto tangent(Value const& value) -> Value const& final
+    {
+        auto const& x  = mX.value();
+        auto const& y  = mY.value();
+        auto const* dx = mX.tangent();
+        auto const* dy = mY.tangent();
+        if constexpr (isDot) {
+            mTangent = (dx != nullptr ? dx->dot(y) : Value(0))
+                + (dy != nullptr ? x.dot(*dy) : Value(0));
+        } else {
+            mTangent = Value::Zero(value.rows(), value.cols());
+            if constexpr (isOuter) {
+                if (dx != nullptr) {
+                    mTangent.noalias() += *dx * y.transpose();
+                }
+                if (dy != nullptr) {
+                    mTangent.noalias() += x * dy->transpose();
+                }
+            } else {
+                if (dx != nullptr) {
+                    mTangent.noalias() += *dx * y;
+                }
+                if (dy != nullptr) {
+                    mTangent.noalias() += x * *dy;
+                }
+            }
+        }
+        return mTangent;
+    }
+
+    void pullBack(Value const& /*value*/, Value const& gradient,
+        Value const& product) final
+    {
+        auto const& x  = mX.value();
+        auto const& y  = mY.value();
+        auto const* dx = mX.tangent();
+        auto const* dy = mY.tangent();
+        auto const& g  = gradient;
+        auto const& p  = product;
+        if (mX.evaluator) {
+            if constexpr (isDot) {
+                mGradientX = g * y;
+                mProductX  = p * y;
+                if (dy != nullptr) {
+                    mProductX += g * *dy;
+                }
+            } else if constexpr (isOuter) {
+                mGradientX.noalias() = g * y;
+                mProductX.noalias()  = p * y;
+                if (dy != nullptr) {
+                    mProductX.noalias() += g * *dy;
+                }
+            } else {
+                mGradientX.noalias() = g * y.transpose();
+                mProductX.noalias()  = p * y.transpose();
+                if (dy != nullptr) {
+                    mProductX.noalias() += g * dy->transpose();
+                }
+            }
+            mX.pullBack(mGradientX, mProductX);
+        }
+        if (mY.evaluator) {
+            if constexpr (isDot) {
+                mGradientY = g * x;
+                mProductY  = p * x;
+                if (dx != nullptr) {
+                    mProductY += g * *dx;
+                }
+            } else if constexpr (isOuter) {
+                mGradientY.noalias() = g.transpose() * x;
+                mProductY.noalias()  = p.transpose() * x;
+                if (dx != nullptr) {
+                    mProductY.noalias() += g.transpose() * *dx;
+                }
+            } else {
+                mGradientY.noalias() = x.transpose() * g;
+                mProductY.noalias()  = x.transpose() * p;
+                if (dx != nullptr) {
+                    mProductY.noalias() += dx->transpose() * g;
+                }
+            }
+            mY.pullBack(mGradientY, mProductY);
+        }
+    }
+
+private:
+    static constexpr bool isDot = std::is_arithmetic_v<Value>;
+    static constexpr bool isOuter
+        = !isDot && ValueX::ColsAtCompileTime == 1
+        && ValueY::ColsAtCompileTime == 1;
+
+    OperandX mX;
+    OperandY mY;
+    Value mTangent{};
+    ValueX mGradientX; // passed on to the operands
+    ValueX mProductX;
+    ValueY mGradientY;
+    ValueY mProductY;
+};
+
+template <typename Value>
+constexpr bool isDense = std::is_base_of_v<Eigen::MatrixBase<Value>, Value>;
+
+template <typename Value, typename Derivative, typename Arg>
+auto makeUnaryRule(RuleKind const& kind, Arg const& arg)
+    -> std::shared_ptr<SecondOrderRule<Value>>
+{
+    using X = RuleArgument<Arg>;
+    if constexpr (X::isExpression && std::is_arithmetic_v<Value>) {
+        using ValueX = typename X::Value;
+        if constexpr (std::is_same_v<ValueX, Value>) {
+            if (kind.type == RuleKind::Type::Scalar && isUnary(kind.opcode)) {
+                return std::make_shared<ScalarRule<Value, Derivative>>(
+                    kind.opcode, ruleOperand<Value, Derivative>(arg),
+                    RuleOperand<Value, Derivative>{});
+            }
+        } else if constexpr (isDense<ValueX>) {
+            if constexpr (std::is_same_v<typename ValueX::Scalar, Value>) {
+                if (kind.type == RuleKind::Type::Reduction) {
+                    return std::make_shared<
+                        ReductionRule<ValueX, typename X::Derivative>>(
+                        kind.reduce, arg.wrapper().evaluator());
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+template <typename Value, typename Derivative, typename ArgX, typename ArgY>
+auto makeBinaryRule(RuleKind const& kind, ArgX const& x, ArgY const& y)
+    -> std::shared_ptr<SecondOrderRule<Value>>
+{
+    using X = RuleArgument<ArgX>;
+    using Y = RuleArgument<ArgY>;
+    if constexpr (X::isExpression || Y::isExpression) {
+        using ValueX = typename X::Value;
+        using ValueY = typename Y::Value;
+        if constexpr (std::is_arithmetic_v<Value>
+            && std::is_same_v<ValueX, Value> && std::is_same_v<ValueY, Value>) {
+            if (kind.type == RuleKind::Type::Scalar && !isUnary(kind.opcode)) {
+                return std::make_shared<ScalarRule<Value, Derivative>>(
+                    kind.opcode, ruleOperand<Value, Derivative>(x),
+                    ruleOperand<Value, Derivative>(y));
+            }
+        } else if constexpr (isDense<ValueX> && isDense<ValueY>) {
+            if (kind.type == RuleKind::Type::Product) {
+                return std::make_shared<
+                    ProductRule<ValueX, ValueY, Value, Derivative>>(
+                    ruleOperand<ValueX, Derivative>(x),
+                    ruleOperand<ValueY, Derivative>(y));
+            }
+        }
+    }
+    return nullptr;
+}
+
+// Rule of an operation of the core library, given the arguments of its
+// binding function (before they are moved into the operation), or null
+template <typename Value, typename Derivative, typename... Args>
+auto makeRule(RuleKind const& kind, Args const&... args)
+    -> std::shared_ptr<SecondOrderRule<Value>>
+{
+    if (kind.type == RuleKind::Type::None) {
+        return nullptr;
+    }
+    if constexpr (sizeof...(Args) == 1) {
+        return makeUnaryRule<Value, Derivative>(kind, args...);
+    } else if constexpr (sizeof...(Args) == 2) {
+        auto const binary = [&kind](auto const& x, auto const& y) {
+            return kind.swapped
+                ? makeBinaryRule<Value, Derivative>(kind, y, x)
+                : makeBinaryRule<Value, Derivative>(kind, x, y);
+        };
+        return binary(args...);
+    } else {
+        return nullptr;
+    }
+}
+
+} // namespace AutoDiff::Python::detail
+
+#endif // AUTODIFF_PYTHON_SECOND_ORDER_HPP
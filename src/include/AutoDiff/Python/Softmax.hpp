@@ -0,0 +1,368 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_SOFTMAX_HPP
+#define AUTODIFF_PYTHON_SOFTMAX_HPP
+
+#include "BufferPool.hpp"
+#include "Evaluator.hpp" // detail::threadState
+#include "Expression.hpp"
+
+#include <AutoDiff/src/Core/Expression.hpp>
+#include <Eigen/Core>
+
+#include <cmath>   // isfinite, log
+#include <limits>  // numeric_limits
+#include <utility> // move
+
+namespace AutoDiff::Python {
+
+namespace detail {
+
+// log(sum(exp(x))) of the elements, shifted by their maximum to avoid
+// overflow; -inf for empty arrays
+template <typename Array>
+auto logSumExp(Array const& x) -> typename Array::Scalar
+{
+    using Scalar = typename Array::Scalar;
+    if (x.size() == 0) {
+        return -std::numeric_limits<Scalar>::infinity();
+    }
+    auto const max = x.maxCoeff();
+    if (!std::isfinite(max)) {
+        return max;
+    }
+    return max + std::log((x - max).exp().sum());
+}
+
+} // namespace detail
+
+// Log-sum-exp of the elements of an array expression, in a single node.
+// The gradient is the softmax of the elements, so tangents and gradients
+// are a single (vector-matrix) product with it.
+template <typename Value, typename Derivative_>
+class LogSumExp
+    : public AutoDiff::Expression<LogSumExp<Value, Derivative_>> {
+public:
+    using Derivative = Derivative_;
+    using Operand    = ExpressionWrapper<Value, Derivative>;
+    using Scalar     = typename Value::Scalar;
+    using Array      = Eigen::Array<Scalar, Eigen::Dynamic, 1>;
+
+    explicit LogSumExp(Operand operand)
+        : mOperand{std::move(operand)}
+    {
+    }
+
+    [[nodiscard]] auto _valueImpl() -> Scalar const&
+    {
+        auto const& x = mOperand._value();
+        mOperandValue = &x;
+        mValue        = detail::logSumExp(flat(x));
+        mHasWeights   = false; // operand might have changed
+        return mValue;
+    }
+
+    [[nodiscard]] auto _pushForwardImpl() -> Derivative const&
+    {
+        auto const& weights = this->weights();
+        auto const& tangent = mOperand._pushForward();
+        detail::reuse(mDerivative, tangent.cols());
+        mDerivative.noalias() = weights.matrix().transpose() * tangent;
+        return mDerivative;
+    }
+
+    void _pullBackImpl(Derivative const& gradient)
+    {
+        auto const& weights = this->weights();
+        detail::reuse(mGradient, gradient.rows() * weights.size());
+        mGradient.noalias() = gradient * weights.matrix().transpose();
+        mOperand._pullBack(mGradient);
+    }
+
+    // Second-order sweep (see AbstractEvaluator::valueTangent), with the
+    // Hessian diag(s) - s sᵀ applied to the tangent.
+    [[nodiscard]] auto _valueTangent() -> Scalar const&
+    {
+        auto const& s = weights();
+        mTangent      = (s * flat(mOperand._valueTangent())).sum();
+        return mTangent;
+    }
+
+    void _pullBackSecond(Scalar const& gradient, Scalar const& product)
+    {
+        auto const& s      = weights();
+        auto const& like   = operandValue();
+        auto const dx      = flat(mOperand._valueTangent());
+        auto const tangent = (s * dx).sum();
+        detail::reuse(mGradientValue, like.size());
+        detail::reuse(mProduct, like.size());
+        mGradientValue.resize(like.rows(), like.cols());
+        mProduct.resize(like.rows(), like.cols());
+        flat(mGradientValue) = gradient * s;
+        flat(mProduct)       = product * s + gradient * s * (dx - tangent);
+        mOperand._pullBackSecond(mGradientValue, mProduct);
+    }
+
+    void _transferChildrenToImpl(internal::Node& node) const
+    {
+        mOperand._transferChildrenTo(node);
+    }
+
+    void _releaseCacheImpl() const
+    {
+        mHasWeights = false;
+        if (!detail::threadState().retainCache) {
+            mOperandValue = nullptr; // recycled by the operand
+            detail::recycle(mWeights);
+            detail::recycle(mDerivative);
+            detail::recycle(mGradient);
+            detail::recycle(mGradientValue);
+            detail::recycle(mProduct);
+        }
+        mOperand._releaseCache();
+    }
+
+private:
+    // elements in column-major order
+    static auto flat(Value const& value) -> Eigen::Map<Array const>
+    {
+        return Eigen::Map<Array const>(value.data(), value.size());
+    }
+
+    static auto flat(Value& value) -> Eigen::Map<Array>
+    {
+        return Eigen::Map<Array>(value.data(), value.size());
+    }
+
+    // softmax of the elements (the gradient of the log-sum-exp)
+    auto weights() -> Array const&
+    {
+        if (mHasWeights) {
+            return mWeights;
+        }
+        auto const x = flat(operandValue());
+        detail::reuse(mWeights, x.size());
+        mWeights    = (x - detail::logSumExp(x)).exp();
+        mHasWeights = true;
+        return mWeights;
+    }
+
+    // of the last evaluation; evaluating the operand again would re-evaluate
+    // its whole subtree
+    auto operandValue() -> Value const&
+    {
+        return mOperandValue != nullptr ? *mOperandValue : mOperand._value();
+    }
+
+    Operand mOperand;
+
+    // cache
+    mutable Value const* mOperandValue = nullptr; // of the last evaluation
+    mutable Scalar mValue{};
+    mutable Array mWeights;
+    mutable bool mHasWeights = false;
+    mutable Derivative mDerivative;
+    mutable Derivative mGradient; // passed on to the operand
+
+    // cache of the second-order sweep
+    mutable Scalar mTangent{};
+    mutable Value mGradientValue; // passed on to the operand
+    mutable Value mProduct;
+};
+
+// Softmax (or its logarithm) of a vector expression, in a single node.
+// With s the softmax, the Jacobian is diag(s) - s sᵀ (or I - 1 sᵀ for the
+// logarithm), which is applied as a scaling and a rank-one update instead of
+// being stored as a dense n⨉n matrix.
+template <typename Value, typename Derivative_>
+class Softmax : public AutoDiff::Expression<Softmax<Value, Derivative_>> {
+public:
+    using Derivative = Derivative_;
+    using Operand    = ExpressionWrapper<Value, Derivative>;
+    using Scalar     = typename Value::Scalar;
+    using Array      = Eigen::Array<Scalar, Eigen::Dynamic, 1>;
+    using Row        = Eigen::Matrix<Scalar, 1, Eigen::Dynamic>;
+    using Column     = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+
+    Softmax(bool log, Operand operand)
+        : mLog{log}
+        , mOperand{std::move(operand)}
+    {
+    }
+
+    [[nodiscard]] auto _valueImpl() -> Value const&
+    {
+        auto const& x = mOperand._value();
+        mOperandValue = &x;
+        detail::reuse(mValue, x.size());
+        auto const normalizer = detail::logSumExp(x.array());
+        if (mLog) {
+            mValue = x.array() - normalizer;
+        } else {
+            mValue = (x.array() - normalizer).exp();
+        }
+        mHasWeights = false; // operand might have changed
+        return mValue;
+    }
+
+    [[nodiscard]] auto _pushForwardImpl() -> Derivative const&
+    {
+        auto const& s       = weights().matrix();
+        auto const& tangent = mOperand._pushForward();
+        mRow.noalias()      = s.transpose() * tangent; // sᵀ t
+        detail::reuse(mDerivative, tangent.size());
+        if (mLog) {
+            mDerivative = tangent;
+            mDerivative.rowwise() -= mRow;
+        } else {
+            mDerivative.noalias() = s.asDiagonal() * tangent;
+            mDerivative.noalias() -= s * mRow;
+        }
+        return mDerivative;
+    }
+
+    void _pullBackImpl(Derivative const& gradient)
+    {
+        auto const& s = weights().matrix();
+        detail::reuse(mGradient, gradient.size());
+        if (mLog) {
+            mColumn   = gradient.rowwise().sum(); // g 1
+            mGradient = gradient;
+        } else {
+            mColumn.noalias()   = gradient * s; // g s
+            mGradient.noalias() = gradient * s.asDiagonal();
+        }
+        mGradient.noalias() -= mColumn * s.transpose();
+        mOperand._pullBack(mGradient);
+    }
+
+    // Second-order sweep (see AbstractEvaluator::valueTangent), with the
+    // tangent ṡ = s ⊙ (ẋ - sᵀẋ) of the softmax, by which the Jacobian
+    // changes along the tangent of the operand.
+    [[nodiscard]] auto _valueTangent() -> Value const&
+    {
+        auto const& s  = weights();
+        auto const& dx = mOperand._valueTangent();
+        detail::reuse(mTangent, dx.size());
+        auto const shift = (s * dx.array()).sum(); // sᵀẋ
+        if (mLog) {
+            mTangent = dx.array() - shift;
+        } else {
+            mTangent = s * (dx.array() - shift);
+        }
+        return mTangent;
+    }
+
+    void _pullBackSecond(Value const& gradient, Value const& product)
+    {
+        auto const& s  = weights();
+        auto const& dx = mOperand._valueTangent();
+        auto const g   = gradient.array();
+        auto const p   = product.array();
+        detail::reuse(mWeightsTangent, s.size());
+        detail::reuse(mGradientValue, s.size());
+        detail::reuse(mProduct, s.size());
+        mWeightsTangent = s * (dx.array() - (s * dx.array()).sum()); // ṡ
+        auto const& ds  = mWeightsTangent;
+        if (mLog) {
+            mGradientValue = g - s * g.sum();
+            mProduct       = p - ds * g.sum() - s * p.sum();
+        } else {
+            auto const sg  = (s * g).sum(); // sᵀg
+            mGradientValue = s * (g - sg);
+            mProduct       = ds * (g - sg)
+                + s * (p - (ds * g).sum() - (s * p).sum());
+        }
+        mOperand._pullBackSecond(mGradientValue, mProduct);
+    }
+
+    void _transferChildrenToImpl(internal::Node& node) const
+    {
+        mOperand._transferChildrenTo(node);
+    }
+
+    void _releaseCacheImpl() const
+    {
+        mHasWeights = false;
+        if (!detail::threadState().retainCache) {
+            mOperandValue = nullptr; // recycled by the operand
+            detail::recycle(mValue);
+            detail::recycle(mWeights);
+            detail::recycle(mDerivative);
+            detail::recycle(mGradient);
+            detail::recycle(mTangent);
+            detail::recycle(mWeightsTangent);
+            detail::recycle(mGradientValue);
+            detail::recycle(mProduct);
+        }
+        mOperand._releaseCache();
+    }
+
+private:
+    // softmax of the operand's value
+    auto weights() -> Array const&
+    {
+        if (mHasWeights) {
+            return mWeights;
+        }
+        auto const x = operandValue().array();
+        detail::reuse(mWeights, x.size());
+        mWeights    = (x - detail::logSumExp(x)).exp();
+        mHasWeights = true;
+        return mWeights;
+    }
+
+    // of the last evaluation; evaluating the operand again would re-evaluate
+    // its whole subtree
+    auto operandValue() -> Value const&
+    {
+        return mOperandValue != nullptr ? *mOperandValue : mOperand._value();
+    }
+
+    bool mLog; // log-softmax
+    Operand mOperand;
+
+    // cache
+    mutable Value const* mOperandValue = nullptr; // of the last evaluation
+    mutable Value mValue;
+    mutable Array mWeights;
+    mutable bool mHasWeights = false;
+    mutable Row mRow;       // of the tangents
+    mutable Column mColumn; // of the gradients
+    mutable Derivative mDerivative;
+    mutable Derivative mGradient; // passed on to the operand
+
+    // cache of the second-order sweep
+    mutable Value mTangent;
+    mutable Array mWeightsTangent;
+    mutable Value mGradientValue; // passed on to the operand
+    mutable Value mProduct;
+};
+
+template <typename Value, typename Derivative>
+auto logSumExp(ExpressionWrapper<Value, Derivative> operand)
+    -> LogSumExp<Value, Derivative>
+{
+    return LogSumExp<Value, Derivative>{std::move(operand)};
+}
+
+template <typename Value, typename Derivative>
+auto softmax(ExpressionWrapper<Value, Derivative> operand)
+    -> Softmax<Value, Derivative>
+{
+    return {false, std::move(operand)};
+}
+
+template <typename Value, typename Derivative>
+auto logSoftmax(ExpressionWrapper<Value, Derivative> operand)
+    -> Softmax<Value, Derivative>
+{
+    return {true, std::move(operand)};
+}
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_SOFTMAX_HPP
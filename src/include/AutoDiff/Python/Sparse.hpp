@@ -0,0 +1,320 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_SPARSE_HPP
+#define AUTODIFF_PYTHON_SPARSE_HPP
+
+#include "BufferPool.hpp"
+#include "Evaluator.hpp" // detail::threadState
+#include "Expression.hpp"
+#include "ExpressionBinding.hpp"
+#include "Operation.hpp"
+
+#include <AutoDiff/src/Core/Expression.hpp>
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <memory>    // make_shared, shared_ptr
+#include <stdexcept> // invalid_argument
+#include <string>
+#include <utility> // move
+
+namespace AutoDiff::Python {
+
+// SciPy sparse matrix in CSR or CSC format, mapped by Eigen.
+// The index and data arrays are used without copying only if their data
+// types are int32 and the scalar type; otherwise they are converted (copied)
+// once, when the matrix is created.
+// Copies share the arrays, which are kept alive until the last copy is
+// destroyed (possibly by a worker thread, which then acquires the GIL).
+template <typename Scalar>
+class SparseMatrix {
+public:
+    using StorageIndex = int;
+    using RowMajorMap  = Eigen::Map<
+        Eigen::SparseMatrix<Scalar, Eigen::RowMajor, StorageIndex> const>;
+    using ColMajorMap = Eigen::Map<
+        Eigen::SparseMatrix<Scalar, Eigen::ColMajor, StorageIndex> const>;
+
+    explicit SparseMatrix(pybind11::object matrix)
+        : mStorage{std::make_shared<Storage>()}
+    {
+        auto const format = pybind11::hasattr(matrix, "format")
+            ? matrix.attr("format").cast<std::string>()
+            : std::string{};
+        if (format != "csr" && format != "csc") {
+            throw std::invalid_argument(
+                "Expected a SciPy sparse matrix in CSR or CSC format.");
+        }
+        auto const numpy = pybind11::module_::import("numpy");
+        auto array       = [&](char const* name, pybind11::dtype dtype) {
+            return numpy.attr("ascontiguousarray")(matrix.attr(name), dtype)
+                .cast<pybind11::array>();
+        };
+        auto const index   = pybind11::dtype::of<StorageIndex>();
+        auto const data    = array("data", pybind11::dtype::of<Scalar>());
+        auto const indices = array("indices", index);
+        auto const indptr  = array("indptr", index);
+        auto const shape   = matrix.attr("shape").cast<pybind11::tuple>();
+
+        auto& storage    = *mStorage;
+        storage.rowMajor = format == "csr";
+        storage.rows     = shape[0].cast<Eigen::Index>();
+        storage.cols     = shape[1].cast<Eigen::Index>();
+        storage.nonZeros = data.size();
+        storage.data     = static_cast<Scalar const*>(data.data());
+        storage.indices  = static_cast<StorageIndex const*>(indices.data());
+        storage.indptr   = static_cast<StorageIndex const*>(indptr.data());
+        storage.matrix   = std::move(matrix);
+        storage.arrays   = pybind11::make_tuple(data, indices, indptr);
+    }
+
+    // the SciPy matrix
+    [[nodiscard]] auto matrix() const -> pybind11::object const&
+    {
+        return mStorage->matrix;
+    }
+
+    [[nodiscard]] auto rows() const -> Eigen::Index { return mStorage->rows; }
+
+    [[nodiscard]] auto cols() const -> Eigen::Index { return mStorage->cols; }
+
+    [[nodiscard]] auto nonZeros() const -> Eigen::Index
+    {
+        return mStorage->nonZeros;
+    }
+
+    // result = A * x
+    template <typename Dense, typename Result>
+    void multiply(Dense const& x, Result& result) const
+    {
+        if (mStorage->rowMajor) {
+            result.noalias() = rowMajor() * x;
+        } else {
+            result.noalias() = colMajor() * x;
+        }
+    }
+
+    // result = x * A
+    template <typename Dense, typename Result>
+    void multiplyLeft(Dense const& x, Result& result) const
+    {
+        if (mStorage->rowMajor) {
+            result.noalias() = x * rowMajor();
+        } else {
+            result.noalias() = x * colMajor();
+        }
+    }
+
+private:
+    struct Storage {
+        Storage() = default;
+
+        ~Storage()
+        {
+            pybind11::gil_scoped_acquire const gil;
+            matrix = pybind11::object{};
+            arrays = pybind11::object{};
+        }
+
+        Storage(Storage const&)                    = delete;
+        Storage(Storage&&)                         = delete;
+        auto operator=(Storage const&) -> Storage& = delete;
+        auto operator=(Storage&&) -> Storage&      = delete;
+
+        bool rowMajor               = true; // CSR, else CSC
+        Eigen::Index rows           = 0;
+        Eigen::Index cols           = 0;
+        Eigen::Index nonZeros       = 0;
+        Scalar const* data          = nullptr;
+        StorageIndex const* indices = nullptr;
+        StorageIndex const* indptr  = nullptr;
+        pybind11::object matrix;
+        pybind11::object arrays; // owning the mapped data
+    };
+
+    [[nodiscard]] auto rowMajor() const -> RowMajorMap
+    {
+        auto const& s = *mStorage;
+        return RowMajorMap(
+            s.rows, s.cols, s.nonZeros, s.indptr, s.indices, s.data);
+    }
+
+    [[nodiscard]] auto colMajor() const -> ColMajorMap
+    {
+        auto const& s = *mStorage;
+        return ColMajorMap(
+            s.rows, s.cols, s.nonZeros, s.indptr, s.indices, s.data);
+    }
+
+    std::shared_ptr<Storage> mStorage;
+};
+
+// Product of a sparse matrix (a literal) with a vector expression.
+// The Jacobian with respect to the vector is the sparse matrix itself, so
+// tangents and gradients are multiplied with it in O(nnz) per direction,
+// instead of the O(n²) of a dense matrix literal.
+template <typename Value, typename Derivative_>
+class SparseProduct
+    : public AutoDiff::Expression<SparseProduct<Value, Derivative_>> {
+public:
+    using Derivative = Derivative_;
+    using Operand    = ExpressionWrapper<Value, Derivative>;
+    using Scalar     = typename Value::Scalar;
+    using Matrix     = SparseMatrix<Scalar>;
+
+    SparseProduct(Matrix matrix, Operand operand)
+        : mMatrix{std::move(matrix)}
+        , mOperand{std::move(operand)}
+    {
+    }
+
+    [[nodiscard]] auto _valueImpl() -> Value const&
+    {
+        auto const& operand = mOperand._value();
+        if (operand.size() != mMatrix.cols()) {
+            throw std::invalid_argument(
+                "The sizes of the matrix and the vector do not match.");
+        }
+        detail::reuse(mValue, mMatrix.rows());
+        mMatrix.multiply(operand, mValue);
+        return mValue;
+    }
+
+    [[nodiscard]] auto _pushForwardImpl() -> Derivative const&
+    {
+        auto const& tangent = mOperand._pushForward();
+        detail::reuse(mDerivative, mMatrix.rows() * tangent.cols());
+        mMatrix.multiply(tangent, mDerivative);
+        return mDerivative;
+    }
+
+    void _pullBackImpl(Derivative const& gradient)
+    {
+        detail::reuse(mGradient, gradient.rows() * mMatrix.cols());
+        mMatrix.multiplyLeft(gradient, mGradient);
+        mOperand._pullBack(mGradient);
+    }
+
+    // second-order sweep (see AbstractEvaluator::valueTangent), linear
+    [[nodiscard]] auto _valueTangent() -> Value const&
+    {
+        detail::reuse(mTangent, mMatrix.rows());
+        mMatrix.multiply(mOperand._valueTangent(), mTangent);
+        return mTangent;
+    }
+
+    void _pullBackSecond(Value const& gradient, Value const& product)
+    {
+        detail::reuse(mGradientRow, mMatrix.cols());
+        detail::reuse(mProductRow, mMatrix.cols());
+        mMatrix.multiplyLeft(gradient.transpose(), mGradientRow); // gᵀA
+        mMatrix.multiplyLeft(product.transpose(), mProductRow);
+        mOperand._pullBackSecond(
+            mGradientRow.transpose(), mProductRow.transpose());
+    }
+
+    void _transferChildrenToImpl(internal::Node& node) const
+    {
+        mOperand._transferChildrenTo(node);
+    }
+
+    void _releaseCacheImpl() const
+    {
+        if (!detail::threadState().retainCache) {
+            detail::recycle(mValue);
+            detail::recycle(mDerivative);
+            detail::recycle(mGradient);
+            detail::recycle(mTangent);
+            detail::recycle(mGradientRow);
+            detail::recycle(mProductRow);
+        }
+        mOperand._releaseCache();
+    }
+
+private:
+    using Row = Eigen::Matrix<Scalar, 1, Eigen::Dynamic>;
+
+    Matrix mMatrix;
+    Operand mOperand;
+
+    // cache
+    mutable Value mValue;
+    mutable Derivative mDerivative;
+    mutable Derivative mGradient; // passed on to the operand
+
+    // cache of the second-order sweep
+    mutable Value mTangent;
+    mutable Row mGradientRow;
+    mutable Row mProductRow;
+};
+
+// Binds SparseMatrixVariable and its products with the vector expressions
+// of the binding (A @ x and matmul(A, x))
+template <typename VectorBinding>
+void defSparseMatrix(pybind11::module& module)
+{
+    using Expr   = typename VectorBinding::Expr;
+    using Op     = typename VectorBinding::Op;
+    using Value  = typename VectorBinding::Value;
+    using Matrix = SparseMatrix<typename VectorBinding::Scalar>;
+
+    auto matrixClass = pybind11::class_<Matrix>(module, "SparseMatrixVariable",
+        R"doc(A sparse matrix literal, applied to vector expressions with `@`.
+
+The matrix is a SciPy sparse matrix (or array) in CSR or CSC format. Its
+arrays are used without copying only if the indices are int32 and the data
+has the scalar type of the module; otherwise they are copied once.
+Despite the name, it is not a `Variable`: it has no derivative and cannot be
+a source or target of a function. Derivatives are taken with respect to the
+vector, and are computed with sparse products.
+Sparse products cannot be saved to a tape.
+
+Examples
+--------
+>>> A = SparseMatrixVariable(scipy.sparse.eye(3, format="csr"))
+
+>>> x = var(np.array([1., 2., 3.]))
+
+>>> y = var(A @ x))doc");
+
+    matrixClass.def(pybind11::init<pybind11::object>(),
+        pybind11::arg("matrix"),
+        R"doc(Map a SciPy sparse matrix in CSR or CSC format.
+
+Raises
+------
+ValueError
+    If the matrix is not a SciPy sparse matrix in CSR or CSC format.)doc");
+
+    matrixClass.def("__call__", &Matrix::matrix,
+        R"doc(Returns the SciPy sparse matrix.)doc");
+
+    matrixClass.def_property_readonly(
+        "shape",
+        [](Matrix const& matrix) {
+            return pybind11::make_tuple(matrix.rows(), matrix.cols());
+        },
+        R"doc(Number of rows and columns.)doc");
+
+    matrixClass.def_property_readonly(
+        "nnz", &Matrix::nonZeros, R"doc(Number of stored elements.)doc");
+
+    auto func = [](Matrix const& matrix, Expr const& vector) {
+        return Op{SparseProduct<Value, typename VectorBinding::Derivative>{
+            matrix, vector.wrapper()}};
+    };
+    matrixClass.def("__matmul__", detail::recorded("__matmul__", true, +func),
+        pybind11::arg("other"), "Sparse matrix-vector product.");
+    module.def("matmul", detail::recorded("matmul", false, +func),
+        pybind11::arg("lhs"), pybind11::arg("rhs"),
+        "Sparse matrix-vector product.");
+}
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_SPARSE_HPP
@@ -0,0 +1,204 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_STATE_HPP
+#define AUTODIFF_PYTHON_STATE_HPP
+
+#include <atomic>
+#include <cstddef>    // ptrdiff_t, size_t
+#include <functional> // hash
+#include <memory>     // shared_ptr
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace AutoDiff::Python {
+
+class Arena;
+class Profiler;
+class Tape;
+
+namespace detail {
+
+struct VariableStatus;
+
+// Derivative of a variable read by an expression, through which the levels
+// of a function pull gradients back (see Function::pullGradient).
+// Each sweep of a function sets the gradients of its sources, so the
+// gradients pulled back into a variable read by several functions are kept
+// and summed before the variable pulls them back itself.
+class GradientSlot {
+public:
+    virtual ~GradientSlot() = default;
+
+    // adds the derivative to the kept gradient
+    virtual void keep() = 0;
+
+    // sets the derivative to the kept gradient and drops it
+    virtual void restore() = 0;
+
+    // sets the derivative to the identity map, seeding `count` directions,
+    // or to zero of the same dimensions
+    virtual void seed(bool identity, std::ptrdiff_t count, bool tangent) = 0;
+
+    // held by the value and the derivative (see Function::summary)
+    [[nodiscard]] virtual auto valueBytes() const -> std::size_t      = 0;
+    [[nodiscard]] virtual auto derivativeBytes() const -> std::size_t = 0;
+
+    // sets the derivative to the tangent of the gradient of the running
+    // second-order sweep (see Function::hvp), as a single gradient row
+    virtual void storeProduct() = 0;
+};
+
+// Expression of a variable in the second-order sweeps of Function::hvp,
+// which store the tangents and gradients of the variables in SecondOrder
+class SecondOrderRoot {
+public:
+    virtual ~SecondOrderRoot() = default;
+
+    // sets the tangent of the variable to that of the expression
+    virtual void pushTangent(void const* key) = 0;
+
+    // sets the gradient of the variable to one and its tangent to zero
+    virtual void seed(void const* key) = 0;
+
+    // pulls the gradient of the variable and its tangent back, if any
+    virtual void pullBack(void const* key) = 0;
+};
+
+// Second-order sweep of this thread (see Function::hvp).
+// The values are type-erased, since each is only read and written by the
+// evaluators of its variable, which know its type.
+struct SecondOrder {
+    struct Entry {
+        std::shared_ptr<void> tangent;  // of the value
+        std::shared_ptr<void> gradient; // of the seed target
+        std::shared_ptr<void> product;  // tangent of the gradient
+    };
+
+    std::unordered_map<void const*, Entry> entries; // by node of variable
+    // leaves whose derivatives hold the tangents of their values
+    std::unordered_set<void const*> const* directions = nullptr;
+};
+
+// Variables read during an evaluation (see Function::evaluate) or by an
+// expression (see Variable::set)
+struct Reads {
+    struct Read {
+        void const* key; // node of the variable
+        std::shared_ptr<VariableStatus> status;
+        GradientSlot* slot = nullptr; // if read by an expression
+    };
+
+    std::vector<Read> reads;
+    bool complete = true; // whether all variables read had a status
+
+    void add(void const* key, std::shared_ptr<VariableStatus> const& status,
+        GradientSlot* slot = nullptr)
+    {
+        if (status) {
+            reads.push_back({key, status, slot});
+        } else {
+            complete = false;
+        }
+    }
+};
+
+// Variables and operations of an expression (see Variable::set)
+struct Operands {
+    Reads variables;                     // read by the expression
+    std::vector<void const*> operations; // evaluators, possibly shared
+    std::vector<std::string const*> names; // of their operation types
+    std::shared_ptr<SecondOrderRoot> root;  // see Function::hvp
+};
+
+// Shared by the copies of a variable and by the expressions reading it
+struct VariableStatus {
+    // value version of the last modification (written by the threads
+    // running sweeps, read by Python threads)
+    std::atomic<std::size_t> modified{0};
+    // value version of the last derivative set from Python or pushed by an
+    // incremental function (see Function::pushTangent)
+    std::atomic<std::size_t> derivativeModified{0};
+    bool hasExpression = false;
+    std::atomic<int> locks{0}; // by asynchronous sweeps
+    // of the expression, if recorded (see Function::schedule)
+    std::optional<Operands> operands;
+    // hash of the variables read by the expression, zero without one
+    // (see Function::compile)
+    std::size_t structure = 0;
+};
+
+// Hash of the variables read by an expression (the edges of the graph into
+// the variable), one if not all of them had a status, otherwise at least two
+inline auto structureOf(Reads const& variables) -> std::size_t
+{
+    if (!variables.complete) {
+        return 1;
+    }
+    auto hash = std::size_t{0x9e3779b9};
+    for (auto const& variable : variables.reads) {
+        hash ^= std::hash<void const*>{}(variable.key) + 0x9e3779b9
+            + (hash << 6) + (hash >> 2);
+    }
+    return hash < 2 ? hash + 2 : hash;
+}
+
+// State of the calling thread (set by scopes and context managers)
+struct ThreadState {
+    bool retainCache         = false;   // see CacheScope
+    Profiler* profiler       = nullptr; // see ProfileScope
+    Tape* tape               = nullptr; // see Tape::enter
+    std::shared_ptr<Arena> arena;       // see Graph::enter
+    Reads* reads             = nullptr; // see Function::evaluate
+    Operands* operands       = nullptr; // see Variable::set
+    SecondOrder* secondOrder = nullptr; // see Function::hvp
+};
+
+// Global state of all extension modules.
+// Each shared library (extension module) has its own copies of inline
+// variables, so the modules use the state of the `autodiff._core` module,
+// which allows one function to sweep through variables of several modules.
+struct State {
+    static constexpr auto capsuleName = "autodiff._core.State.v7";
+
+    // Incremented whenever a variable gets a new expression or loses it by
+    // `set`, which might change the graph of compiled functions
+    std::atomic<std::size_t> graphVersion{0};
+
+    // Incremented whenever the value of a variable is set or assigned;
+    // each variable records the version of its last modification
+    std::atomic<std::size_t> valueVersion{0};
+
+    // Incremented by the sweeps writing derivatives of any variable of their
+    // graph, after which incremental functions push all tangents again
+    std::atomic<std::size_t> derivativeVersion{0};
+
+    // state of the calling thread (thread-local in the owning module)
+    ThreadState& (*thread)();
+};
+
+inline auto localThreadState() -> ThreadState&
+{
+    thread_local auto state = ThreadState{};
+    return state;
+}
+
+// state of this module, used unless the module shares another one
+inline State localState{{0}, {0}, {0}, &localThreadState};
+
+inline State* sharedState = &localState;
+
+inline auto state() -> State& { return *sharedState; }
+
+inline auto threadState() -> ThreadState& { return sharedState->thread(); }
+
+} // namespace detail
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_STATE_HPP
@@ -0,0 +1,227 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_TAPE_HPP
+#define AUTODIFF_PYTHON_TAPE_HPP
+
+#include "AbstractVariable.hpp"
+#include "SecondOrder.hpp"
+#include "State.hpp"
+
+#include <pybind11/pybind11.h>
+
+#include <memory>
+#include <stdexcept> // logic_error, runtime_error
+#include <string>
+#include <type_traits> // decay_t, void_t
+#include <unordered_map>
+#include <unordered_set>
+#include <utility> // exchange, forward, move, pair
+#include <vector>
+
+namespace AutoDiff::Python {
+
+// Records how expressions and variables are created from Python, so that the
+// graph of a function can be lowered to a TapeFunction (and saved with it).
+// Expressions are identified by their keys (the evaluators of operations and
+// the nodes of variables), which the tape keeps alive while recording.
+class Tape {
+public:
+    // argument of a recorded call, either an expression or a literal
+    struct Operand {
+        void const* expression = nullptr; // null for literals
+        pybind11::object literal;
+    };
+
+    // call of a Python function or method returning an operation
+    struct Call {
+        std::string name;
+        bool method = false; // called on the first operand
+        std::vector<Operand> operands;
+        std::shared_ptr<void const> result; // keeps the key alive
+    };
+
+    struct VariableRecord {
+        std::shared_ptr<AbstractVariable const> variable; // a copy
+        void const* expression = nullptr; // null for literal variables
+    };
+
+    [[nodiscard]] auto calls() const
+        -> std::unordered_map<void const*, Call> const&
+    {
+        return mCalls;
+    }
+
+    [[nodiscard]] auto variables() const
+        -> std::unordered_map<void const*, VariableRecord> const&
+    {
+        return mVariables;
+    }
+
+    void recordCall(void const* key, Call call)
+    {
+        mCalls[key] = std::move(call);
+    }
+
+    void recordVariable(void const* key, VariableRecord record)
+    {
+        mVariables[key] = std::move(record);
+    }
+
+    // Keys of the given expressions and their dependencies in topological
+    // order, not including the dependencies of the given leaves.
+    // Throws if an expression was not recorded or if the graph has a cycle.
+    [[nodiscard]] auto sort(std::vector<void const*> const& roots,
+        std::unordered_set<void const*> const& leaves = {}) const
+        -> std::vector<void const*>
+    {
+        auto sorted  = std::vector<void const*>{};
+        auto visited = std::unordered_set<void const*>{};
+        auto pending = std::unordered_set<void const*>{}; // being visited
+        // depth-first search without recursion (graphs can be deep)
+        auto stack = std::vector<std::pair<void const*, bool>>{};
+        for (auto const* root : roots) {
+            stack.emplace_back(root, false);
+            while (!stack.empty()) {
+                auto const [key, expanded] = stack.back();
+                if (visited.count(key) != 0) {
+                    stack.pop_back();
+                } else if (expanded) {
+                    stack.pop_back();
+                    pending.erase(key);
+                    visited.insert(key);
+                    sorted.push_back(key);
+                } else {
+                    stack.back().second = true;
+                    pending.insert(key);
+                    auto const keys = dependencies(key); // throws if unknown
+                    if (leaves.count(key) != 0) {
+                        continue;
+                    }
+                    for (auto const* dependency : keys) {
+                        if (pending.count(dependency) != 0) {
+                            throw std::runtime_error("The graph has a cycle.");
+                        }
+                        if (visited.count(dependency) == 0) {
+                            stack.emplace_back(dependency, false);
+                        }
+                    }
+                }
+            }
+        }
+        return sorted;
+    }
+
+    void enter()
+    {
+        mPrevious.push_back(std::exchange(detail::threadState().tape, this));
+    }
+
+    void exit()
+    {
+        if (mPrevious.empty()) {
+            throw std::logic_error("Tape has not been entered.");
+        }
+        detail::threadState().tape = mPrevious.back();
+        mPrevious.pop_back();
+    }
+
+private:
+    // expressions a recorded expression depends on
+    [[nodiscard]] auto dependencies(void const* key) const
+        -> std::vector<void const*>
+    {
+        auto keys = std::vector<void const*>{};
+        if (auto it = mVariables.find(key); it != mVariables.end()) {
+            if (it->second.expression != nullptr) {
+                keys.push_back(it->second.expression);
+            }
+        } else if (auto it = mCalls.find(key); it != mCalls.end()) {
+            for (auto const& operand : it->second.operands) {
+                if (operand.expression != nullptr) {
+                    keys.push_back(operand.expression);
+                }
+            }
+        } else {
+            throw std::runtime_error("The graph was not recorded on the tape; "
+                                     "create it within `with tape:`.");
+        }
+        return keys;
+    }
+
+    std::unordered_map<void const*, Call> mCalls;
+    std::unordered_map<void const*, VariableRecord> mVariables;
+    std::vector<Tape*> mPrevious; // tapes to restore on exit
+};
+
+namespace detail {
+
+template <typename T, typename = void>
+struct IsExpression : std::false_type { };
+
+template <typename T>
+struct IsExpression<T, std::void_t<decltype(std::declval<T const&>()._key())>>
+    : std::true_type { };
+
+template <typename Arg>
+auto toOperand(Arg const& arg) -> Tape::Operand
+{
+    if constexpr (IsExpression<Arg>::value) {
+        return {arg._key(), {}};
+    } else {
+        return {nullptr, pybind11::cast(arg)};
+    }
+}
+
+// creates the operation of a binding function, with the second-order rule
+// of the core library it might need (see makeRule)
+template <typename Op, typename... Params, typename... Args>
+auto withRule(RuleKind const& kind, Op (*func)(Params...), Args&&... args)
+    -> Op
+{
+    using Evaluator = typename std::decay_t<
+        decltype(std::declval<Op const&>().evaluator())>::element_type;
+    auto rule = makeRule<typename Evaluator::Value,
+        typename Evaluator::Derivative>(kind, args...);
+    auto op = func(std::forward<Args>(args)...);
+    if (rule) {
+        op.evaluator()->setRule(std::move(rule));
+    }
+    return op;
+}
+
+// Binding function that records its calls on the current tape
+template <typename Op, typename... Args>
+auto recorded(std::string name, bool method, Op (*func)(Args...))
+{
+    auto const kind = ruleKind(name);
+    return [name = std::move(name), method, func, kind](Args... args) -> Op {
+        auto* tape = detail::threadState().tape;
+        if (tape == nullptr) {
+            return withRule(kind, func, std::forward<Args>(args)...);
+        }
+        auto call = Tape::Call{name, method, {toOperand(args)...}, {}};
+        auto op   = withRule(kind, func, std::forward<Args>(args)...);
+        call.result = op.evaluator();
+        tape->recordCall(op._key(), std::move(call));
+        return op;
+    };
+}
+
+// records a variable, given its expression (null for literals)
+template <typename Var>
+void recordVariable(Var const& variable, void const* expression)
+{
+    if (auto* tape = detail::threadState().tape) {
+        tape->recordVariable(variable._key(),
+            {std::make_shared<Var const>(variable), expression});
+    }
+}
+
+} // namespace detail
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_TAPE_HPP
@@ -0,0 +1,724 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_TAPE_FUNCTION_HPP
+#define AUTODIFF_PYTHON_TAPE_FUNCTION_HPP
+
+#include "ScalarOpcode.hpp"
+#include "Tape.hpp"
+#include "Variable.hpp"
+
+#include <algorithm> // fill, min
+#include <cmath>
+#include <cstddef>   // size_t
+#include <cstdint>   // uint32_t, uint64_t, uintptr_t
+#include <cstring>   // memcpy
+#include <fstream>
+#include <limits>
+#include <memory>    // dynamic_pointer_cast, shared_ptr
+#include <stdexcept> // invalid_argument, runtime_error
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>   // move, pair, swap
+#include <vector>
+
+namespace AutoDiff::Python {
+
+// Scalar function lowered from a Tape to a flat list of instructions.
+// Instead of calling virtual methods of evaluators scattered across the heap,
+// the sweeps run as linear loops over contiguous arrays of opcodes, operand
+// slots, and values (struct of arrays).
+// Sources are read from their variables before each sweep, and the results
+// are written back to the variables of the graph after it.
+//
+// The instructions can be saved to a file and loaded again without the
+// graph, mapping the file into memory and running the sweeps directly on the
+// mapped arrays. All integers are little-endian:
+//
+//   "ADTAPE02", numbers (u64) of slots, instructions, constants, sources,
+//   and targets, then the arrays, each aligned to 64 bytes:
+//     opcodes (u8), lhs, rhs, and out slots (u32) of the instructions,
+//     slots (u32) and values (f64) of the constants,
+//     slots (u32) and values (f64, as saved) of the sources,
+//     slots (u32) of the targets
+//
+// Literal variables that are not sources are saved as constants.
+class TapeFunction {
+public:
+    using Var = Variable<double, double>;
+
+    using Opcode = detail::ScalarOpcode;
+
+    // Lower the graph from the sources to the targets, given by their keys.
+    // Literal variables in the graph are treated as (additional) sources.
+    TapeFunction(Tape const& tape, std::vector<void const*> const& sources,
+        std::vector<void const*> const& targets)
+    {
+        if (targets.empty()) {
+            throw std::invalid_argument("The function has no targets.");
+        }
+        auto const leaves
+            = std::unordered_set<void const*>(sources.begin(), sources.end());
+        auto roots = targets;
+        roots.insert(roots.end(), sources.begin(), sources.end());
+        auto const keys = tape.sort(roots, leaves);
+        // all operations must be supported, whatever their variables
+        for (auto const* key : keys) {
+            if (auto it = tape.calls().find(key); it != tape.calls().end()) {
+                auto swapped = false;
+                opcodeOf(it->second, swapped);
+            }
+        }
+        auto code = std::make_shared<Instructions>();
+        for (auto const* key : keys) {
+            auto const it   = tape.variables().find(key);
+            auto const slot = it != tape.variables().end()
+                ? lowerVariable(it->second, leaves.count(key) != 0)
+                : lowerCall(tape.calls().at(key), *code);
+            mSlots.emplace(key, slot);
+        }
+        for (auto const* key : sources) {
+            mSources.push_back({mVariablesByKey.at(key), mSlots.at(key)});
+        }
+        for (auto const* key : targets) {
+            if (mVariablesByKey.count(key) == 0) {
+                throw std::invalid_argument("The targets must be variables.");
+            }
+            mTargets.push_back({mVariablesByKey.at(key), mSlots.at(key)});
+        }
+        mInstructionCount = code->opcodes.size();
+        mOpcodes          = code->opcodes.data();
+        mLhs              = code->lhs.data();
+        mRhs              = code->rhs.data();
+        mOut              = code->out.data();
+        mStorage          = std::move(code);
+        initValues();
+    }
+
+    // Function of the instructions saved in a buffer (see save), which runs
+    // on the arrays of the buffer, kept alive by the storage.
+    // New variables are created for the sources, with their saved values,
+    // and for the targets, which are evaluated.
+    static auto load(std::shared_ptr<void const> storage, char const* data,
+        std::size_t size) -> TapeFunction
+    {
+        checkByteOrder();
+        auto reader = Reader{data, size};
+        if (std::string_view(reader.take(magic.size()), magic.size())
+            != magic) {
+            throw std::runtime_error("Invalid tape: unknown file format.");
+        }
+        auto const slotCount     = reader.u64();
+        auto const count         = reader.u64(); // of instructions
+        auto const constantCount = reader.u64();
+        auto const sourceCount   = reader.u64();
+        auto const targetCount   = reader.u64();
+        if (slotCount > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Invalid tape: too many slots.");
+        }
+        if (targetCount == 0) {
+            throw std::runtime_error("Invalid tape: no targets.");
+        }
+        auto function       = TapeFunction{};
+        function.mSlotCount = static_cast<std::uint32_t>(slotCount);
+
+        auto const* opcodes = reader.array<std::uint8_t>(count);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            if (opcodes[i] > static_cast<std::uint8_t>(Opcode::Square)) {
+                throw std::runtime_error("Invalid tape: unknown opcode.");
+            }
+        }
+        function.mInstructionCount = static_cast<std::size_t>(count);
+        function.mOpcodes = reinterpret_cast<Opcode const*>(opcodes);
+        function.mLhs     = reader.slots(count, slotCount);
+        function.mRhs     = reader.slots(count, slotCount);
+        function.mOut     = reader.slots(count, slotCount);
+
+        auto const* constantSlots  = reader.slots(constantCount, slotCount);
+        auto const* constantValues = reader.array<double>(constantCount);
+        for (std::uint64_t i = 0; i < constantCount; ++i) {
+            function.mConstants.emplace_back(
+                constantSlots[i], read<double>(constantValues + i));
+        }
+        auto const* sourceSlots  = reader.slots(sourceCount, slotCount);
+        auto const* sourceValues = reader.array<double>(sourceCount);
+        for (std::uint64_t i = 0; i < sourceCount; ++i) {
+            auto variable   = std::make_shared<Var const>(
+                read<double>(sourceValues + i));
+            auto const* key = static_cast<void const*>(variable->_node());
+            auto const slot = sourceSlots[i];
+            function.mSlots.emplace(key, slot);
+            function.mLeafSlots.emplace(key, slot);
+            function.mVariablesByKey.emplace(key, variable);
+            function.mLeaves.push_back({variable, slot});
+            function.mSources.push_back({std::move(variable), slot});
+        }
+        auto const* targetSlots = reader.slots(targetCount, slotCount);
+        for (std::uint64_t i = 0; i < targetCount; ++i) {
+            auto variable   = std::make_shared<Var const>(0.0);
+            auto const* key = static_cast<void const*>(variable->_node());
+            auto const slot = targetSlots[i];
+            function.mSlots.emplace(key, slot);
+            function.mVariablesByKey.emplace(key, variable);
+            function.mVariables.push_back({variable, slot});
+            function.mTargets.push_back({std::move(variable), slot});
+        }
+        function.mStorage = std::move(storage);
+        function.initValues();
+        function.evaluate();
+        return function;
+    }
+
+    // Saves the instructions, the constants, and the current values of the
+    // sources (see load).
+    void save(std::string const& path) const
+    {
+        checkByteOrder();
+        auto sourceSlots = std::unordered_set<std::uint32_t>{};
+        for (auto const& source : mSources) {
+            sourceSlots.insert(source.slot);
+        }
+        auto constants = mConstants;
+        for (auto const& leaf : mLeaves) {
+            if (sourceSlots.count(leaf.slot) == 0) { // literal variable
+                constants.emplace_back(leaf.slot, leaf.variable->value());
+            }
+        }
+        auto const count = mInstructionCount;
+        auto writer      = Writer{};
+        writer.put(magic);
+        for (auto const size : {std::size_t{mSlotCount}, count,
+                 constants.size(), mSources.size(), mTargets.size()}) {
+            writer.put(std::uint64_t{size});
+        }
+        writer.put(mOpcodes, count);
+        writer.put(mLhs, count);
+        writer.put(mRhs, count);
+        writer.put(mOut, count);
+        auto slots  = std::vector<std::uint32_t>{};
+        auto values = std::vector<double>{};
+        for (auto const& constant : constants) {
+            slots.push_back(constant.first);
+            values.push_back(constant.second);
+        }
+        writer.put(slots.data(), slots.size());
+        writer.put(values.data(), values.size());
+        slots.clear();
+        values.clear();
+        for (auto const& source : mSources) {
+            slots.push_back(source.slot);
+            values.push_back(source.variable->value());
+        }
+        writer.put(slots.data(), slots.size());
+        writer.put(values.data(), values.size());
+        slots.clear();
+        for (auto const& target : mTargets) {
+            slots.push_back(target.slot);
+        }
+        writer.put(slots.data(), slots.size());
+
+        auto const& bytes = writer.bytes();
+        auto file         = std::ofstream(path, std::ios::binary);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!file) {
+            throw std::runtime_error("Cannot write the tape to " + path + ".");
+        }
+    }
+
+    [[nodiscard]] auto sources() const
+        -> std::vector<std::shared_ptr<Var const>>
+    {
+        return variablesOf(mSources);
+    }
+
+    [[nodiscard]] auto targets() const
+        -> std::vector<std::shared_ptr<Var const>>
+    {
+        return variablesOf(mTargets);
+    }
+
+    [[nodiscard]] auto instructions() const -> std::size_t
+    {
+        return mInstructionCount;
+    }
+
+    [[nodiscard]] auto slots() const -> std::size_t { return mSlotCount; }
+
+    void evaluate()
+    {
+        for (auto const& leaf : mLeaves) {
+            mValues[leaf.slot] = leaf.variable->value();
+        }
+        auto* values      = mValues.data();
+        auto const* codes = mOpcodes;
+        auto const* lhs   = mLhs;
+        auto const* rhs   = mRhs;
+        auto const* out   = mOut;
+        for (std::size_t i = 0, n = mInstructionCount; i < n; ++i) {
+            auto const x = values[lhs[i]];
+            auto const y = values[rhs[i]];
+            auto& z      = values[out[i]];
+            switch (codes[i]) {
+            case Opcode::Add: z = x + y; break;
+            case Opcode::Sub: z = x - y; break;
+            case Opcode::Mul: z = x * y; break;
+            case Opcode::Div: z = x / y; break;
+            case Opcode::Pow: z = std::pow(x, y); break;
+            case Opcode::Neg: z = -x; break;
+            case Opcode::Cos: z = std::cos(x); break;
+            case Opcode::Exp: z = std::exp(x); break;
+            case Opcode::Log: z = std::log(x); break;
+            case Opcode::Log1p: z = std::log1p(x); break;
+            case Opcode::Max: z = x > 0 ? x : 0.0; break;
+            case Opcode::Min: z = x < 0 ? x : 0.0; break;
+            case Opcode::Sigmoid:
+                z = x >= 0 ? 1 / (1 + std::exp(-x))
+                           : std::exp(x) / (1 + std::exp(x));
+                break;
+            case Opcode::Sin: z = std::sin(x); break;
+            case Opcode::Sqrt: z = std::sqrt(x); break;
+            case Opcode::Square: z = x * x; break;
+            }
+        }
+        for (auto const& variable : mVariables) {
+            variable.variable->assign(mValues[variable.slot]);
+        }
+    }
+
+    // tangents of the sources are their derivatives
+    void pushTangent()
+    {
+        clearDerivatives();
+        for (auto const& leaf : mLeaves) {
+            mDerivatives[leaf.slot] = leaf.variable->derivative();
+        }
+        forward();
+    }
+
+    // the tangent of the seed source is one, the others are zero
+    void pushTangentAt(void const* seed)
+    {
+        auto const it = mLeafSlots.find(seed);
+        if (it == mLeafSlots.end()) {
+            throw std::invalid_argument("The seed must be a source.");
+        }
+        clearDerivatives();
+        mDerivatives[it->second] = 1.0;
+        forward();
+    }
+
+    // gradients of the targets are their derivatives
+    void pullGradient()
+    {
+        clearDerivatives();
+        for (auto const& target : mTargets) {
+            mDerivatives[target.slot] += target.variable->derivative();
+        }
+        reverse();
+    }
+
+    // the gradient of the seed variable is one
+    void pullGradientAt(void const* seed)
+    {
+        auto const it = mVariablesByKey.find(seed);
+        if (it == mVariablesByKey.end()) {
+            throw std::invalid_argument("The seed must be a variable.");
+        }
+        clearDerivatives();
+        mDerivatives[mSlots.at(seed)] = 1.0;
+        reverse();
+    }
+
+    // Hessian-vector product H·v of the seed variable, with the tangents v of
+    // the sources by key (zero if missing), stored in their derivatives.
+    // Forward-over-reverse: the reverse sweep also carries the tangents of
+    // the gradients, which are exact (no finite differences).
+    void hvp(void const* seed,
+        std::unordered_map<void const*, double> const& directions)
+    {
+        if (mVariablesByKey.count(seed) == 0) {
+            throw std::invalid_argument("The seed must be a variable.");
+        }
+        for (auto const& direction : directions) {
+            if (mLeafSlots.count(direction.first) == 0) {
+                throw std::invalid_argument(
+                    "The directions must be given for sources.");
+            }
+        }
+        clearDerivatives();
+        for (auto const& direction : directions) {
+            mDerivatives[mLeafSlots.at(direction.first)] = direction.second;
+        }
+        forward(false);
+        mTangents.swap(mDerivatives);
+        mDerivatives.assign(mSlotCount, 0.0);
+        mProducts.assign(mSlotCount, 0.0);
+        mDerivatives[mSlots.at(seed)] = 1.0;
+        reverseTangents();
+        for (auto const& leaf : mLeaves) {
+            leaf.variable->setDerivative(mProducts[leaf.slot]);
+        }
+    }
+
+private:
+    struct VariableSlot {
+        std::shared_ptr<Var const> variable;
+        std::uint32_t slot;
+    };
+
+    // instructions lowered from a tape
+    struct Instructions {
+        std::vector<Opcode> opcodes;
+        std::vector<std::uint32_t> lhs;
+        std::vector<std::uint32_t> rhs;
+        std::vector<std::uint32_t> out;
+    };
+
+    static constexpr auto magic     = std::string_view{"ADTAPE02"};
+    static constexpr auto alignment = std::size_t{64};
+
+    // appends integers and arrays in the byte order of the machine, which
+    // is checked to be little-endian
+    class Writer {
+    public:
+        void put(std::string_view bytes) { mBytes.append(bytes); }
+
+        void put(std::uint64_t value)
+        {
+            put(std::string_view(
+                reinterpret_cast<char const*>(&value), sizeof value));
+        }
+
+        template <typename T>
+        void put(T const* data, std::size_t count)
+        {
+            mBytes.resize(
+                (mBytes.size() + alignment - 1) / alignment * alignment, '\0');
+            put(std::string_view(
+                reinterpret_cast<char const*>(data), count * sizeof(T)));
+        }
+
+        [[nodiscard]] auto bytes() const -> std::string const&
+        {
+            return mBytes;
+        }
+
+    private:
+        std::string mBytes;
+    };
+
+    // reads the integers and arrays of a Writer, checking their bounds
+    class Reader {
+    public:
+        Reader(char const* data, std::size_t size)
+            : mData{data}
+            , mSize{size}
+        {
+        }
+
+        auto take(std::uint64_t size) -> char const*
+        {
+            if (size > mSize - mOffset) {
+                throw std::runtime_error(
+                    "Invalid tape: unexpected end of file.");
+            }
+            auto const* bytes = mData + mOffset;
+            mOffset += static_cast<std::size_t>(size);
+            return bytes;
+        }
+
+        auto u64() -> std::uint64_t { return read<std::uint64_t>(take(8)); }
+
+        // aligned in the buffer
+        template <typename T>
+        auto array(std::uint64_t count) -> T const*
+        {
+            mOffset = std::min(
+                (mOffset + alignment - 1) / alignment * alignment, mSize);
+            if (count > (mSize - mOffset) / sizeof(T)) {
+                throw std::runtime_error(
+                    "Invalid tape: unexpected end of file.");
+            }
+            auto const* bytes = take(count * sizeof(T));
+            if (reinterpret_cast<std::uintptr_t>(bytes) % alignof(T) != 0) {
+                throw std::runtime_error("Invalid tape: misaligned buffer.");
+            }
+            return reinterpret_cast<T const*>(bytes);
+        }
+
+        // slots smaller than the given count
+        auto slots(std::uint64_t count, std::uint64_t slotCount)
+            -> std::uint32_t const*
+        {
+            auto const* slots = array<std::uint32_t>(count);
+            for (std::uint64_t i = 0; i < count; ++i) {
+                if (slots[i] >= slotCount) {
+                    throw std::runtime_error(
+                        "Invalid tape: slot out of range.");
+                }
+            }
+            return slots;
+        }
+
+    private:
+        char const* mData;
+        std::size_t mSize;
+        std::size_t mOffset = 0;
+    };
+
+    TapeFunction() = default; // see load
+
+    template <typename T>
+    static auto read(void const* bytes) -> T
+    {
+        auto value = T{};
+        std::memcpy(&value, bytes, sizeof value);
+        return value;
+    }
+
+    static void checkByteOrder()
+    {
+        auto const one = std::uint16_t{1};
+        if (read<std::uint8_t>(&one) != 1) {
+            throw std::runtime_error(
+                "Tapes are only supported on little-endian machines.");
+        }
+    }
+
+    static auto variablesOf(std::vector<VariableSlot> const& slots)
+        -> std::vector<std::shared_ptr<Var const>>
+    {
+        auto variables = std::vector<std::shared_ptr<Var const>>{};
+        for (auto const& slot : slots) {
+            variables.push_back(slot.variable);
+        }
+        return variables;
+    }
+
+    void initValues()
+    {
+        mValues.resize(mSlotCount);
+        mDerivatives.resize(mSlotCount);
+        for (auto const& constant : mConstants) {
+            mValues[constant.first] = constant.second;
+        }
+    }
+
+    void clearDerivatives()
+    {
+        std::fill(mDerivatives.begin(), mDerivatives.end(), 0.0);
+    }
+
+    // writes the derivatives of the slots to the variables
+    void storeDerivatives() const
+    {
+        for (auto const& leaf : mLeaves) {
+            leaf.variable->setDerivative(mDerivatives[leaf.slot]);
+        }
+        for (auto const& variable : mVariables) {
+            variable.variable->setDerivative(mDerivatives[variable.slot]);
+        }
+    }
+
+    void forward(bool store = true)
+    {
+        auto const* values = mValues.data();
+        auto* tangents     = mDerivatives.data();
+        auto const* codes  = mOpcodes;
+        auto const* lhs    = mLhs;
+        auto const* rhs    = mRhs;
+        auto const* out    = mOut;
+        for (std::size_t i = 0, n = mInstructionCount; i < n; ++i) {
+            auto const x  = values[lhs[i]];
+            auto const y  = values[rhs[i]];
+            auto const z  = values[out[i]];
+            auto const dx = tangents[lhs[i]];
+            auto const dy = tangents[rhs[i]];
+            tangents[out[i]]
+                = detail::scalarTangent(codes[i], x, y, z, dx, dy);
+        }
+        if (store) {
+            storeDerivatives();
+        }
+    }
+
+    void reverse()
+    {
+        auto const* values = mValues.data();
+        auto* gradients    = mDerivatives.data();
+        auto const* codes  = mOpcodes;
+        auto const* lhs    = mLhs;
+        auto const* rhs    = mRhs;
+        auto const* out    = mOut;
+        for (auto i = mInstructionCount; i-- > 0;) {
+            auto const x = values[lhs[i]];
+            auto const y = values[rhs[i]];
+            auto const z = values[out[i]];
+            auto const g = gradients[out[i]];
+            auto& gx     = gradients[lhs[i]];
+            auto& gy     = gradients[rhs[i]]; // same as gx if unary
+            switch (codes[i]) {
+            case Opcode::Add: gx += g; gy += g; break;
+            case Opcode::Sub: gx += g; gy -= g; break;
+            case Opcode::Mul: gx += g * y; gy += g * x; break;
+            case Opcode::Div: gx += g / y; gy -= g * z / y; break;
+            case Opcode::Pow:
+                gx += g * y * std::pow(x, y - 1);
+                gy += g * z * std::log(x);
+                break;
+            case Opcode::Neg: gx -= g; break;
+            case Opcode::Cos: gx -= g * std::sin(x); break;
+            case Opcode::Exp: gx += g * z; break;
+            case Opcode::Log: gx += g / x; break;
+            case Opcode::Log1p: gx += g / (1 + x); break;
+            case Opcode::Max: gx += x > 0 ? g : 0.0; break;
+            case Opcode::Min: gx += x < 0 ? g : 0.0; break;
+            case Opcode::Sigmoid: gx += g * z * (1 - z); break;
+            case Opcode::Sin: gx += g * std::cos(x); break;
+            case Opcode::Sqrt: gx += g / (2 * z); break;
+            case Opcode::Square: gx += 2 * x * g; break;
+            }
+        }
+        storeDerivatives();
+    }
+
+    // Reverse sweep of the gradients g and of their tangents ġ (the products),
+    // given the tangents t of the forward sweep. With the partials p of an
+    // instruction, gx += g px and ġx += ġ px + g ṗx, where ṗx is the tangent
+    // of px (the same for y).
+    void reverseTangents()
+    {
+        auto const* values   = mValues.data();
+        auto const* tangents = mTangents.data();
+        auto* gradients      = mDerivatives.data();
+        auto* products       = mProducts.data();
+        auto const* codes    = mOpcodes;
+        auto const* lhs      = mLhs;
+        auto const* rhs      = mRhs;
+        auto const* out      = mOut;
+        for (auto i = mInstructionCount; i-- > 0;) {
+            auto const x  = values[lhs[i]];
+            auto const y  = values[rhs[i]];
+            auto const z  = values[out[i]];
+            auto const dx = tangents[lhs[i]];
+            auto const dy = tangents[rhs[i]];
+            auto const dz = tangents[out[i]];
+            // partials and their tangents, zero for y if unary
+            auto const [px, py, dpx, dpy]
+                = detail::scalarPartials(codes[i], x, y, z, dx, dy, dz);
+            auto const g  = gradients[out[i]];
+            auto const dg = products[out[i]];
+            // the same slots as x if unary, with zero partials for y
+            gradients[lhs[i]] += g * px;
+            gradients[rhs[i]] += g * py;
+            products[lhs[i]] += dg * px + g * dpx;
+            products[rhs[i]] += dg * py + g * dpy;
+        }
+    }
+
+    static auto toVar(std::shared_ptr<AbstractVariable const> const& variable)
+        -> std::shared_ptr<Var const>
+    {
+        auto scalar = std::dynamic_pointer_cast<Var const>(variable);
+        if (!scalar) {
+            throw std::invalid_argument("Only scalar variables are supported.");
+        }
+        return scalar;
+    }
+
+    auto newSlot() -> std::uint32_t { return mSlotCount++; }
+
+    auto lowerVariable(Tape::VariableRecord const& record, bool leaf)
+        -> std::uint32_t
+    {
+        auto variable   = toVar(record.variable);
+        auto const* key = static_cast<void const*>(variable->_node());
+        if (leaf || record.expression == nullptr) {
+            auto const slot = newSlot();
+            mLeafSlots.emplace(key, slot);
+            mVariablesByKey.emplace(key, variable);
+            mLeaves.push_back({std::move(variable), slot});
+            return slot;
+        }
+        // the variable shares the slot of its expression
+        auto const slot = mSlots.at(record.expression);
+        mVariablesByKey.emplace(key, variable);
+        mVariables.push_back({std::move(variable), slot});
+        return slot;
+    }
+
+    auto lowerCall(Tape::Call const& call, Instructions& code) -> std::uint32_t
+    {
+        auto swapped      = false; // reflected method, e.g. __radd__
+        auto const opcode = opcodeOf(call, swapped);
+        auto operands = std::vector<std::uint32_t>{};
+        for (auto const& operand : call.operands) {
+            if (operand.expression != nullptr) {
+                operands.push_back(mSlots.at(operand.expression));
+            } else {
+                auto const slot = newSlot();
+                mConstants.emplace_back(slot, operand.literal.cast<double>());
+                operands.push_back(slot);
+            }
+        }
+        if (swapped) {
+            std::swap(operands.at(0), operands.at(1));
+        }
+        auto const slot = newSlot();
+        code.opcodes.push_back(opcode);
+        code.lhs.push_back(operands.at(0));
+        code.rhs.push_back(operands.size() > 1 ? operands[1] : operands[0]);
+        code.out.push_back(slot);
+        return slot;
+    }
+
+    static auto opcodeOf(Tape::Call const& call, bool& swapped) -> Opcode
+    {
+        auto opcode = Opcode::Add;
+        if (!parse(call.name, opcode, swapped)) {
+            throw std::invalid_argument(
+                "Unsupported operation '" + call.name + "'.");
+        }
+        return opcode;
+    }
+
+    static auto parse(std::string const& name, Opcode& opcode, bool& swapped)
+        -> bool
+    {
+        return detail::parseScalarOpcode(name, opcode, swapped);
+    }
+
+    // instructions (struct of arrays) in the storage, lowered or mapped
+    std::shared_ptr<void const> mStorage;
+    std::size_t mInstructionCount = 0;
+    Opcode const* mOpcodes        = nullptr;
+    std::uint32_t const* mLhs     = nullptr; // operand slots
+    std::uint32_t const* mRhs     = nullptr; // same as mLhs if unary
+    std::uint32_t const* mOut     = nullptr; // result slots
+
+    std::uint32_t mSlotCount = 0;
+    std::vector<double> mValues;      // of the slots
+    std::vector<double> mDerivatives; // tangents or gradients of the slots
+    std::vector<double> mTangents;    // of the forward sweep of hvp
+    std::vector<double> mProducts;    // tangents of the gradients of hvp
+    std::vector<std::pair<std::uint32_t, double>> mConstants; // literals
+
+    std::vector<VariableSlot> mLeaves;    // values read by evaluate
+    std::vector<VariableSlot> mVariables; // with expressions, written back
+    std::vector<VariableSlot> mSources;   // as given, a subset of mLeaves
+    std::vector<VariableSlot> mTargets;   // seeds of pullGradient
+
+    // by key (the node of a variable or the evaluator of an operation)
+    std::unordered_map<void const*, std::uint32_t> mSlots;
+    std::unordered_map<void const*, std::uint32_t> mLeafSlots;
+    std::unordered_map<void const*, std::shared_ptr<Var const>>
+        mVariablesByKey;
+};
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_TAPE_FUNCTION_HPP
@@ -0,0 +1,118 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#ifndef AUTODIFF_PYTHON_THREAD_POOL_HPP
+#define AUTODIFF_PYTHON_THREAD_POOL_HPP
+
+#include <algorithm> // max
+#include <condition_variable>
+#include <cstddef> // size_t
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility> // move
+#include <vector>
+
+namespace AutoDiff::Python {
+
+// Fixed number of worker threads executing tasks from a shared queue
+class ThreadPool {
+public:
+    // zero threads means one per hardware thread
+    explicit ThreadPool(std::size_t threads = 0)
+    {
+        if (threads == 0) {
+            threads = std::max(1U, std::thread::hardware_concurrency());
+        }
+        mWorkers.reserve(threads);
+        for (auto i = std::size_t{0}; i < threads; ++i) {
+            mWorkers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            auto const lock = std::lock_guard{mMutex};
+            mStopping       = true;
+        }
+        mCondition.notify_all();
+        for (auto& worker : mWorkers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(ThreadPool const&)                    = delete;
+    ThreadPool(ThreadPool&&)                         = delete;
+    auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+    auto operator=(ThreadPool&&) -> ThreadPool&      = delete;
+
+    [[nodiscard]] auto size() const -> std::size_t { return mWorkers.size(); }
+
+    // The future rethrows any exception thrown by the task.
+    template <typename Task>
+    auto submit(Task task) -> std::future<void>
+    {
+        auto packaged
+            = std::make_shared<std::packaged_task<void()>>(std::move(task));
+        auto future = packaged->get_future();
+        {
+            auto const lock = std::lock_guard{mMutex};
+            mTasks.emplace([packaged] { (*packaged)(); });
+        }
+        mCondition.notify_one();
+        return future;
+    }
+
+    // Runs task(i) for all i in [0, count) and waits for all of them.
+    // Rethrows the first exception after all tasks have finished.
+    template <typename Task>
+    void parallelFor(std::size_t count, Task const& task)
+    {
+        auto futures = std::vector<std::future<void>>{};
+        futures.reserve(count);
+        for (auto i = std::size_t{0}; i < count; ++i) {
+            futures.push_back(submit([&task, i] { task(i); }));
+        }
+        for (auto& future : futures) {
+            future.wait();
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+
+private:
+    void work()
+    {
+        while (true) {
+            auto task = std::function<void()>{};
+            {
+                auto lock = std::unique_lock{mMutex};
+                mCondition.wait(
+                    lock, [this] { return mStopping || !mTasks.empty(); });
+                if (mTasks.empty()) {
+                    return; // stopping
+                }
+                task = std::move(mTasks.front());
+                mTasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> mWorkers;
+    std::queue<std::function<void()>> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStopping = false;
+};
+
+} // namespace AutoDiff::Python
+
+#endif // AUTODIFF_PYTHON_THREAD_POOL_HPP
@@ -6,24 +6,116 @@
 #ifndef AUTODIFF_PYTHON_VARIABLE_HPP
 #define AUTODIFF_PYTHON_VARIABLE_HPP
 
+#include "AbstractVariable.hpp"
+#include "Arena.hpp"
 #include "Expression.hpp"
 
 #include <AutoDiff/src/Core/Variable.hpp> // Variable, d
+#include <Eigen/Core>
+#include <pybind11/numpy.h>
 
-#include <utility> // move
+#include <algorithm>   // copy, max, min
+#include <atomic>
+#include <cstddef>     // size_t
+#include <memory>      // shared_ptr
+#include <stdexcept>   // invalid_argument, runtime_error
+#include <type_traits> // enable_if_t, is_arithmetic_v, is_same_v, void_t
+#include <utility>     // exchange, move
+#include <vector>
 
 namespace AutoDiff::Python {
 
+namespace detail {
+
+template <typename Value, typename = void>
+struct ScalarType {
+    using type = Value;
+};
+
+template <typename Value>
+struct ScalarType<Value, std::void_t<typename Value::Scalar>> {
+    using type = typename Value::Scalar;
+};
+
+template <typename Value, typename = void>
+struct IsVector : std::false_type { };
+
+template <typename Value>
+struct IsVector<Value, std::enable_if_t<Value::ColsAtCompileTime == 1>>
+    : std::true_type { };
+
+// 1D Eigen arrays (lanes) with derivatives of the same type
+template <typename Value, typename Derivative, typename = void>
+struct IsLanes : std::false_type { };
+
+template <typename Value, typename Derivative>
+struct IsLanes<Value, Derivative,
+    std::enable_if_t<std::is_same_v<Value, Derivative>>>
+    : std::conjunction<std::is_base_of<Eigen::ArrayBase<Value>, Value>,
+          IsVector<Value>> { };
+
+// Eigen types of fixed size, stored inline (without heap allocation)
+template <typename Value, typename = void>
+struct IsFixed : std::false_type { };
+
+template <typename Value>
+struct IsFixed<Value, std::enable_if_t<(Value::SizeAtCompileTime > 0)>>
+    : std::true_type { };
+
+// default value of variables (fixed-size Eigen types are left uninitialized)
+template <typename Value>
+auto defaultValue() -> Value
+{
+    if constexpr (IsFixed<Value>::value) {
+        return Value::Zero();
+    } else {
+        return Value{};
+    }
+}
+
+} // namespace detail
+
+// Records the variables and operations of expressions transferred to
+// variables on this thread while in scope (see Variable::set)
+class OperandScope {
+public:
+    explicit OperandScope(detail::Operands* operands)
+        : mPrevious{std::exchange(detail::threadState().operands, operands)}
+    {
+    }
+
+    ~OperandScope() { detail::threadState().operands = mPrevious; }
+
+    OperandScope(OperandScope const&)                    = delete;
+    OperandScope(OperandScope&&)                         = delete;
+    auto operator=(OperandScope const&) -> OperandScope& = delete;
+    auto operator=(OperandScope&&) -> OperandScope&      = delete;
+
+private:
+    detail::Operands* mPrevious;
+};
+
 template <typename Value, typename Derivative>
 class Variable : public AbstractVariable, public Expression<Value, Derivative> {
 public:
+    using Scalar = typename detail::ScalarType<Value>::type;
+
+    // vectors are 1D arrays, matrices are 2D arrays
+    static constexpr auto isScalar = std::is_arithmetic_v<Value>;
+    static constexpr auto isVector = detail::IsVector<Value>::value;
+    // lanes derivatives are element-wise, like the values
+    static constexpr auto isLanes = detail::IsLanes<Value, Derivative>::value;
+    // fixed-size values cannot be resized
+    static constexpr auto isFixed = detail::IsFixed<Value>::value;
+
     explicit Variable(Value value)
         : mVariable{std::move(value)}
     {
     }
 
-    explicit Variable(AutoDiff::Variable<Value, Derivative> variable)
-        : mVariable{std::move(variable)}
+    // evaluates the expression (eager evaluation)
+    explicit Variable(Expression<Value, Derivative> const& expression)
+        : mVariable{transfer(expression, *mStatus)}
     {
     }
 
@@ -36,11 +128,43 @@ public:
 
     [[nodiscard]] auto value() const -> Value const& { return mVariable(); }
 
-    void set(Value value) const { mVariable = std::move(value); }
+    void set(Value value) const
+    {
+        checkUnlocked();
+        mVariable = std::move(value);
+        if (mStatus->hasExpression) { // removed
+            mStatus->hasExpression = false;
+            mStatus->operands.reset();
+            mStatus->structure = 0;
+            ++detail::state().graphVersion;
+        }
+        _touch();
+    }
+
+    // overwrite the value in place, reusing its storage (keeps expression)
+    template <typename Other>
+    void assign(Other const& value) const
+    {
+        checkUnlocked();
+        const_cast<Value&>(mVariable()) = value;
+        _touch();
+    }
 
     void set(Expression<Value, Derivative> const& expression) const
     {
-        mVariable.setExpression(expression.wrapper());
+        checkUnlocked();
+        auto operands = detail::Operands{};
+        auto wrapper  = expression.wrapper();
+        operands.root = rootOf(wrapper);
+        {
+            auto const scope = OperandScope{&operands};
+            mVariable.setExpression(std::move(wrapper));
+        }
+        mStatus->structure     = detail::structureOf(operands.variables);
+        mStatus->operands      = std::move(operands);
+        mStatus->hasExpression = true;
+        ++detail::state().graphVersion;
+        _touch();
     }
 
     [[nodiscard]] auto derivative() const -> Derivative const&
@@ -50,7 +174,9 @@ public:
 
     void setDerivative(Derivative derivative) const
     {
+        checkUnlocked();
         mVariable.setDerivative(std::move(derivative));
+        mStatus->derivativeModified = ++detail::state().valueVersion;
     }
 
     [[nodiscard]] auto _node() const -> internal::AbstractComputation* override
@@ -58,13 +184,220 @@ public:
         return mVariable._node();
     }
 
+    [[nodiscard]] auto _dtype() const -> pybind11::dtype override
+    {
+        return pybind11::dtype::of<Scalar>();
+    }
+
+    [[nodiscard]] auto
+    _shape() const -> std::vector<pybind11::ssize_t> override
+    {
+        if constexpr (isScalar) {
+            return {};
+        } else if constexpr (isVector) {
+            return {value().rows()};
+        } else {
+            return {value().rows(), value().cols()};
+        }
+    }
+
+    void _assign(
+        pybind11::array const& batch, pybind11::ssize_t index) const override
+    {
+        checkUnlocked();
+        auto const* data = static_cast<Scalar const*>(batch.data(index));
+        auto& value      = const_cast<Value&>(mVariable()); // in place
+        if constexpr (isScalar) {
+            value = *data;
+        } else if constexpr (isVector) {
+            resize(value, batch.shape(1), 1);
+            std::copy(data, data + value.size(), value.data());
+        } else { // row-major
+            resize(value, batch.shape(1), batch.shape(2));
+            for (pybind11::ssize_t row = 0; row < value.rows(); ++row) {
+                for (pybind11::ssize_t col = 0; col < value.cols(); ++col) {
+                    value(row, col) = *data++;
+                }
+            }
+        }
+        _touch();
+    }
+
+    void _copyTo(
+        pybind11::array& batch, pybind11::ssize_t index) const override
+    {
+        auto* data = static_cast<Scalar*>(batch.mutable_data(index));
+        if constexpr (isScalar) {
+            *data = value();
+        } else if constexpr (isVector) {
+            std::copy(value().data(), value().data() + value().size(), data);
+        } else { // row-major
+            auto const& value = this->value();
+            for (pybind11::ssize_t row = 0; row < value.rows(); ++row) {
+                for (pybind11::ssize_t col = 0; col < value.cols(); ++col) {
+                    *data++ = value(row, col);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] auto _valueBytes() const -> std::size_t override
+    {
+        return detail::bytesOf(value());
+    }
+
+    [[nodiscard]] auto _derivativeBytes() const -> std::size_t override
+    {
+        return detail::bytesOf(derivative());
+    }
+
+    [[nodiscard]] auto _modified() const -> std::size_t override
+    {
+        return mStatus->modified;
+    }
+
+    void _touch() const override
+    {
+        mStatus->modified = ++detail::state().valueVersion;
+    }
+
+    [[nodiscard]] auto _status() const
+        -> std::shared_ptr<detail::VariableStatus> const& override
+    {
+        return mStatus;
+    }
+
+    void _setDirection(
+        pybind11::array const& direction, bool tangent) const override
+    {
+        auto const* data = static_cast<Scalar const*>(direction.data());
+        if constexpr (std::is_arithmetic_v<Derivative>) {
+            setDerivative(*data);
+        } else if constexpr (isLanes) {
+            auto derivative = Derivative(direction.shape(0));
+            std::copy(data, data + derivative.size(), derivative.data());
+            setDerivative(std::move(derivative));
+        } else if constexpr (isScalar || isVector) {
+            auto const size = isScalar ? 1 : direction.shape(0);
+            auto derivative
+                = tangent ? Derivative(size, 1) : Derivative(1, size);
+            std::copy(data, data + size, derivative.data());
+            setDerivative(std::move(derivative));
+        } else { // row-major to column-major
+            auto const rows = direction.shape(0);
+            auto const cols = direction.shape(1);
+            auto derivative = tangent ? Derivative(rows * cols, 1)
+                                      : Derivative(1, rows * cols);
+            auto* flat      = derivative.data();
+            for (pybind11::ssize_t row = 0; row < rows; ++row) {
+                for (pybind11::ssize_t col = 0; col < cols; ++col) {
+                    flat[col * rows + row] = *data++;
+                }
+            }
+            setDerivative(std::move(derivative));
+        }
+    }
+
+    auto _setSeed(pybind11::ssize_t offset, pybind11::ssize_t count,
+        bool tangent) const -> bool override
+    {
+        if constexpr (std::is_arithmetic_v<Derivative> || isLanes) {
+            return false;
+        } else {
+            auto size = pybind11::ssize_t{1};
+            if constexpr (!isScalar) {
+                size = value().size();
+            }
+            auto derivative
+                = tangent ? Derivative(size, count) : Derivative(count, size);
+            derivative.setZero();
+            auto const first = std::max(pybind11::ssize_t{0}, -offset);
+            auto const last  = std::min(size, count - offset);
+            for (auto i = first; i < last; ++i) {
+                if (tangent) {
+                    derivative(i, offset + i) = 1;
+                } else {
+                    derivative(offset + i, i) = 1;
+                }
+            }
+            setDerivative(std::move(derivative));
+            return true;
+        }
+    }
+
+    // not checked for locks, since called by the sweeps holding them
+    void _seed(
+        bool identity, pybind11::ssize_t count, bool tangent) const override
+    {
+        detail::seedDerivative(mVariable, identity, count, tangent);
+    }
+
     [[nodiscard]] auto
     wrapper() const -> ExpressionWrapper<Value, Derivative> override
     {
-        return ExpressionWrapper<Value, Derivative>(mVariable);
+        // reads of the variable are recorded for incremental functions
+        using Reader   = Evaluator<AutoDiff::Variable<Value, Derivative>>;
+        using Abstract = AbstractEvaluator<Value, Derivative>;
+        return ExpressionWrapper<Value, Derivative>(std::shared_ptr<Abstract>{
+            detail::makeShared<Reader>(mVariable, mStatus)});
+    }
+
+    [[nodiscard]] auto _key() const -> void const* override
+    {
+        return mVariable._node();
     }
 
 private:
+    // Variable with the expression, recording its variables and operations
+    // when the expression transfers them as children of the variable's node
+    static auto transfer(Expression<Value, Derivative> const& expression,
+        detail::VariableStatus& status) -> AutoDiff::Variable<Value, Derivative>
+    {
+        auto operands    = detail::Operands{};
+        auto wrapper     = expression.wrapper();
+        operands.root    = rootOf(wrapper);
+        auto const scope = OperandScope{&operands};
+        auto variable    = var(std::move(wrapper));
+        status.structure     = detail::structureOf(operands.variables);
+        status.operands      = std::move(operands);
+        status.hasExpression = true;
+        return variable;
+    }
+
+    // the expression in the second-order sweeps (see Function::hvp)
+    static auto rootOf(ExpressionWrapper<Value, Derivative> const& wrapper)
+        -> std::shared_ptr<detail::SecondOrderRoot>
+    {
+        return std::make_shared<detail::ExpressionRoot<Value, Derivative>>(
+            wrapper.evaluator());
+    }
+
+    void checkUnlocked() const
+    {
+        if (mStatus->locks.load() != 0) {
+            throw std::runtime_error("The variable is locked by an "
+                                     "asynchronous sweep; wait for its future.");
+        }
+    }
+
+    static void resize(
+        Value& value, pybind11::ssize_t rows, pybind11::ssize_t cols)
+    {
+        if constexpr (isFixed) {
+            if (rows != value.rows() || cols != value.cols()) {
+                throw std::invalid_argument("The shape of the array does not "
+                                            "match the fixed size of the "
+                                            "variable.");
+            }
+        } else {
+            value.resize(rows, cols);
+        }
+    }
+
+    // shared by all copies, like the variable itself
+    // (initialized first, since transfer records into it)
+    std::shared_ptr<detail::VariableStatus> mStatus
+        = detail::makeShared<detail::VariableStatus>();
     AutoDiff::Variable<Value, Derivative> mVariable;
 };
 
@@ -0,0 +1,65 @@
+// Copyright (c) 2024 Matthias Krippner
+//
+// This software is released under the MIT License.
+// https://opensource.org/licenses/MIT
+
+#include "common.hpp"
+
+#include <AutoDiff/Eigen>
+#include <AutoDiff/Python/BufferPool.hpp>
+#include <AutoDiff/Python/Cwise.hpp>
+#include <AutoDiff/Python/ExpressionBinding.hpp>
+#include <AutoDiff/Python/Lanes.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+
+using AutoDiff::Python::Lanes;
+
+PYBIND11_MODULE(MODULE_NAME, module)
+{
+    module.attr("__version__") = VERSION_INFO;
+    // the module docstring is added directly to `src-python/autodiff/lanes.py`
+
+    importCore(module); // must be called before ExpressionBinding
+
+    // values and derivatives are both lanes
+    using Binding = AutoDiff::Python::ExpressionBinding<Lanes, Lanes>;
+    auto binding  = Binding(module, "Lanes");
+
+    // maps NumPy arrays of any memory layout without copying
+    using Stride = Eigen::InnerStride<Eigen::Dynamic>;
+    binding.defAssign<Eigen::Ref<Lanes const, 0, Stride>>();
+
+    // lane-lane and lane-scalar operations
+
+    AUTODIFF_PYTHON_DEF_LANE_INFIX_OP(binding, "add", Add, Add, "")
+    AUTODIFF_PYTHON_DEF_LANE_INFIX_OP(binding, "sub", Sub, Sub, "")
+    AUTODIFF_PYTHON_DEF_LANE_INFIX_OP(binding, "mul", Mul, Mul, "")
+    AUTODIFF_PYTHON_DEF_LANE_INFIX_OP(binding, "truediv", Div, Div, "")
+    AUTODIFF_PYTHON_DEF_LANE_INFIX_OP(binding, "pow", Pow, Pow, "")
+
+    // scalar-lane operations
+
+    AUTODIFF_PYTHON_DEF_LANE_R_INFIX_OP(binding, "add", Add, "")
+    AUTODIFF_PYTHON_DEF_LANE_R_INFIX_OP(binding, "sub", RSub, "")
+    AUTODIFF_PYTHON_DEF_LANE_R_INFIX_OP(binding, "mul", Mul, "")
+    AUTODIFF_PYTHON_DEF_LANE_R_INFIX_OP(binding, "truediv", RDiv, "")
+    AUTODIFF_PYTHON_DEF_LANE_R_INFIX_OP(binding, "pow", RPow, "")
+
+    AUTODIFF_PYTHON_DEF_CWISE_METHOD(binding, "neg", Neg, "")
+
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "cos", Cos, "")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "exp", Exp, "")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "log", Log, "")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "log1p", Log1p, "")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "maximum", Max, "")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "minimum", Min, "")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "sigmoid", Sigmoid, "")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "sin", Sin, "")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "sqrt", Sqrt, "")
+    AUTODIFF_PYTHON_DEF_CWISE_OP(Binding, module, "square", Square, "")
+
+    // see `autodiff.clear_buffer_pools`
+    module.def(
+        "_clear_buffer_pools", &AutoDiff::Python::detail::clearBufferPools);
+}
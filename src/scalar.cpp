@@ -7,14 +7,295 @@
 
 #include <AutoDiff/Basic>
 #include <AutoDiff/Python/ExpressionBinding.hpp>
+#include <AutoDiff/Python/Function.hpp>
+#include <AutoDiff/Python/ScalarFunction.hpp>
+#include <AutoDiff/Python/TapeFunction.hpp>
 #include <pybind11/pybind11.h>
 
+#include <memory> // shared_ptr
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using AutoDiff::Python::AbstractVariable;
+using AutoDiff::Python::TapeFunction;
+
+// keys of the variables on a tape
+auto keysOf(pybind11::tuple const& variables) -> std::vector<void const*>
+{
+    auto keys = std::vector<void const*>{};
+    for (auto const& variable : variables) {
+        keys.push_back(variable.cast<AbstractVariable const&>()._node());
+    }
+    return keys;
+}
+
+// Python variables of the variables of a function
+auto toTuple(std::vector<std::shared_ptr<TapeFunction::Var const>> const&
+        variables) -> pybind11::tuple
+{
+    auto tuple = pybind11::tuple(variables.size());
+    for (auto i = std::size_t{0}; i < variables.size(); ++i) {
+        tuple[i] = pybind11::cast(TapeFunction::Var{*variables[i]});
+    }
+    return tuple;
+}
+
+// Maps a file saved by TapeFunction::save into memory (read-only) and runs
+// the function on the mapped instructions
+auto loadTapeFunction(std::string const& path) -> TapeFunction
+{
+    namespace py = pybind11;
+
+    // the mapping and its exported buffer, released with the GIL held
+    struct Mapping {
+        py::object mmap;
+        py::buffer_info buffer;
+    };
+
+    auto const mmap = py::module_::import("mmap");
+    auto const file = py::module_::import("io").attr("open")(path, "rb");
+    auto mapped     = py::object{};
+    try {
+        mapped = mmap.attr("mmap")(file.attr("fileno")(), 0,
+            py::arg("access") = mmap.attr("ACCESS_READ"));
+    } catch (...) {
+        file.attr("close")();
+        throw;
+    }
+    file.attr("close")(); // the mapping stays valid
+
+    auto* mapping   = new Mapping{mapped, py::buffer(mapped).request()};
+    auto const data = static_cast<char const*>(mapping->buffer.ptr);
+    auto const size = static_cast<std::size_t>(mapping->buffer.size);
+
+    auto const release = [mapping](void const* /*data*/) {
+        py::gil_scoped_acquire const gil;
+        delete mapping;
+    };
+    return TapeFunction::load(
+        std::shared_ptr<void const>(data, release), data, size);
+}
+
+void defTapeFunction(pybind11::module& module)
+{
+    auto tapeFunction = pybind11::class_<TapeFunction>(
+        module, "TapeFunction", pybind11::module_local());
+
+    tapeFunction.doc() = R"doc(A function lowered to a flat tape of scalar instructions.
+
+Alternative execution engine for the graph of a `Function` recorded on a
+`Tape`.
+Instead of calling a virtual method for each node of a tree of expression
+objects, the sweeps run as tight loops over contiguous arrays of opcodes,
+operand slots, and values, which is much faster for large graphs.
+
+The values of the sources (and other literal variables) are read from
+their variables at the start of `evaluate`.
+After each sweep, the values or derivatives are written back to all
+variables of the graph, as with `Function`.
+
+Examples
+--------
+>>> with Tape() as tape:
+...     x = var(0.5)
+...     y = x
+...     for _ in range(10_000):
+...         y = var(sin(y) * 0.5 + y)
+
+>>> f = TapeFunction(tape, Function(y, sources=(x,)))
+
+>>> f.evaluate()
+
+>>> f.pull_gradient_at(y)  # d(x) is the derivative of y
+
+Note
+----
+The graph is lowered once; after changing its expressions (e.g., with
+`set`), create a new `TapeFunction`.)doc";
+
+    tapeFunction.def(
+        pybind11::init([](AutoDiff::Python::Tape const& tape,
+                           AutoDiff::Python::Function const& function) {
+            return TapeFunction(
+                tape, keysOf(function.sources()), keysOf(function.targets()));
+        }),
+        pybind11::arg("tape"), pybind11::arg("function"),
+        R"doc(Lower the graph of a function to a tape.
+
+Parameters
+----------
+tape : Tape
+       The tape on which the graph of the function was recorded.
+function : Function
+           The function to lower, with the sources and targets it was
+           created with.
+
+Raises
+------
+RuntimeError
+    If part of the graph was not recorded on the tape.
+ValueError
+    If the function has no targets or uses unsupported operations.)doc");
+
+    tapeFunction.def("evaluate", &TapeFunction::evaluate,
+        R"doc(Evaluate the target and intermediate variables.)doc");
+
+    tapeFunction.def("push_tangent", &TapeFunction::pushTangent,
+        R"doc(Forward-mode differentiation, using the derivatives of the
+sources as tangents.)doc");
+
+    tapeFunction.def(
+        "push_tangent_at",
+        [](TapeFunction& function, AbstractVariable const& seed) {
+            function.pushTangentAt(seed._node());
+        },
+        pybind11::arg("seed"),
+        R"doc(Forward-mode differentiation with respect to a source variable.)doc");
+
+    tapeFunction.def("pull_gradient", &TapeFunction::pullGradient,
+        R"doc(Reverse-mode differentiation, using the derivatives of the
+targets as gradients.)doc");
+
+    tapeFunction.def(
+        "pull_gradient_at",
+        [](TapeFunction& function, AbstractVariable const& seed) {
+            function.pullGradientAt(seed._node());
+        },
+        pybind11::arg("seed"),
+        R"doc(Reverse-mode differentiation of a variable of the function.)doc");
+
+    tapeFunction.def(
+        "hvp",
+        [](TapeFunction& function, AbstractVariable const& target,
+            pybind11::dict const& directions) {
+            auto tangents = std::unordered_map<void const*, double>{};
+            for (auto const& [source, direction] : directions) {
+                tangents.emplace(source.cast<AbstractVariable const&>()._node(),
+                    direction.cast<double>());
+            }
+            function.hvp(target._node(), tangents);
+        },
+        pybind11::arg("target"), pybind11::arg("directions"),
+        R"doc(Hessian-vector product.
+
+Computes H·v at the values of the last `evaluate`, where H is the Hessian
+of the target with respect to the sources and v is given by the
+directions, and stores it in the derivatives of the sources.
+The product is exact: a forward sweep computes the tangents of the
+values, and the reverse sweep from the target also computes the tangents
+of the gradients.
+Derivatives of the other variables are left unchanged.
+
+Parameters
+----------
+target : ScalarVariable
+         A variable of the function.
+directions : dict of ScalarVariable to float
+             Maps sources to their directions.
+             Sources missing from the dict get a zero direction.
+
+Examples
+--------
+>>> f = TapeFunction(tape, Function(z, sources=(x, y)))
+
+>>> f.evaluate()
+
+>>> f.hvp(z, {x: 1.0})  # d(x) = ∂²z/∂x², d(y) = ∂²z/∂y∂x
+
+Raises
+------
+ValueError
+    If the target is not a variable of the function or a direction is
+    given for a variable that is not a source.)doc");
+
+    tapeFunction.def(
+        "save",
+        [](TapeFunction const& function, pybind11::object const& path) {
+            auto const os = pybind11::module_::import("os");
+            function.save(os.attr("fspath")(path).cast<std::string>());
+        },
+        pybind11::arg("path"),
+        R"doc(Save the instructions to a file.
+
+The file stores the opcodes and operand slots of the instructions, the
+constants, and the current values of the sources as aligned arrays, which
+`load` maps into memory and runs directly.
+
+Parameters
+----------
+path : str or os.PathLike
+       The file to write.
+
+Raises
+------
+RuntimeError
+    If the file cannot be written.)doc");
+
+    tapeFunction.def_static(
+        "load",
+        [](pybind11::object const& path) {
+            auto const os = pybind11::module_::import("os");
+            return loadTapeFunction(
+                os.attr("fspath")(path).cast<std::string>());
+        },
+        pybind11::arg("path"),
+        R"doc(Load a function saved with `save`.
+
+The file is mapped into memory (read-only), and the sweeps run on the
+mapped instructions, so that processes loading the same file share them.
+No graph is created, and no Python code of the file is run.
+
+Parameters
+----------
+path : str or os.PathLike
+       The file to read.
+
+Returns
+-------
+A function with new source and target variables, accessible via
+`sources` and `targets`.
+The sources have the values they had when saving, and the targets are
+evaluated.
+
+Raises
+------
+RuntimeError
+    If the file is not a valid tape, e.g. if an opcode is unknown or a slot
+    is out of range.)doc");
+
+    tapeFunction.def_property_readonly(
+        "sources",
+        [](TapeFunction const& function) {
+            return toTuple(function.sources());
+        },
+        R"doc(The source variables.)doc");
+
+    tapeFunction.def_property_readonly(
+        "targets",
+        [](TapeFunction const& function) {
+            return toTuple(function.targets());
+        },
+        R"doc(The target variables.)doc");
+
+    tapeFunction.def_property_readonly("instructions",
+        &TapeFunction::instructions,
+        R"doc(The number of instructions on the tape.)doc");
+
+    tapeFunction.def_property_readonly("slots", &TapeFunction::slots,
+        R"doc(The number of values stored by the tape.)doc");
+}
+
+} // namespace
+
 PYBIND11_MODULE(MODULE_NAME, module)
 {
     module.attr("__version__") = VERSION_INFO;
     // the module docstring is added directly to `src-python/autodiff/scalar.py`
 
-    defCore(module); // must be called before ExpressionBinding
+    importCore(module); // must be called before ExpressionBinding
 
     using Binding = AutoDiff::Python::ExpressionBinding<double, double>;
     auto binding  = Binding(module, "Scalar");
@@ -30,9 +311,13 @@ PYBIND11_MODULE(MODULE_NAME, module)
     AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "cos", cos, "")
     AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "exp", exp, "")
     AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "log", log, "")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "log1p", log1p, "")
     AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "maximum", max, "")
     AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "minimum", min, "")
+    AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "sigmoid", sigmoid, "")
     AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "sin", sin, "")
     AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "sqrt", sqrt, "")
     AUTODIFF_PYTHON_DEF_UNARY_OP(Binding, module, "square", square, "")
+
+    defTapeFunction(module);
 }
@@ -1,6 +1,13 @@
+import os
+import sys
+import tempfile
+import threading
 import unittest
 import numpy as np
-from autodiff.array import Function, var, d
+import scipy.sparse
+import autodiff
+from autodiff.array import (Function, FunctionGroup, SparseMatrixVariable,
+                            Tape, var, d, cos, dot, exp, matmul, sin, sqrt)
 
 class TestArrayProduct(unittest.TestCase):
     def test_eager_evaluation(self):
@@ -51,5 +58,610 @@ class TestArrayProduct(unittest.TestCase):
         assert np.array_equal(d(y), np.diag(xVal))
         assert np.array_equal(d(z), np.identity(3))
 
+    def test_retained_cache(self):
+        x = var(np.array([0.5, 1.0, 2.0]))
+        y = var(np.array([-2.5, 1.0, 3.0]))
+        z = var(x * y + x)
+
+        f = Function(z)
+        f.retain_cache = True
+        assert f.retain_cache
+
+        for xVal, yVal in [([1.0, 2.0, 3.0], [4.0, 5.0, 6.0]),
+                           ([-1.0, 0.0, 1.0], [2.0, 2.0, 2.0]),
+                           ([3.5, -1.0], [1.0, -1.0])]:  # shape change
+            x.set(np.array(xVal))
+            y.set(np.array(yVal))
+            f.evaluate()
+            f.pull_gradient_at(z)
+
+            assert np.array_equal(z(), np.array(xVal) * yVal + xVal)
+            assert np.array_equal(d(x), np.diag(np.array(yVal) + 1))
+
+    def test_buffer_pools(self):
+        x = var(np.array([0.5, 1.0, 2.0]))
+        z = var(exp(x) * x + x)
+
+        f = Function(z)
+        for _ in range(2):
+            f.evaluate()
+            f.pull_gradient_at(z)  # intermediates come from the pool
+            assert np.allclose(d(x), np.diag(np.exp(x()) * (x() + 1) + 1))
+            autodiff.clear_buffer_pools()
+
+    def test_concurrent_evaluation(self):
+        def model(seed):
+            x = var(np.full(100, seed))
+            y = var(np.full(100, 2.0))
+            z = var(x * y)
+            return x, z, Function(z)
+
+        models = [model(float(i)) for i in range(4)]
+        for _, _, f in models:
+            f.release_gil = True
+            assert f.release_gil
+
+        threads = [threading.Thread(target=f.evaluate) for _, _, f in models]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        for x, z, _ in models:
+            assert np.array_equal(z(), 2 * x())
+
+    def test_parallel_branches(self):
+        xVals = [np.random.rand(5) for _ in range(4)]
+        xs = [var(xVal) for xVal in xVals]
+        ys = [var(dot(x, x)) for x in xs]
+        loss = var(ys[0] + ys[1] + ys[2] + ys[3])
+
+        branches = FunctionGroup([Function(y) for y in ys], threads=2)
+        total = Function(loss, sources=tuple(ys))
+        assert branches.threads == 2
+
+        for x in xs:
+            x.set(2 * x())
+        branches.evaluate()
+        total.evaluate()
+        total.pull_gradient_at(loss)
+        branches.pull_gradient()
+
+        assert np.isclose(loss(), sum(4 * np.dot(x, x) for x in xVals))
+        for x, xVal in zip(xs, xVals):
+            assert np.allclose(d(x), [4 * xVal])
+
+    def test_parallel_levels(self):
+        xVals = [np.random.rand(5) for _ in range(4)]
+        xs = [var(xVal) for xVal in xVals]
+        us = [var(exp(x) * x) for x in xs]
+        ys = [var(dot(u, u)) for u in us]
+        loss = var(ys[0] + ys[1] + ys[2] + ys[3])
+
+        f = Function(loss, threads=2)
+        assert f.threads == 2
+        for x in xs:
+            x.set(2 * x())
+        f.evaluate()
+
+        uVals = [np.exp(2 * xVal) * 2 * xVal for xVal in xVals]
+        assert np.isclose(loss(), sum(np.dot(u, u) for u in uVals))
+
+        for x in xs:
+            x.set_derivative(np.ones((5, 1)))  # tangent column
+        f.push_tangent()
+        tangent = sum(np.dot(2 * u, np.exp(2 * xVal) * (1 + 2 * xVal))
+                      for u, xVal in zip(uVals, xVals))
+        assert np.isclose(d(loss)[0, 0], tangent)
+
+        f.pull_gradient_at(loss)  # levels in reverse order
+        for x, u, xVal in zip(xs, uVals, xVals):
+            assert np.allclose(d(x), [2 * u * np.exp(2 * xVal) * (1 + 2 * xVal)])
+
+        f.threads = 1
+        assert f.threads == 1
+        f.evaluate()
+        assert np.isclose(loss(), sum(np.dot(u, u) for u in uVals))
+
+    def test_parallel_gradients(self):
+        wVal = np.random.rand(5)
+        w = var(wVal)  # read by all branches
+        xVals = [np.random.rand(5) for _ in range(4)]
+        xs = [var(xVal) for xVal in xVals]
+        ys = [var(dot(w, exp(x))) for x in xs]
+        loss = var(ys[0] + ys[1] + ys[2] + ys[3])
+
+        f = Function(loss, threads=2)
+        f.evaluate()
+        f.pull_gradient_at(loss)
+        assert np.allclose(d(w), [sum(np.exp(xVal) for xVal in xVals)])
+        for x, xVal in zip(xs, xVals):
+            assert np.allclose(d(x), [wVal * np.exp(xVal)])
+
+        f.push_tangent_at(w)
+        assert np.allclose(d(loss), [sum(np.exp(xVal) for xVal in xVals)])
+
+        with self.assertRaises(ValueError):  # the branches share w
+            FunctionGroup([Function(y) for y in ys])
+
+    def test_async_sweeps(self):
+        xVal = np.random.rand(1000)
+        x = var(xVal)
+        y = var(dot(exp(x), x))
+
+        f = Function(y, sources=(x,))
+        future = f.evaluate_async()
+        assert future.result() is None
+        assert np.isclose(y(), np.dot(np.exp(xVal), xVal))
+
+        f.pull_gradient_at_async(y).result()
+        assert np.allclose(d(x), [np.exp(xVal) * (1 + xVal)])
+
+        x.set(2 * xVal)  # unlocked
+        f.evaluate_async()
+        f.pull_gradient_at(y)  # waits for the evaluation
+        assert np.allclose(d(x), [np.exp(2 * xVal) * (1 + 2 * xVal)])
+
+        error = f.pull_gradient_at_async(x).exception()  # not a target
+        assert isinstance(error, RuntimeError)
+
+        z = var(exp(x))
+        g = Function(var(dot(z, x)))  # infers x as its source
+        interval = sys.getswitchinterval()
+        sys.setswitchinterval(10)  # keeps the GIL until the future is awaited
+        try:
+            future = g.evaluate_async()
+            with self.assertRaises(RuntimeError):
+                x.set(xVal)  # inferred source
+            with self.assertRaises(RuntimeError):
+                z.set(exp(x))  # intermediate variable
+            future.result()
+        finally:
+            sys.setswitchinterval(interval)
+        x.set(xVal)  # unlocked
+
+    def test_num_threads(self):
+        threads = autodiff.get_num_threads()
+        autodiff.set_num_threads(2)
+        assert autodiff.get_num_threads() in (1, 2)  # 1 without OpenMP
+        autodiff.set_num_threads(threads)
+
+        x = var(np.random.rand(100, 100))
+        y = var(matmul(x, x))
+        assert np.allclose(y(), x() @ x())
+
+    def test_directional_derivatives(self):
+        xVal = np.array([1.0, 2.0, 3.0])
+        yVal = np.array([[1.0, 2.0], [3.0, 4.0]])
+        m = np.array([[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]])
+
+        x = var(xVal)
+        y = var(yVal)
+        u = var(m @ x)
+        v = var(y * y)
+
+        f = Function((u, v), sources=(x, y))
+        f.jvp({x: np.array([1.0, 0.0, 1.0])})  # y gets a zero tangent
+        assert np.allclose(d(u), [[4.0], [10.0]])
+        assert np.allclose(d(v), np.zeros((4, 1)))
+
+        f.vjp({v: np.array([[1.0, 0.0], [0.0, 1.0]])})  # u gets zero gradient
+        assert np.allclose(d(x), np.zeros((1, 3)))
+        assert np.allclose(d(y), [[2.0, 0.0, 0.0, 8.0]])  # column-major
+
+    def test_jacobian(self):
+        xVal = np.array([1.0, 2.0, 3.0])
+        yVal = np.array([[1.0, 2.0], [3.0, 4.0]])
+        m = np.array([[1.0, 2.0, 3.0], [4.0, 5.0, 6.0]])
+
+        x = var(xVal)
+        y = var(yVal)
+        u = var(m @ x)
+        v = var(y * y)
+
+        f = Function((u, v), sources=(x, y))
+        f.evaluate()
+        expected = np.zeros((6, 7))
+        expected[:2, :3] = m
+        expected[2:, 3:] = np.diag(2.0 * yVal.flatten(order="F"))
+        for mode in ("auto", "forward", "reverse"):
+            assert np.allclose(f.jacobian(mode=mode), expected)
+
+        jacobian = f.jacobian(sources=(y,), targets=(v, u))
+        assert jacobian.shape == (6, 4)
+        assert np.allclose(jacobian, expected[[2, 3, 4, 5, 0, 1], 3:])
+
+    def test_hvp(self):
+        a = np.array([[1.0, 2.0], [3.0, 4.0], [0.5, -1.0]])
+        b = np.array([1.0, 1.0, 2.0])
+        v = np.array([1.0, -2.0])
+
+        x = var(np.array([0.5, 1.5]))
+        loss = var(0.5 * autodiff.array.squared_norm(matmul(a, x) - b))
+        f = Function(loss, sources=(x,))
+        f.hvp(loss, {x: v})
+        assert np.allclose(d(x), [a.T @ a @ v])  # Gauss-Newton product
+
+        # Hessians of element-wise functions, softmax, and logsumexp along v
+        y = var(np.array([0.3, -0.7]))
+        u = var(autodiff.array.log_softmax(x * y) + sin(x) / exp(y))
+        w = var(autodiff.array.logsumexp(u) * dot(x, sqrt(x + 1.0)))
+
+        f = Function(w, sources=(x, y))
+
+        def gradient(h):
+            x.set(np.array([0.5, 1.5]) + h * v)
+            y.set(np.array([0.3, -0.7]) - h * v)
+            f.evaluate()
+            f.pull_gradient_at(w)
+            return np.hstack((d(x), d(y)))
+
+        h = 1e-5
+        expected = (gradient(h) - gradient(-h)) / (2 * h)
+        gradient(0.0)
+        f.hvp(w, {x: v, y: -v})
+        assert np.allclose(np.hstack((d(x), d(y))), expected, rtol=1e-6)
+
+        with self.assertRaises(ValueError):
+            f.hvp(w, {u: v})  # not a source
+
+        s = var(autodiff.array.sum(x))
+        z = var(autodiff.array.squared_norm(x * s))  # scalar expression
+        with self.assertRaises(ValueError):
+            Function(z, sources=(x,)).hvp(z, {x: v})
+
+    def test_batch_evaluation(self):
+        xBatch = np.random.rand(10, 3)
+        yBatch = np.random.rand(10, 3)
+
+        x = var(np.zeros(3))
+        y = var(np.zeros(3))
+        z = var(x * y)
+
+        f = Function(z)
+        zBatch, = f.evaluate_batch({x: xBatch, y: yBatch}, outputs=(z,))
+
+        assert zBatch.shape == (10, 3)
+        assert np.allclose(zBatch, xBatch * yBatch)
+        assert np.array_equal(x(), xBatch[-1])
+
+    def test_in_place_assignment(self):
+        x = var(np.zeros(3))
+        y = var(np.array([[1.0, 2.0], [3.0, 4.0]]))
+        z = var(x * 2)
+
+        value = x()  # view into the storage of x
+        x.assign(np.array([1.0, 2.0, 3.0]))
+        y.assign(np.array([[5.0, 6.0], [7.0, 8.0]], order="F"))
+
+        f = Function(z)
+        f.evaluate()
+        f.pull_gradient_at(z)
+
+        assert np.array_equal(value, [1.0, 2.0, 3.0])
+        assert np.array_equal(y(), [[5.0, 6.0], [7.0, 8.0]])
+        assert np.array_equal(z(), [2.0, 4.0, 6.0])
+        assert not d(x).flags.owndata  # view into the derivative of x
+
+    def test_sparse_matmul(self):
+        AVal = scipy.sparse.random(5, 4, density=0.4, format="csr")
+        xVal = np.array([1.0, 2.0, 3.0, 4.0])
+
+        for matrix in (AVal, AVal.tocsc()):
+            A = SparseMatrixVariable(matrix)
+            x = var(xVal)
+            y = var(A @ x)
+            z = var(matmul(A, sqrt(x)))
+
+            assert A.shape == (5, 4)
+            assert A() is matrix
+            assert np.allclose(y(), AVal @ xVal)
+            assert np.allclose(z(), AVal @ np.sqrt(xVal))
+
+            f = Function(y)
+            f.pull_gradient_at(y)
+            assert np.allclose(d(x), AVal.toarray())
+
+            f.push_tangent_at(x)
+            assert np.allclose(d(y), AVal.toarray())
+
+        with self.assertRaises(ValueError):
+            SparseMatrixVariable(scipy.sparse.random(3, 3, format="coo"))
+
+    def test_sparse_matmul_tape(self):
+        with Tape() as tape:
+            A = SparseMatrixVariable(scipy.sparse.eye(3, format="csr"))
+            x = var(np.array([1.0, 2.0, 3.0]))
+            y = var(A @ x)
+
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "f.tape")
+            with self.assertRaises(ValueError):  # not a scalar instruction
+                tape.save(path, Function(y, sources=(x,)))
+            assert not os.path.exists(path)
+
+class TestArrayCwise(unittest.TestCase):
+    def test_forward_mode_differentiation(self):
+        xVal = np.array([0.5, 1.0, 2.0])
+
+        x = var(xVal)
+        y = var(exp(cos(x)))
+
+        f = Function(y)
+        f.push_tangent_at(x)
+
+        assert np.allclose(y(), np.exp(np.cos(xVal)))
+        assert np.allclose(d(y), np.diag(-np.sin(xVal) * np.exp(np.cos(xVal))))
+
+    def test_reverse_mode_differentiation(self):
+        xVal = np.array([[1.0, 4.0], [9.0, 16.0]])
+
+        x = var(xVal)
+        y = var(sqrt(x))
+
+        f = Function(y)
+        f.pull_gradient_at(y)
+
+        # matrices are flattened in column-major order
+        expected = np.diag(0.5 / np.sqrt(xVal.flatten(order="F")))
+        assert np.allclose(y(), np.sqrt(xVal))
+        assert np.allclose(d(x), expected)
+
+    def test_fused_chain(self):
+        xVal = np.array([-1.0, 0.5, 2.0])
+        k = 2.0
+
+        x = var(xVal)
+        u = -k * x
+        y = var(1 / (1 + exp(u)))  # fused into the operations after u
+        z = var(u)                 # u is still referenced, so not fused
+
+        f = Function(y)
+        f.pull_gradient_at(y)
+
+        sigmoid = 1 / (1 + np.exp(-k * xVal))
+        assert np.allclose(y(), sigmoid)
+        assert np.allclose(z(), -k * xVal)
+        assert np.allclose(d(x), np.diag(k * sigmoid * (1 - sigmoid)))
+
+    def test_fused_chain_single_use(self):
+        xVal = np.array([-1.0, 0.5, 2.0])
+
+        x = var(xVal)
+        u = exp(x)
+        y = var(sin(u) + cos(u))  # u is evaluated once, not copied
+        z = var(sin(exp(x)))      # the temporary exp(x) is fused
+
+        for w, calls in [(y, 3), (z, 1)]:
+            f = Function(w)
+            f.profile()
+            f.evaluate()
+            f.profile(False)
+            cwise = f.stats()["operations"]["CwiseOperation"]
+            assert cwise["evaluate"]["calls"] == calls
+
+        assert np.allclose(y(), np.sin(np.exp(xVal)) + np.cos(np.exp(xVal)))
+        assert np.allclose(z(), np.sin(np.exp(xVal)))
+
+    def test_scalar_literals(self):
+        xVal = np.array([[1.0, 2.0], [3.0, 4.0]])
+
+        x = var(xVal)
+        y = var(2 - x ** 3 / 4 - 1)
+
+        f = Function(y)
+        f.push_tangent_at(x)
+
+        expected = np.diag(-0.75 * xVal.flatten(order="F") ** 2)
+        assert np.allclose(y(), 2 - xVal ** 3 / 4 - 1)
+        assert np.allclose(d(y), expected)
+
+    def test_axis_reductions(self):
+        xVal = np.array([[0.5, -1.0], [2.0, 3.0], [-4.0, 1.5]])
+        reductions = {
+            autodiff.array.sum: np.sum,
+            autodiff.array.mean: np.mean,
+            autodiff.array.norm: np.linalg.norm,
+            autodiff.array.max: np.max,
+        }
+        for reduce, numpyReduce in reductions.items():
+            for axis in (0, 1):
+                x = var(xVal)
+                y = var(reduce(x, axis))
+
+                # Jacobian by central differences, column-major flattening
+                expected = np.zeros((xVal.shape[1 - axis], xVal.size))
+                for k in range(xVal.size):
+                    step = np.zeros(xVal.size)
+                    step[k] = 1e-6
+                    step = step.reshape(xVal.shape, order="F")
+                    expected[:, k] = (numpyReduce(xVal + step, axis=axis)
+                        - numpyReduce(xVal - step, axis=axis)) / 2e-6
+
+                f = Function(y)
+                f.push_tangent_at(x)
+                assert np.allclose(y(), numpyReduce(xVal, axis=axis))
+                assert np.allclose(d(y), expected)
+
+                f.pull_gradient_at(y)
+                assert np.allclose(d(x), expected)
+
+    def test_stable_primitives(self):
+        xVal = np.array([1000.0, 1001.0, 999.0])  # exp(x) overflows
+        s = np.exp(xVal - 1001.0) / np.sum(np.exp(xVal - 1001.0))
+
+        x = var(xVal)
+        y = var(autodiff.array.logsumexp(x))
+        u = var(autodiff.array.softmax(x))
+        v = var(autodiff.array.log_softmax(x))
+        assert np.isclose(y(), 1001.0 + np.log(np.sum(np.exp(xVal - 1001.0))))
+        assert np.allclose(u(), s)
+        assert np.allclose(v(), np.log(s))
+
+        Function(y).pull_gradient_at(y)
+        assert np.allclose(d(x), s)
+        f = Function(u)
+        f.pull_gradient_at(u)
+        assert np.allclose(d(x), np.diag(s) - np.outer(s, s))
+        f.push_tangent_at(x)
+        assert np.allclose(d(u), np.diag(s) - np.outer(s, s))
+        Function(v).pull_gradient_at(v)
+        assert np.allclose(d(x), np.eye(3) - np.outer(np.ones(3), s))
+
+        xVal = np.array([-800.0, 0.0, 2.0])  # exp(-x) overflows
+        x = var(xVal)
+        y = var(autodiff.array.sigmoid(x))
+        sigmoid = np.array([0.0, 0.5, 1 / (1 + np.exp(-2.0))])
+        assert np.allclose(y(), sigmoid)
+        Function(y).pull_gradient_at(y)
+        assert np.allclose(d(x), np.diag(sigmoid * (1 - sigmoid)))
+
+        xVal = np.array([1e-10, 0.5, 2.0])  # log(1 + x) loses digits
+        x = var(xVal)
+        y = var(autodiff.array.log1p(x))
+        assert np.allclose(y(), np.log1p(xVal), rtol=1e-12, atol=0)
+        Function(y).pull_gradient_at(y)
+        assert np.allclose(d(x), np.diag(1 / (1 + xVal)))
+
+    def test_element_wise_gradients(self):
+        xVal = np.array([0.5, 1.0, 2.0])
+        yVal = np.array([-2.5, 1.0, 3.0])
+
+        x = var(xVal)
+        y = var(yVal)
+        z = var(x * y + x / y - x ** y)
+
+        f = Function(z)
+        f.retain_cache = True
+        for _ in range(2):  # reuses the gradient buffers
+            f.pull_gradient_at(z)
+            assert np.allclose(
+                d(x), np.diag(yVal + 1 / yVal - yVal * xVal ** (yVal - 1)))
+            assert np.allclose(d(y), np.diag(
+                xVal - xVal / yVal ** 2 - xVal ** yVal * np.log(xVal)))
+
+    def test_element_wise_literals(self):
+        xVal = np.array([0.5, 1.0, 2.0])
+        a = np.array([1.5, 2.0, 3.0])
+
+        x = var(xVal)
+        # numpy arrays on the left would broadcast, so call the reflection
+        z = var(x * a + x / a - x ** a + (x - a) + x.__rpow__(a))
+        expected = np.diag(
+            a + 1 / a - a * xVal ** (a - 1) + 1 + a ** xVal * np.log(a))
+
+        assert np.allclose(
+            z(), xVal * a + xVal / a - xVal ** a + xVal - a + a ** xVal)
+        f = Function(z)
+        f.pull_gradient_at(z)
+        assert np.allclose(d(x), expected)
+        f.push_tangent_at(x)
+        assert np.allclose(d(z), expected)
+
+    def test_operand_values_not_reevaluated(self):
+        a = np.array([1.5, 2.0, 3.0])
+
+        x = var(np.array([0.5, 1.0, 2.0]))
+        y = x
+        for _ in range(10):
+            y = sin(y * a)  # a chain in one node, fused pairwise only
+        y = var(y)
+
+        f = Function(y)
+        f.profile()
+        f.evaluate()
+        f.pull_gradient_at(y)
+        f.profile(False)
+
+        operations = f.stats()["operations"]
+        assert operations["CwiseOperation"]["evaluate"]["calls"] == 10
+        assert operations["CwiseBinaryOperation"]["evaluate"]["calls"] == 10
+
+    def test_profiling(self):
+        x = var(np.array([0.5, 1.0, 2.0]))
+        y = var(dot(exp(x), x))
+
+        f = Function(y)
+        f.profile()
+        f.evaluate()
+        f.pull_gradient_at(y)
+        f.profile(False)
+        f.evaluate()  # not recorded
+
+        stats = f.stats()
+        cwise = stats["operations"]["CwiseOperation"]
+        assert cwise["evaluate"]["calls"] == 1
+        assert cwise["evaluate"]["bytes"] == 3 * 8
+        assert cwise["pull_gradient"]["calls"] == 1
+        assert "push_tangent" not in cwise
+        assert (3,) in [node["shape"] for node in stats["nodes"]]
+
+        events = f.trace()["traceEvents"]
+        assert len(events) > 0
+        assert all(event["ph"] == "X" for event in events)
+
+    def test_memory_report(self):
+        x = var(np.array([0.5, 1.0, 2.0]))
+        u = var(exp(x))
+        v = var(x * x)
+        y = var(dot(u, v))
+
+        f = Function(y)
+        report = f.memory_report()  # from the graph, without profiling
+        assert report["levels"] == 2
+        assert report["widest_level"] == 2
+        assert "CwiseOperation" in report["operations"]
+        assert sum(report["operations"].values()) == 3  # exp, *, dot
+        assert report["variables"] == 4
+        assert report["value_bytes"] == 3 * 3 * 8 + 8
+        assert report["peak_bytes"] is None
+
+        f.profile()
+        f.evaluate()
+        f.pull_gradient_at(y)
+        report = f.memory_report()
+        assert report["derivative_bytes"] == 3 * 3 * 8 + 8  # rows and d(y)
+        assert report["peak_bytes"]["evaluate"] >= 3 * 8
+        assert report["peak_bytes"]["pull_gradient"] >= 3 * 8
+
+        with Tape() as tape:
+            x = var(np.array([0.5, 1.0, 2.0]))
+            y = var(dot(exp(x) * 2.0 + 1.0, x))
+
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "f.tape")
+            with self.assertRaises(ValueError):  # tapes save scalar graphs
+                tape.save(path, Function(y, sources=(x,)))
+            assert not os.path.exists(path)
+
+    def test_tape_unrecorded_variable(self):
+        x = var(np.array([0.5, 1.0]))
+        with Tape() as tape:
+            y = var(exp(x))
+
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "f.tape")
+            with self.assertRaises(RuntimeError):
+                tape.save(path, Function(y))
+
+    def test_mixed_modules(self):
+        from autodiff import scalar
+
+        s = scalar.var(2.0)
+        t = scalar.var(s * s)
+        x = var(np.array([0.5, 1.0]))
+        y = var(x * x)
+
+        assert scalar.Function is Function
+        f = Function((t, y))
+        s.set(3.0)
+        x.set(np.array([2.0, 3.0]))
+        f.evaluate()
+        assert t() == 9.0
+        assert np.allclose(y(), [4.0, 9.0])
+
+        f.pull_gradient_at(t)
+        assert scalar.d(s) == 6.0
+
 if __name__ == '__main__':
     unittest.main()
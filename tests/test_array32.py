@@ -0,0 +1,34 @@
+import unittest
+import numpy as np
+from autodiff.array32 import Function, var, d, exp
+
+class TestArray32(unittest.TestCase):
+    def test_single_precision(self):
+        xVal = np.array([1.0, 2.0, 3.0], dtype=np.float32)
+
+        x = var(xVal)
+        y = var(exp(x) * x)
+
+        assert x().dtype == np.float32
+        assert y().dtype == np.float32
+        assert np.allclose(y(), np.exp(xVal) * xVal)
+
+    def test_reverse_mode_differentiation(self):
+        xVal = np.array([[1.0, 2.0], [3.0, 4.0]], dtype=np.float32)
+
+        x = var(xVal)
+        y = var(2 * x * x)
+
+        f = Function(y)
+        f.pull_gradient_at(y)
+
+        expected = np.diag(4 * xVal.flatten(order="F"))
+        assert d(x).dtype == np.float32
+        assert np.allclose(d(x), expected)
+
+    def test_conversion(self):
+        x = var(np.array([1.0, 2.0]))  # float64 input is converted
+        assert x().dtype == np.float32
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,53 @@
+import unittest
+import numpy as np
+from autodiff.fixed import Function, var, d, dot
+from autodiff.fixed import Vector3Variable, Matrix2Variable, ScalarVariable
+
+class TestFixed(unittest.TestCase):
+    def test_shape_dispatch(self):
+        x = var(np.array([1.0, 2.0, 3.0]))
+        A = var(np.array([[1.0, 2.0], [3.0, 4.0]]))
+
+        assert isinstance(x, Vector3Variable)
+        assert isinstance(A, Matrix2Variable)
+        assert np.allclose(x(), [1.0, 2.0, 3.0])
+
+    def test_reverse_mode_differentiation(self):
+        AVal = np.array([[2.0, 1.0, 0.0], [1.0, 3.0, 1.0], [0.0, 1.0, 4.0]])
+        xVal = np.array([1.0, 2.0, 3.0])
+
+        A = var(AVal)
+        x = var(xVal)
+        y = var(dot(x, A @ x))
+        assert isinstance(y, ScalarVariable)
+
+        f = Function(y)
+        f.pull_gradient_at(y)
+
+        assert np.allclose(y(), xVal @ AVal @ xVal)
+        assert np.allclose(d(x), (2 * AVal @ xVal).reshape(1, 3))
+
+    def test_assign_shape_mismatch(self):
+        x = var(np.array([1.0, 2.0]))
+        y = var(2 * x)
+        f = Function(y)
+
+        with self.assertRaises(ValueError):
+            f.evaluate_batch({x: np.zeros((4, 3))}, (y,))
+
+    def test_with_array_module(self):
+        from autodiff import array  # binds the same scalar types
+
+        x = array.var(np.ones(5))
+        y = var(np.ones(3))
+        s = array.var(array.dot(x, x))
+        t = var(dot(y, y))
+        assert isinstance(t, ScalarVariable)
+        assert not isinstance(s, ScalarVariable)
+
+        f = Function((s, t))
+        f.evaluate()
+        assert np.isclose(s(), 5.0) and np.isclose(t(), 3.0)
+
+if __name__ == '__main__':
+    unittest.main()
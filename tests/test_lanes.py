@@ -0,0 +1,53 @@
+import unittest
+import numpy as np
+from autodiff.lanes import Function, var, d, sin, exp
+
+class TestLanes(unittest.TestCase):
+    def test_eager_evaluation(self):
+        xVal = np.array([0.5, 1.0, 2.0])
+        yVal = np.array([-2.5, 3.0, 0.25])
+
+        x = var(xVal)
+        y = var(yVal)
+        z = var(sin(x) * y + 1)
+
+        assert np.allclose(z(), np.sin(xVal) * yVal + 1)
+
+    def test_forward_mode_differentiation(self):
+        xVal = np.array([0.5, 1.0, 2.0])
+        yVal = np.array([-2.5, 3.0, 0.25])
+
+        x = var(xVal)
+        y = var(yVal)
+        z = var(x * y / exp(x))
+
+        f = Function(z, sources=(x, y))
+        f.jvp({x: np.ones(3)})  # y gets a zero tangent
+        assert np.allclose(d(z), (1 - xVal) * yVal / np.exp(xVal))
+
+    def test_reverse_mode_differentiation(self):
+        xVal = np.array([0.5, 1.0, 2.0])
+        yVal = np.array([-2.5, 3.0, 0.25])
+
+        x = var(xVal)
+        y = var(yVal)
+        z = var(x ** y - 2 * x)
+
+        f = Function(z, sources=(x, y))
+        f.vjp({z: np.ones(3)})
+        assert np.allclose(d(x), yVal * xVal ** (yVal - 1) - 2)
+        assert np.allclose(d(y), xVal ** yVal * np.log(xVal))
+
+    def test_scalar_power(self):
+        xVal = np.array([0.5, 1.0, 2.0])
+
+        x = var(xVal)
+        z = var(2 ** x)  # same graph as in autodiff.scalar
+        assert np.allclose(z(), 2 ** xVal)
+
+        f = Function(z, sources=(x,))
+        f.vjp({z: np.ones(3)})
+        assert np.allclose(d(x), 2 ** xVal * np.log(2))
+
+if __name__ == '__main__':
+    unittest.main()
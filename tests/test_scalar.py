@@ -1,5 +1,30 @@
+import os
+import struct
+import tempfile
 import unittest
-from autodiff.scalar import Function, var, d
+import numpy as np
+from autodiff.scalar import (Function, Graph, Tape, TapeFunction, checkpoint_vjp,
+                             var, d, exp, log1p, sigmoid, sin, sqrt)
+
+def write_tape(path, instructions, constants, sources, targets, slots=None,
+               magic=b"ADTAPE02"):
+    """Write a tape of (opcode, lhs, rhs, out) instructions, (slot, value)
+    constants and sources, and target slots, each array aligned to 64 bytes."""
+    if slots is None:
+        slots = 1 + max(s for i in instructions for s in i[1:])
+    data = magic + struct.pack("<5Q", slots, len(instructions),
+                               len(constants), len(sources), len(targets))
+    columns = list(zip(*instructions)) or [(), (), (), ()]
+    arrays = [struct.pack(f"<{len(columns[0])}B", *columns[0])]
+    arrays += [struct.pack(f"<{len(c)}I", *c) for c in columns[1:]]
+    for pairs in (constants, sources):
+        arrays.append(struct.pack(f"<{len(pairs)}I", *(s for s, _ in pairs)))
+        arrays.append(struct.pack(f"<{len(pairs)}d", *(v for _, v in pairs)))
+    arrays.append(struct.pack(f"<{len(targets)}I", *targets))
+    for array in arrays:
+        data = data.ljust((len(data) + 63) // 64 * 64, b"\0") + array
+    with open(path, "wb") as file:
+        file.write(data)
 
 class TestScalarProduct(unittest.TestCase):
     def test_eager_evaluation(self):
@@ -51,5 +76,367 @@ class TestScalarProduct(unittest.TestCase):
         assert d(y) == xVal
         assert d(z) == 1.0
 
+    def test_batch_evaluation(self):
+        xBatch = np.linspace(-1.0, 1.0, 5)
+        yBatch = np.linspace(2.0, 3.0, 5)
+
+        x = var(0.0)
+        y = var(0.0)
+        z = var(x * y)
+
+        f = Function(z)
+        zBatch, = f.evaluate_batch({x: xBatch, y: yBatch}, outputs=(z,))
+
+        assert np.array_equal(zBatch, xBatch * yBatch)
+        assert z() == xBatch[-1] * yBatch[-1]
+
+    def test_recompilation(self):
+        x = var(2.0)
+        u = var(x * x)
+
+        f = Function(u)
+        f.compile()
+        f.compile()  # unchanged graph, skipped
+        assert f.compiled()
+
+        a = var(3.0)
+        u.set(a * x)  # new expression, must not skip
+        f.compile()
+        f.evaluate()
+        f.pull_gradient_at(u)
+        assert u() == 6.0
+        assert d(a) == 2.0
+
+        v = var(x + 1.0)
+        v.set(x - 1.0)  # outside the graph, same structure
+        u.set(a + x)    # same operands, same structure
+        f.compile()
+        f.evaluate()
+        f.pull_gradient_at(u)
+        assert u() == 5.0
+        assert d(a) == 1.0
+
+        f.threads = 2
+        w = var(a * a)
+        u.set(w + x)    # changed structure
+        f.compile()
+        f.evaluate()
+        assert u() == 11.0
+
+    def test_incremental_evaluation(self):
+        x = var(1.0)
+        y = var(2.0)
+        u = var(x * y)
+        w = var(u * u)
+
+        fu = Function(u, sources=(x,))  # y is not listed, but read
+        fw = Function(w, sources=(u,))
+        fu.incremental = True
+        fw.incremental = True
+        fu.evaluate()
+        fw.evaluate()
+
+        fw.profile()
+        fw.evaluate()  # skipped
+        fw.profile(False)
+        assert fw.stats()["nodes"] == []
+
+        y.set(3.0)     # read by the last evaluation of fu
+        fu.evaluate()  # re-evaluated
+        fw.evaluate()  # re-evaluated since u was modified
+        assert u() == 3.0
+        assert w() == 9.0
+
+        x.set(2.0)
+        fu.evaluate()
+        fw.evaluate()
+        assert u() == 6.0
+        assert w() == 36.0
+
+    def test_incremental_cone(self):
+        xs = [var(float(i)) for i in range(4)]
+        us = [var(x * x) for x in xs]
+        loss = var(us[0] + us[1] + us[2] + us[3])
+
+        f = Function(loss)
+        f.incremental = True
+        f.evaluate()
+        xs[2].set(5.0)
+        f.evaluate()  # evaluates us[2] and loss only
+        assert us[2]() == 25.0
+        assert loss() == 0.0 + 1.0 + 25.0 + 9.0
+
+        for x in xs:
+            x.set_derivative(0.0)
+        f.push_tangent()
+        assert d(loss) == 0.0
+        xs[1].set_derivative(1.0)
+        f.push_tangent()  # pushes through us[1] and loss only
+        assert d(us[1]) == 2.0
+        assert d(loss) == 2.0
+
+        f.pull_gradient_at(loss)
+        assert d(xs[2]) == 10.0
+        f.push_tangent()  # all tangents again, the gradients as tangents
+        assert d(loss) == 2.0 * 2.0 + 10.0 * 10.0 + 6.0 * 6.0
+
+    def test_directional_derivatives(self):
+        xVal = 0.5
+        yVal = -2.5
+
+        x = var(xVal)
+        y = var(yVal)
+        z = var(x * y)
+
+        f = Function(z, sources=(x, y))
+        f.jvp({x: 2.0})  # y gets a zero tangent
+        assert d(z) == 2.0 * yVal
+
+        f.vjp({z: 3.0})
+        assert d(x) == 3.0 * yVal
+        assert d(y) == 3.0 * xVal
+
+    def test_jacobian(self):
+        xVal = 0.5
+        yVal = -2.5
+
+        x = var(xVal)
+        y = var(yVal)
+        u = var(x * y)
+        v = var(x + y)
+
+        f = Function((u, v), sources=(x, y))
+        f.evaluate()
+        expected = [[yVal, xVal], [1.0, 1.0]]
+        assert np.allclose(f.jacobian(mode="forward"), expected)
+        assert np.allclose(f.jacobian(mode="reverse"), expected)
+        assert np.allclose(f.jacobian(targets=(v,)), [[1.0, 1.0]])
+
+    def test_arena_allocation(self):
+        with Graph(block_size=1024) as graph:
+            x = var(0.5)
+            y = x
+            for _ in range(100):
+                y = var(y * x + 1.0)
+
+        assert graph.allocated > 0
+        assert graph.reserved >= graph.allocated
+        assert graph.objects >= 200  # at least the evaluators of 200 operations
+
+        allocated, objects = graph.allocated, graph.objects
+        z = var(y * x)  # outside of the context: allocated from the heap
+        assert graph.allocated == allocated and graph.objects == objects
+
+        f = Function(y)
+        x.set(1.0)
+        f.evaluate()
+        assert y() == 101.0
+
+        f.pull_gradient_at(y)
+        assert d(x) == 5051.0  # 1 + sum of 1..100
+
+        del f, x, y, z  # the graph nodes own the objects in the arena
+        assert graph.objects == 0
+
+    def test_checkpointing(self):
+        aVal = 1.01
+        xVal = 0.5
+        n = 10
+
+        a = var(aVal)
+        x = var(xVal)
+        final = checkpoint_vjp(lambda x: var(a * x), x, n, 1.0,
+                               parameters=(a,), every=3)
+
+        assert np.isclose(final, xVal * aVal ** n)
+        assert np.isclose(d(x), aVal ** n)
+        assert np.isclose(d(a), n * xVal * aVal ** (n - 1))
+
+        final = checkpoint_vjp(lambda x: var(a * x), x, 0, 2.0,
+                               parameters=(a,))
+        assert np.isclose(final, xVal)
+        assert np.isclose(d(x), 2.0) and np.isclose(d(a), 0.0)
+
+    def test_tape_function(self):
+        with Tape() as tape:
+            x = var(0.5)
+            y = var(2.0)
+            u = var(sin(x) * y + 1.0)
+            z = var(exp(u) / (1.0 + x) - 3.0 ** y)
+
+        f = TapeFunction(tape, Function(z, sources=(x, y)))
+        g = Function(z, sources=(x, y))
+
+        x.set(0.25)
+        f.evaluate()
+        zVal = z()
+        f.pull_gradient_at(z)
+        gradient = (d(x), d(y), d(u))
+        f.push_tangent_at(y)
+        tangent = d(z)
+
+        g.evaluate()
+        assert np.isclose(zVal, z())
+        g.pull_gradient_at(z)
+        assert np.allclose(gradient, (d(x), d(y), d(u)))
+        g.push_tangent_at(y)
+        assert np.isclose(tangent, d(z))
+
+    def test_tape_function_hvp(self):
+        with Tape() as tape:
+            x = var(0.5)
+            y = var(-2.5)
+            z = var(x * x * y)
+            u = var(sin(x) * y + 1.0)
+            w = var(exp(u) / (1.0 + x) - 3.0 ** y + sqrt(x) ** y)
+
+        f = TapeFunction(tape, Function((z, w), sources=(x, y)))
+        f.evaluate()
+        f.hvp(z, {x: 1.0})
+        assert np.isclose(d(x), 2 * y())  # ∂²z/∂x²
+        assert np.isclose(d(y), 2 * x())  # ∂²z/∂y∂x
+
+        # central differences of the gradients of w along (1, 2)
+        def gradient(h):
+            x.set(0.5 + h)
+            y.set(-2.5 + 2 * h)
+            f.evaluate()
+            f.pull_gradient_at(w)
+            return np.array([d(x), d(y)])
+
+        h = 1e-5
+        expected = (gradient(h) - gradient(-h)) / (2 * h)
+        gradient(0.0)
+        f.hvp(w, {x: 1.0, y: 2.0})
+        assert np.allclose([d(x), d(y)], expected, rtol=1e-6)
+
+        with self.assertRaises(ValueError):
+            f.hvp(w, {u: 1.0})  # not a source
+
+    def test_hvp(self):
+        x = var(0.5)
+        y = var(-2.5)
+        z = var(x * x * y)
+        u = var(sin(x) * y + 1.0)
+        w = var(exp(u) / (1.0 + x) - 3.0 ** y + sqrt(x) ** y)
+
+        f = Function((z, w), sources=(x, y))
+        f.hvp(z, {x: 1.0})
+        assert np.isclose(d(x), 2 * y())  # ∂²z/∂x²
+        assert np.isclose(d(y), 2 * x())  # ∂²z/∂y∂x
+
+        # same products as TapeFunction.hvp
+        def gradient(h):
+            x.set(0.5 + h)
+            y.set(-2.5 + 2 * h)
+            f.evaluate()
+            f.pull_gradient_at(w)
+            return np.array([d(x), d(y)])
+
+        h = 1e-5
+        expected = (gradient(h) - gradient(-h)) / (2 * h)
+        gradient(0.0)
+        f.hvp(w, {x: 1.0, y: 2.0})
+        assert np.allclose([d(x), d(y)], expected, rtol=1e-6)
+
+        with self.assertRaises(ValueError):
+            f.hvp(w, {u: 1.0})  # not a source
+
+    def test_stable_functions(self):
+        with Tape() as tape:
+            x = var(-800.0)  # exp(-x) overflows
+            y = var(1e-10)   # log(1 + y) loses digits
+            z = var(sigmoid(x) + log1p(y))
+
+        assert np.isclose(z(), 1e-10, rtol=1e-8, atol=0)
+        g = Function(z, sources=(x, y))
+        g.pull_gradient_at(z)
+        assert np.isclose(d(x), 0.0) and np.isclose(d(y), 1 / (1 + 1e-10))
+
+        x.set(0.5)
+        f = TapeFunction(tape, g)
+        f.evaluate()
+        f.pull_gradient_at(z)
+        s = 1 / (1 + np.exp(-0.5))
+        assert np.isclose(z(), s + np.log1p(1e-10))
+        assert np.isclose(d(x), s * (1 - s))
+        assert np.isclose(d(y), 1 / (1 + 1e-10))
+
+    def test_tape_function_unsupported(self):
+        x = var(0.5)
+        with Tape() as tape:
+            y = var(sin(x))
+
+        with self.assertRaises(RuntimeError):
+            TapeFunction(tape, Function(y))  # x was not recorded
+
+    def test_tape_function_unsupported_operation(self):
+        from autodiff import array
+
+        with Tape() as tape:
+            x = array.var(np.array([0.5, 1.0]))
+            y = array.var(array.dot(x, x))  # not a scalar instruction
+
+        with self.assertRaisesRegex(ValueError, "Unsupported operation 'dot'"):
+            TapeFunction(tape, Function(y, sources=(x,)))
+
+    def test_tape_save_load(self):
+        with Tape() as tape:
+            x = var(0.5)
+            w = var(2.0)
+            y = var(w * sin(x) + x * x - 3.0)
+
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "f.tape")
+            tape.save(path, Function(y, sources=(x, w)))
+            f = Tape.load(path)
+            g = TapeFunction.load(path)
+
+        x, w = f.sources
+        y, = f.targets
+        assert np.isclose(y(), 2.0 * np.sin(0.5) + 0.25 - 3.0)
+        assert f.instructions == g.instructions
+
+        x.set(1.5)
+        f.evaluate()
+        assert np.isclose(y(), 2.0 * np.sin(1.5) + 2.25 - 3.0)
+        f.pull_gradient_at(y)
+        assert np.isclose(d(x), 2.0 * np.cos(1.5) + 3.0)
+        assert np.isclose(d(w), np.sin(1.5))
+        f.hvp(y, {x: 1.0})
+        assert np.isclose(d(x), -2.0 * np.sin(1.5) + 2.0)
+        assert np.isclose(d(w), np.cos(1.5))
+
+        # a loaded function saves its instructions and current sources
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "g.tape")
+            f.save(path)
+            y, = TapeFunction.load(path).targets
+        assert np.isclose(y(), 2.0 * np.sin(1.5) + 2.25 - 3.0)
+
+    def test_tape_load_untrusted(self):
+        sin_ = 13  # opcode of sin
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "f.tape")
+            write_tape(path, [(sin_, 0, 0, 1)], [(0, 2.0)], [], [1])
+            y, = Tape.load(path).targets
+            assert np.isclose(y(), np.sin(2.0))
+
+            for arguments in [
+                    ([(sin_, 0, 0, 1)], [(0, 2.0)], [], [1], None, b"ADTAPE01"),
+                    ([(99, 0, 0, 1)], [(0, 2.0)], [], [1]),     # opcode
+                    ([(sin_, 0, 0, 7)], [(0, 2.0)], [], [1], 2),  # slot
+                    ([(sin_, 0, 0, 1)], [(0, 2.0)], [], [5], 2),
+                    ([(sin_, 0, 0, 1)], [(0, 2.0)], [], [])]:     # no targets
+                write_tape(path, *arguments)
+                with self.assertRaises(RuntimeError):
+                    Tape.load(path)
+
+            write_tape(path, [(sin_, 0, 0, 1)], [(0, 2.0)], [], [1])
+            with open(path, "r+b") as file:
+                file.truncate(os.path.getsize(path) - 4)  # truncated
+            with self.assertRaises(RuntimeError):
+                Tape.load(path)
+
 if __name__ == '__main__':
     unittest.main()